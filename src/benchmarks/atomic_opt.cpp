@@ -0,0 +1,78 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "atomic_opt.h"
+#include <benchmark/benchmark.h>
+#include <mutex>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+
+  // "latest value or nothing" slot shared by all benchmark threads; even threads publish, odd ones consume
+  struct mutex_slot {
+    std::mutex m;
+    opt_long value;
+
+    void store(opt_long v)
+    {
+      std::lock_guard lock{m};
+      value = v;
+    }
+    opt_long take()
+    {
+      std::lock_guard lock{m};
+      auto v = value;
+      value.reset();
+      return v;
+    }
+  };
+
+  struct atomic_slot {
+    atomic_opt<long, opt_null_value_policy<long, -1>> value;
+
+    void store(opt_long v) { value.store(v, std::memory_order_release); }
+    opt_long take() { return value.take(std::memory_order_acq_rel); }
+  };
+
+  template<typename Slot>
+  void hand_off(benchmark::State& state)
+  {
+    static Slot slot;
+    const bool producer = state.thread_index() % 2 == 0;
+    long i = 0, taken = 0;
+    for(auto _ : state) {
+      if(producer)
+        slot.store(opt_long{++i});
+      else
+        taken += slot.take().has_value();
+    }
+    benchmark::DoNotOptimize(taken);
+    state.SetItemsProcessed(state.iterations());
+  }
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(hand_off, mutex_slot)->Name("hand_off/mutex")->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(hand_off, atomic_slot)->Name("hand_off/atomic_opt")->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,87 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "niche_expected.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <system_error>
+#include <variant>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using expected_double = niche_expected<double, std::errc, opt_nan_policy<double>>;
+  using variant_double = std::variant<double, std::errc>;
+
+  // ~10% of errors
+  template<typename Result, typename Error>
+  std::vector<Result> make_column(std::size_t size, Error make_error)
+  {
+    std::mt19937 gen{42};
+    std::bernoulli_distribution error{0.1};
+    std::vector<Result> v;
+    v.reserve(size);
+    for(std::size_t i = 0; i < size; ++i) {
+      if(error(gen))
+        v.emplace_back(make_error());
+      else
+        v.emplace_back(static_cast<double>(i % 100));
+    }
+    return v;
+  }
+
+  void count_expected(benchmark::State& state)
+  {
+    const auto v = make_column<expected_double>(static_cast<std::size_t>(state.range(0)),
+                                                [] { return mp::unexpected{std::errc::invalid_argument}; });
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(const auto& r : v)
+        count += r.value_or(0.0) > 50.0;
+      benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(expected_double)));
+  }
+
+  void count_variant(benchmark::State& state)
+  {
+    const auto v = make_column<variant_double>(static_cast<std::size_t>(state.range(0)),
+                                               [] { return std::errc::invalid_argument; });
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(const auto& r : v) {
+        const auto d = std::get_if<double>(&r);
+        count += d && *d > 50.0;
+      }
+      benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(variant_double)));
+  }
+
+}  // namespace
+
+BENCHMARK(count_expected)->RangeMultiplier(64)->Range(1 << 10, 1 << 24);
+BENCHMARK(count_variant)->RangeMultiplier(64)->Range(1 << 10, 1 << 24);
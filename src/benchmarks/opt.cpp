@@ -0,0 +1,240 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "test_types.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_bool = opt<bool>;
+  using opt_weekday = opt<weekday>;
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_null_type_policy<double, null_floating<double>>>;
+
+  // working set sizes (in bytes of opt<T, Policy> array) that fit in the subsequent levels of memory hierarchy
+  constexpr std::int64_t working_set_l1 = 16 * 1024;
+  constexpr std::int64_t working_set_l2 = 256 * 1024;
+  constexpr std::int64_t working_set_l3 = 4 * 1024 * 1024;
+  constexpr std::int64_t working_set_dram = 256 * 1024 * 1024;
+
+  // the same number of elements is used for both opt<T, Policy> and std::optional<T> so the latter
+  // may spill over to the next level of memory hierarchy
+  template<typename T>
+  void working_sets(benchmark::internal::Benchmark* b)
+  {
+    using opt_type = typename T::opt_type;
+    for(auto bytes : {working_set_l1, working_set_l2, working_set_l3, working_set_dram})
+      b->Arg(bytes / static_cast<std::int64_t>(sizeof(opt_type)));
+  }
+
+  template<typename T>
+  struct make_value;
+
+  template<>
+  struct make_value<bool> {
+    static bool get(std::size_t i) { return i % 2 != 0; }
+  };
+  template<>
+  struct make_value<weekday> {
+    static weekday get(std::size_t i) { return weekday{static_cast<weekday::underlying_type>(i % 7)}; }
+  };
+  template<>
+  struct make_value<long> {
+    static long get(std::size_t i) { return static_cast<long>(i); }
+  };
+  template<>
+  struct make_value<double> {
+    static double get(std::size_t i) { return static_cast<double>(i) + 0.5; }
+  };
+
+  // benchmarked type along with the opt<T, Policy> it is compared to
+  template<typename Opt, typename Bench = Opt>
+  struct bench_type {
+    using opt_type = Opt;
+    using type = Bench;
+    using value_type = typename Opt::value_type;
+  };
+
+  template<typename Opt>
+  using opt_bench = bench_type<Opt>;
+  template<typename Opt>
+  using std_bench = bench_type<Opt, std::optional<typename Opt::value_type>>;
+
+  // ~25% of empty values with random distribution
+  template<typename T>
+  std::vector<typename T::type> make_data(std::size_t size)
+  {
+    std::mt19937 gen{42};
+    std::bernoulli_distribution empty{0.25};
+    std::vector<typename T::type> v;
+    v.reserve(size);
+    for(std::size_t i = 0; i < size; ++i) {
+      if(empty(gen))
+        v.emplace_back();
+      else
+        v.emplace_back(make_value<typename T::value_type>::get(i));
+    }
+    return v;
+  }
+
+  template<typename T>
+  void set_counters(benchmark::State& state, std::size_t items)
+  {
+    const auto total = static_cast<double>(items);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(items));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(items * sizeof(typename T::type)));
+    state.counters["bytes_per_element"] = sizeof(typename T::type);
+    state.counters["time_per_op"] =
+        benchmark::Counter(total, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  }
+
+  template<typename T>
+  void construct_empty(benchmark::State& state)
+  {
+    for(auto _ : state) {
+      typename T::type o;
+      benchmark::DoNotOptimize(o);
+    }
+    set_counters<T>(state, 1);
+  }
+
+  template<typename T>
+  void construct_value(benchmark::State& state)
+  {
+    auto value = make_value<typename T::value_type>::get(1);
+    for(auto _ : state) {
+      benchmark::DoNotOptimize(value);
+      typename T::type o{value};
+      benchmark::DoNotOptimize(o);
+    }
+    set_counters<T>(state, 1);
+  }
+
+  template<typename T>
+  void has_value(benchmark::State& state)
+  {
+    const auto data = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(const auto& o : data)
+        count += o.has_value();
+      benchmark::DoNotOptimize(count);
+    }
+    set_counters<T>(state, data.size());
+  }
+
+  template<typename T>
+  void value_or(benchmark::State& state)
+  {
+    const auto data = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    const auto def = make_value<typename T::value_type>::get(0);
+    for(auto _ : state) {
+      for(const auto& o : data) {
+        auto v = o.value_or(def);
+        benchmark::DoNotOptimize(v);
+      }
+    }
+    set_counters<T>(state, data.size());
+  }
+
+  template<typename T>
+  void copy(benchmark::State& state)
+  {
+    const auto src = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    auto dst = src;
+    for(auto _ : state) {
+      std::copy(src.begin(), src.end(), dst.begin());
+      benchmark::ClobberMemory();
+    }
+    set_counters<T>(state, src.size());
+  }
+
+  template<typename T>
+  void move(benchmark::State& state)
+  {
+    auto src = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    auto dst = src;
+    for(auto _ : state) {
+      std::move(src.begin(), src.end(), dst.begin());
+      benchmark::ClobberMemory();
+      src.swap(dst);
+    }
+    set_counters<T>(state, src.size());
+  }
+
+  template<typename T>
+  void swap(benchmark::State& state)
+  {
+    auto a = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    auto b = a;
+    std::reverse(b.begin(), b.end());
+    for(auto _ : state) {
+      std::swap_ranges(a.begin(), a.end(), b.begin());
+      benchmark::ClobberMemory();
+    }
+    set_counters<T>(state, a.size());
+  }
+
+  // sequential scan touching the contained values
+  template<typename T>
+  void scan(benchmark::State& state)
+  {
+    const auto data = make_data<T>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(const auto& o : data)
+        if(o) count += (*o == make_value<typename T::value_type>::get(0));
+      benchmark::DoNotOptimize(count);
+    }
+    set_counters<T>(state, data.size());
+  }
+
+}  // namespace
+
+#define OPT_BENCHMARK_SINGLE(func, type)                                         \
+  BENCHMARK_TEMPLATE(func, opt_bench<type>)->Name(#func "/opt/" #type);          \
+  BENCHMARK_TEMPLATE(func, std_bench<type>)->Name(#func "/std::optional/" #type)
+
+#define OPT_BENCHMARK_RANGE(func, type)                                                                      \
+  BENCHMARK_TEMPLATE(func, opt_bench<type>)->Name(#func "/opt/" #type)->Apply(working_sets<opt_bench<type>>); \
+  BENCHMARK_TEMPLATE(func, std_bench<type>)->Name(#func "/std::optional/" #type)->Apply(working_sets<std_bench<type>>)
+
+#define OPT_BENCHMARK_ALL(type)               \
+  OPT_BENCHMARK_SINGLE(construct_empty, type); \
+  OPT_BENCHMARK_SINGLE(construct_value, type); \
+  OPT_BENCHMARK_RANGE(has_value, type);        \
+  OPT_BENCHMARK_RANGE(value_or, type);         \
+  OPT_BENCHMARK_RANGE(copy, type);             \
+  OPT_BENCHMARK_RANGE(move, type);             \
+  OPT_BENCHMARK_RANGE(swap, type);             \
+  OPT_BENCHMARK_RANGE(scan, type)
+
+OPT_BENCHMARK_ALL(opt_bool);
+OPT_BENCHMARK_ALL(opt_weekday);
+OPT_BENCHMARK_ALL(opt_long);
+OPT_BENCHMARK_ALL(opt_double);
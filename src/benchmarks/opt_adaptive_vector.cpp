@@ -0,0 +1,77 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_adaptive_vector.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using opt_long = opt<long, policy>;
+
+  constexpr std::size_t column_size = 1 << 20;
+
+  // state.range(0) is the percentage of empty elements
+  std::vector<opt_long> make_column(const benchmark::State& state)
+  {
+    std::mt19937 gen{42};
+    std::bernoulli_distribution is_null{static_cast<double>(state.range(0)) / 100};
+    std::vector<opt_long> v(column_size);
+    for(std::size_t i = 0; i < v.size(); ++i)
+      if(!is_null(gen)) v[i] = opt_long{static_cast<long>(i)};
+    return v;
+  }
+
+  void sum_vector(benchmark::State& state)
+  {
+    const auto v = make_column(state);
+    for(auto _ : state) {
+      long sum = 0;
+      for(const auto& o : v)
+        if(o) sum += *o;
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+    state.counters["memory_bytes"] = static_cast<double>(v.size() * sizeof(opt_long));
+  }
+
+  void sum_adaptive(benchmark::State& state)
+  {
+    opt_adaptive_vector<long, policy> v;
+    for(const auto& o : make_column(state)) v.push_back(o);
+    for(auto _ : state) {
+      long sum = 0;
+      v.for_each_value([&](std::size_t, long value) { sum += value; });
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+    state.counters["memory_bytes"] = static_cast<double>(v.memory_usage());
+  }
+
+}  // namespace
+
+BENCHMARK(sum_vector)->Arg(1)->Arg(50)->Arg(99)->Arg(100)->Unit(benchmark::kMicrosecond);
+BENCHMARK(sum_adaptive)->Arg(1)->Arg(50)->Arg(99)->Arg(100)->Unit(benchmark::kMicrosecond);
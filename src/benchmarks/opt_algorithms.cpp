@@ -0,0 +1,229 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_algorithms.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_int8 = opt<std::int8_t, opt_null_value_policy<std::int8_t, -128>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  // ~10% of empty values
+  template<typename Opt>
+  std::vector<Opt> make_column(std::size_t size)
+  {
+    std::mt19937 gen{42};
+    std::bernoulli_distribution empty{0.1};
+    std::vector<Opt> v(size);
+    for(std::size_t i = 0; i < size; ++i)
+      if(!empty(gen)) v[i] = static_cast<typename Opt::value_type>(i % 100);
+    return v;
+  }
+
+  template<typename Opt>
+  void set_counters(benchmark::State& state, std::size_t items)
+  {
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(items));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(items * sizeof(Opt)));
+  }
+
+  template<typename Opt>
+  void count_values_loop(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(const auto& o : v)
+        count += o.has_value();
+      benchmark::DoNotOptimize(count);
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void count_values_bulk(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state)
+      benchmark::DoNotOptimize(count_values(std::span{v}));
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void find_first_null_loop(benchmark::State& state)
+  {
+    // worst case - the only null at the end
+    auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto& o : v)
+      if(!o) o = 1;
+    v.back().reset();
+    for(auto _ : state) {
+      std::size_t i = 0;
+      while(v[i].has_value()) ++i;
+      benchmark::DoNotOptimize(i);
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void find_first_null_bulk(benchmark::State& state)
+  {
+    auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto& o : v)
+      if(!o) o = 1;
+    v.back().reset();
+    for(auto _ : state)
+      benchmark::DoNotOptimize(find_first_null(std::span{v}));
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void value_or_into_loop(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<typename Opt::value_type> out(v.size());
+    for(auto _ : state) {
+      for(std::size_t i = 0; i < v.size(); ++i)
+        out[i] = v[i].value_or(0);
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void value_or_into_bulk(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<typename Opt::value_type> out(v.size());
+    for(auto _ : state) {
+      value_or_into(std::span{v}, std::span{out}, 0);
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void replace_nulls_bulk(benchmark::State& state)
+  {
+    const auto orig = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    auto v = orig;
+    for(auto _ : state) {
+      replace_nulls(std::span{v}, 0);
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void to_validity_bitmap_loop(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> bitmap((v.size() + 7) / 8);
+    for(auto _ : state) {
+      std::fill(bitmap.begin(), bitmap.end(), 0);
+      for(std::size_t i = 0; i < v.size(); ++i)
+        if(v[i].has_value()) bitmap[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void to_validity_bitmap_bulk(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> bitmap((v.size() + 7) / 8);
+    for(auto _ : state) {
+      to_validity_bitmap(std::span{v}, std::span{bitmap});
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void from_validity_bitmap_bulk(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> bitmap((v.size() + 7) / 8);
+    to_validity_bitmap(std::span{v}, std::span{bitmap});
+    const auto values = as_values(std::span{v});
+    std::vector<Opt> out(v.size());
+    for(auto _ : state) {
+      from_validity_bitmap(values, std::span{bitmap}, std::span{out});
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void hash_loop(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::size_t> out(v.size());
+    for(auto _ : state) {
+      for(std::size_t i = 0; i < v.size(); ++i)
+        out[i] = std::hash<Opt>{}(v[i]);
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+  template<typename Opt>
+  void hash_many_bulk(benchmark::State& state)
+  {
+    const auto v = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::size_t> out(v.size());
+    for(auto _ : state) {
+      hash_many(std::span{v}, std::span{out});
+      benchmark::ClobberMemory();
+    }
+    set_counters<Opt>(state, v.size());
+  }
+
+}  // namespace
+
+#define OPT_ALGORITHMS_BENCHMARK(func, type) \
+  BENCHMARK_TEMPLATE(func, type)->Name(#func "/" #type)->RangeMultiplier(64)->Range(1 << 10, 1 << 26)
+
+OPT_ALGORITHMS_BENCHMARK(count_values_loop, opt_long);
+OPT_ALGORITHMS_BENCHMARK(count_values_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(count_values_loop, opt_int8);
+OPT_ALGORITHMS_BENCHMARK(count_values_bulk, opt_int8);
+OPT_ALGORITHMS_BENCHMARK(count_values_loop, opt_double);
+OPT_ALGORITHMS_BENCHMARK(count_values_bulk, opt_double);
+OPT_ALGORITHMS_BENCHMARK(find_first_null_loop, opt_long);
+OPT_ALGORITHMS_BENCHMARK(find_first_null_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(value_or_into_loop, opt_long);
+OPT_ALGORITHMS_BENCHMARK(value_or_into_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(replace_nulls_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(to_validity_bitmap_loop, opt_long);
+OPT_ALGORITHMS_BENCHMARK(to_validity_bitmap_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(from_validity_bitmap_bulk, opt_long);
+OPT_ALGORITHMS_BENCHMARK(hash_loop, opt_long);
+OPT_ALGORITHMS_BENCHMARK(hash_many_bulk, opt_long);
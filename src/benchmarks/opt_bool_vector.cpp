@@ -0,0 +1,91 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_bool_vector.h"
+#include "test_types.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_bool = opt<bool>;
+
+  std::vector<opt_bool> make(std::size_t size, unsigned seed)
+  {
+    std::mt19937 gen{seed};
+    std::uniform_int_distribution<int> dist{0, 2};
+    std::vector<opt_bool> v(size);
+    for(auto& o : v)
+      if(const auto d = dist(gen); d < 2) o = opt_bool{d == 1};
+    return v;
+  }
+
+  opt_bool kleene_and(opt_bool a, opt_bool b)
+  {
+    if((a.has_value() && !*a) || (b.has_value() && !*b)) return opt_bool{false};
+    if(a.has_value() && b.has_value()) return opt_bool{true};
+    return opt_bool{};
+  }
+  opt_bool kleene_or(opt_bool a, opt_bool b)
+  {
+    if((a.has_value() && *a) || (b.has_value() && *b)) return opt_bool{true};
+    if(a.has_value() && b.has_value()) return opt_bool{false};
+    return opt_bool{};
+  }
+  opt_bool kleene_not(opt_bool a) { return a.has_value() ? opt_bool{!*a} : opt_bool{}; }
+
+  // a AND (b OR NOT c) evaluated row by row
+  void predicate_rows(benchmark::State& state)
+  {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const auto a = make(size, 1), b = make(size, 2), c = make(size, 3);
+    std::vector<opt_bool> r(size);
+    for(auto _ : state) {
+      for(std::size_t i = 0; i < size; ++i) r[i] = kleene_and(a[i], kleene_or(b[i], kleene_not(c[i])));
+      benchmark::DoNotOptimize(r.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // a AND (b OR NOT c) evaluated 64 rows at a time
+  void predicate_packed(benchmark::State& state)
+  {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const opt_bool_vector<> a{make(size, 1)}, b{make(size, 2)}, c{make(size, 3)};
+    opt_bool_vector<> r;
+    for(auto _ : state) {
+      r = c;
+      r.flip();
+      r |= b;
+      r &= a;
+      benchmark::DoNotOptimize(r.values().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+BENCHMARK(predicate_rows)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(predicate_packed)->Arg(1 << 12)->Arg(1 << 20);
@@ -0,0 +1,89 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_bounded.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using percent = opt_bounded<0, 100>;
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+
+  std::vector<opt_int> make(std::size_t size)
+  {
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{-1, 100};
+    std::vector<opt_int> v(size);
+    for(auto& o : v)
+      if(const auto d = dist(gen); d >= 0) o = d;
+    return v;
+  }
+
+  template<typename Opt>
+  void sum_column(benchmark::State& state)
+  {
+    const auto wide = make(static_cast<std::size_t>(state.range(0)));
+    std::vector<Opt> v(wide.size());
+    for(std::size_t i = 0; i < wide.size(); ++i)
+      if(wide[i]) v[i] = *wide[i];
+    for(auto _ : state) {
+      long sum = 0;
+      for(const auto& o : v) sum += o ? static_cast<int>(*o) : 0;
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(Opt)));
+  }
+
+  void widen_percent(benchmark::State& state)
+  {
+    std::vector<percent> in(static_cast<std::size_t>(state.range(0)));
+    narrow(std::span<const opt_int>{make(in.size())}, std::span{in});
+    std::vector<opt_int> out(in.size());
+    for(auto _ : state) {
+      widen(std::span<const percent>{in}, std::span{out});
+      benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void narrow_percent(benchmark::State& state)
+  {
+    const auto in = make(static_cast<std::size_t>(state.range(0)));
+    std::vector<percent> out(in.size());
+    for(auto _ : state) {
+      narrow(std::span{in}, std::span{out});
+      benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(sum_column, opt_int)->Arg(1 << 12)->Arg(1 << 24);
+BENCHMARK_TEMPLATE(sum_column, percent)->Arg(1 << 12)->Arg(1 << 24);
+BENCHMARK(widen_percent)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(narrow_percent)->Arg(1 << 12)->Arg(1 << 20);
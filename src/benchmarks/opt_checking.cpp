@@ -0,0 +1,76 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  template<opt_checking Mode>
+  struct checking_policy {
+    static constexpr int null_value() noexcept { return -1; }
+    static constexpr opt_checking checking = Mode;
+  };
+
+  // sum of value() of not empty elements; a check that may throw or trap stays in the loop, opt_checking::assume
+  // drops it (GCC before 13 has no assume attribute and its `if(!cond) __builtin_unreachable()` hint is removed
+  // only after vectorization, so the loop stays scalar) and opt_checking::assertion does not check with NDEBUG
+  template<opt_checking Mode>
+  void sum_value(benchmark::State& state)
+  {
+    using opt_int = opt<int, checking_policy<Mode>>;
+    std::vector<opt_int> v(static_cast<std::size_t>(state.range(0)));
+    for(std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<int>(i % 100);
+    for(auto _ : state) {
+      int sum = 0;
+      for(const auto& o : v) sum += o.value();
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void sum_raw(benchmark::State& state)
+  {
+    std::vector<int> v(static_cast<std::size_t>(state.range(0)));
+    for(std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<int>(i % 100);
+    for(auto _ : state) {
+      int sum = std::accumulate(v.begin(), v.end(), 0);
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+[[noreturn]] void mp::opt_check_failed() { std::abort(); }
+
+BENCHMARK_TEMPLATE(sum_value, opt_checking::standard)->Name("sum_value/standard")->Arg(4096);
+BENCHMARK_TEMPLATE(sum_value, opt_checking::trap)->Name("sum_value/trap")->Arg(4096);
+BENCHMARK_TEMPLATE(sum_value, opt_checking::callback)->Name("sum_value/callback")->Arg(4096);
+BENCHMARK_TEMPLATE(sum_value, opt_checking::assume)->Name("sum_value/assume")->Arg(4096);
+BENCHMARK_TEMPLATE(sum_value, opt_checking::assertion)->Name("sum_value/assertion")->Arg(4096);
+BENCHMARK(sum_raw)->Arg(4096);
@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "opt.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  // random values with 50% of nulls
+  template<typename Opt>
+  std::vector<Opt> make_column(std::size_t size)
+  {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<long> dist{0, 1'000'000};
+    std::vector<Opt> column(size);
+    for(auto& v : column)
+      if(gen() & 1) v = static_cast<typename Opt::value_type>(dist(gen));
+    return column;
+  }
+
+  struct three_way_less {
+    template<typename Opt>
+    bool operator()(const Opt& lhs, const Opt& rhs) const
+    {
+      return (lhs <=> rhs) < 0;
+    }
+  };
+
+  template<typename Opt, typename Compare>
+  void sort_column(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    std::vector<Opt> v;
+    for(auto _ : state) {
+      v = column;
+      std::sort(v.begin(), v.end(), Compare{});
+      benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // the result of each comparison is consumed without branches
+  template<typename Opt, typename Compare>
+  void count_ascending(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    const Compare less;
+    for(auto _ : state) {
+      std::size_t count = 0;
+      for(std::size_t i = 1; i < column.size(); ++i) count += less(column[i - 1], column[i]);
+      benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename Opt, typename Compare>
+  void max_element_column(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      auto it = std::max_element(column.begin(), column.end(), Compare{});
+      benchmark::DoNotOptimize(it);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(sort_column, opt_long, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(sort_column, opt_long, std::less<>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(sort_column, opt_long, three_way_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(sort_column, opt_double, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(sort_column, opt_double, std::less<>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(sort_column, opt_double, three_way_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(count_ascending, opt_long, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(count_ascending, opt_long, std::less<>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(count_ascending, opt_double, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(count_ascending, opt_double, std::less<>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(max_element_column, opt_long, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(max_element_column, opt_long, std::less<>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(max_element_column, opt_double, opt_branchless_less)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(max_element_column, opt_double, std::less<>)->Arg(1 << 16);
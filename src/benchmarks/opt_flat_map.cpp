@@ -0,0 +1,115 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_flat_map.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using flat_map = opt_flat_map<long, long, opt_null_value_policy<long, -1>>;
+  using std_map = std::unordered_map<long, long>;
+
+  constexpr std::size_t lookups = 1 << 12;
+
+  // `size` random keys inserted to the map and `lookups` keys to find with ~50% hit ratio
+  template<typename Map>
+  std::pair<Map, std::vector<long>> make_map(std::size_t size)
+  {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<long> key{0, std::numeric_limits<long>::max()};
+    Map m;
+    std::vector<long> inserted(size);
+    for(auto& k : inserted) {
+      k = key(gen);
+      m[k] = k;
+    }
+    std::vector<long> keys(lookups);
+    std::uniform_int_distribution<std::size_t> index{0, size - 1};
+    for(std::size_t i = 0; i < lookups; ++i)
+      keys[i] = i % 2 ? key(gen) : inserted[index(gen)];
+    return {std::move(m), std::move(keys)};
+  }
+
+  template<typename Map>
+  void find(benchmark::State& state)
+  {
+    const auto [m, keys] = make_map<Map>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      long sum = 0;
+      for(auto k : keys) {
+        const auto it = m.find(k);
+        if(it != m.end()) sum += it->second;
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(lookups));
+  }
+
+  void find_many(benchmark::State& state)
+  {
+    const auto [m, keys] = make_map<flat_map>(static_cast<std::size_t>(state.range(0)));
+    // results are consumed in small batches while the prefetched values are still in cache
+    constexpr std::size_t batch = 64;
+    const long* results[batch];
+    for(auto _ : state) {
+      long sum = 0;
+      for(std::size_t i = 0; i < keys.size(); i += batch) {
+        m.find_many(std::span{keys}.subspan(i, batch), results);
+        for(auto r : results)
+          if(r) sum += *r;
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(lookups));
+  }
+
+  template<typename Map>
+  void insert(benchmark::State& state)
+  {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::mt19937_64 gen{42};
+    std::vector<long> keys(size);
+    for(auto& k : keys)
+      k = static_cast<long>(gen() >> 1);
+    for(auto _ : state) {
+      Map m;
+      for(auto k : keys)
+        m[k] = k;
+      benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size));
+  }
+
+}  // namespace
+
+#define OPT_FLAT_MAP_BENCHMARK(...) BENCHMARK(__VA_ARGS__)->RangeMultiplier(16)->Range(1 << 8, 1 << 22)
+
+OPT_FLAT_MAP_BENCHMARK(find<std_map>)->Name("find/std::unordered_map");
+OPT_FLAT_MAP_BENCHMARK(find<flat_map>)->Name("find/opt_flat_map");
+OPT_FLAT_MAP_BENCHMARK(find_many)->Name("find_many/opt_flat_map");
+OPT_FLAT_MAP_BENCHMARK(insert<std_map>)->Name("insert/std::unordered_map");
+OPT_FLAT_MAP_BENCHMARK(insert<flat_map>)->Name("insert/opt_flat_map");
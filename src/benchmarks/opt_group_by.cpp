@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_group_by.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  // `cardinality` random keys with 10% of nulls and measures with 30% of nulls
+  struct rows {
+    std::vector<opt_long> keys;
+    std::vector<opt_double> measures;
+
+    rows(std::size_t size, long cardinality) : keys(size), measures(size)
+    {
+      std::mt19937_64 gen{42};
+      std::uniform_int_distribution<long> key_dist{0, cardinality - 1};
+      std::uniform_real_distribution<double> measure_dist{0, 1000};
+      for(std::size_t i = 0; i < size; ++i) {
+        if(gen() % 10 != 0) keys[i] = key_dist(gen);
+        if(gen() % 10 >= 3) measures[i] = measure_dist(gen);
+      }
+    }
+  };
+
+  constexpr std::size_t row_count = 1 << 22;
+
+  void group_by_unordered_map(benchmark::State& state)
+  {
+    struct group {
+      std::size_t rows = 0;
+      std::size_t count = 0;
+      double sum = 0;
+      double min = 0;
+      double max = 0;
+    };
+    const rows data{row_count, state.range(0)};
+    for(auto _ : state) {
+      std::unordered_map<long, group> groups;
+      group null_group;
+      for(std::size_t i = 0; i < row_count; ++i) {
+        auto& g = data.keys[i].has_value() ? groups[*data.keys[i]] : null_group;
+        ++g.rows;
+        if(!data.measures[i].has_value()) continue;
+        const double x = *data.measures[i];
+        g.min = g.count == 0 ? x : std::min(g.min, x);
+        g.max = g.count == 0 ? x : std::max(g.max, x);
+        g.sum += x;
+        ++g.count;
+      }
+      benchmark::DoNotOptimize(groups.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(row_count));
+  }
+
+  // 0 threads uses all hardware threads
+  template<unsigned Threads>
+  void group_by_opt(benchmark::State& state)
+  {
+    const rows data{row_count, state.range(0)};
+    for(auto _ : state) {
+      opt_group_by<opt_long, opt_double> groups;
+      groups.add(data.keys, data.measures, Threads);
+      benchmark::DoNotOptimize(groups.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(row_count));
+  }
+
+}  // namespace
+
+BENCHMARK(group_by_unordered_map)->Arg(16)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(group_by_opt, 1)->Arg(16)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(group_by_opt, 0)->Arg(16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,97 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_mmap_array.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using opt_long = opt<long, policy>;
+
+  // column of `size` elements with every 8th one empty, written once per size
+  std::filesystem::path column_file(std::size_t size)
+  {
+    auto path = std::filesystem::temp_directory_path() / ("opt_mmap_array_bench_" + std::to_string(size) + ".bin");
+    if(!std::filesystem::exists(path)) {
+      std::vector<opt_long> values(size);
+      for(std::size_t i = 0; i < size; ++i)
+        if(i % 8) values[i] = opt_long{static_cast<long>(i)};
+      opt_mmap_array<long, policy>::save(path, values);
+    }
+    return path;
+  }
+
+  // reads the file and reconstructs every element
+  void load_stream(benchmark::State& state)
+  {
+    const auto path = column_file(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      std::ifstream file{path, std::ios::binary};
+      opt_mmap_header h;
+      file.read(reinterpret_cast<char*>(&h), sizeof(h));
+      std::vector<opt_long> values;
+      values.reserve(h.count);
+      for(std::uint64_t i = 0; i < h.count; ++i) {
+        long v;
+        file.read(reinterpret_cast<char*>(&v), sizeof(v));
+        values.push_back(v == -1 ? opt_long{} : opt_long{v});
+      }
+      benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // maps the file; elements are not touched
+  void load_mmap(benchmark::State& state)
+  {
+    const auto path = column_file(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      opt_mmap_array<long, policy> a{path};
+      benchmark::DoNotOptimize(a.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // maps the file and reads every element
+  void load_mmap_scan(benchmark::State& state)
+  {
+    const auto path = column_file(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      opt_mmap_array<long, policy> a{path};
+      long sum = 0;
+      for(const auto& o : a) sum += o.value_or(0);
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+BENCHMARK(load_stream)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+BENCHMARK(load_mmap)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+BENCHMARK(load_mmap_scan)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
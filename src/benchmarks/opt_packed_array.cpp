@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_algorithms.h"
+#include "opt_packed_array.h"
+#include "test_types.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  std::vector<opt<weekday>> make_weekdays(std::size_t size)
+  {
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{0, 7};
+    std::vector<opt<weekday>> v(size);
+    for(auto& o : v)
+      if(const auto d = dist(gen); d < 7) o = weekday{static_cast<weekday::underlying_type>(d)};
+    return v;
+  }
+
+  void set_counters(benchmark::State& state, std::size_t bytes)
+  {
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_element"] = static_cast<double>(bytes) / static_cast<double>(state.range(0));
+  }
+
+  void count_values_unpacked(benchmark::State& state)
+  {
+    const auto v = make_weekdays(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) benchmark::DoNotOptimize(count_values(std::span{v}));
+    set_counters(state, v.size() * sizeof(opt<weekday>));
+  }
+
+  void count_values_packed(benchmark::State& state)
+  {
+    const opt_packed_array<weekday> a{make_weekdays(static_cast<std::size_t>(state.range(0)))};
+    for(auto _ : state) benchmark::DoNotOptimize(a.count_values());
+    set_counters(state, a.words().size_bytes());
+  }
+
+  void find_unpacked(benchmark::State& state)
+  {
+    auto v = make_weekdays(static_cast<std::size_t>(state.range(0)));
+    std::replace(v.begin(), v.end(), opt<weekday>{weekday{6}}, opt<weekday>{weekday{5}});
+    for(auto _ : state) benchmark::DoNotOptimize(std::find(v.begin(), v.end(), opt<weekday>{weekday{6}}));
+    set_counters(state, v.size() * sizeof(opt<weekday>));
+  }
+
+  void find_packed(benchmark::State& state)
+  {
+    auto v = make_weekdays(static_cast<std::size_t>(state.range(0)));
+    std::replace(v.begin(), v.end(), opt<weekday>{weekday{6}}, opt<weekday>{weekday{5}});
+    const opt_packed_array<weekday> a{v};
+    for(auto _ : state) benchmark::DoNotOptimize(a.find(weekday{6}));
+    set_counters(state, a.words().size_bytes());
+  }
+
+  void unpack(benchmark::State& state)
+  {
+    const opt_packed_array<weekday> a{make_weekdays(static_cast<std::size_t>(state.range(0)))};
+    std::vector<opt<weekday>> out(a.size());
+    for(auto _ : state) {
+      a.unpack(out);
+      benchmark::DoNotOptimize(out.data());
+    }
+    set_counters(state, a.words().size_bytes());
+  }
+
+}  // namespace
+
+BENCHMARK(count_values_unpacked)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(count_values_packed)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(find_unpacked)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(find_packed)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(unpack)->Arg(1 << 12)->Arg(1 << 20);
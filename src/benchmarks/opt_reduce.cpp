@@ -0,0 +1,107 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_reduce.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  // random values with 50% of nulls
+  template<typename Opt>
+  std::vector<Opt> make_column(std::size_t size)
+  {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<long> dist{0, 1'000'000};
+    std::vector<Opt> column(size);
+    for(auto& v : column)
+      if(gen() & 1) v = static_cast<typename Opt::value_type>(dist(gen)) / 3;
+    return column;
+  }
+
+  template<typename Opt>
+  void sum_loop(benchmark::State& state)
+  {
+    using sum_type = detail::reduce_sum_t<typename Opt::value_type>;
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      sum_type sum{};
+      for(const auto& v : column)
+        if(v.has_value()) sum += *v;
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  // 0 threads uses all hardware threads
+  template<typename Opt, unsigned Threads>
+  void sum_reduce(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) benchmark::DoNotOptimize(opt_reduce_sum(std::span{column}, Threads));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename Opt>
+  void min_max_loop(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      Opt min, max;
+      for(const auto& v : column) {
+        if(!v.has_value()) continue;
+        if(!min.has_value() || *v < *min) min = *v;
+        if(!max.has_value() || *max < *v) max = *v;
+      }
+      benchmark::DoNotOptimize(min);
+      benchmark::DoNotOptimize(max);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename Opt, unsigned Threads>
+  void all_reduce(benchmark::State& state)
+  {
+    const auto column = make_column<Opt>(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) benchmark::DoNotOptimize(opt_reduce(std::span{column}, Threads));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(sum_loop, opt_long)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(sum_reduce, opt_long, 1)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(sum_reduce, opt_long, 0)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(min_max_loop, opt_long)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(all_reduce, opt_long, 1)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(sum_loop, opt_double)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(sum_reduce, opt_double, 1)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(sum_reduce, opt_double, 0)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(min_max_loop, opt_double)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(all_reduce, opt_double, 1)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,119 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_ring.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace {
+
+  using namespace mp;
+
+  using long_policy = opt_null_value_policy<long, -1>;
+  constexpr std::size_t ring_size = 1024;
+
+  // single-producer single-consumer queue in which every slot carries a sequence number in addition to the value
+  // (the lap for which it may be written or read)
+  template<typename T, std::size_t N>
+  class sequence_queue {
+  public:
+    sequence_queue()
+    {
+      for(std::size_t i = 0; i < N; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    std::size_t try_push_n(std::span<const T> values)
+    {
+      const auto pos = head_.load(std::memory_order_relaxed);
+      std::size_t count = 0;
+      for(; count < values.size(); ++count) {
+        auto& s = slots_[(pos + count) & (N - 1)];
+        if(s.seq.load(std::memory_order_acquire) != pos + count) break;
+        s.value = values[count];
+        s.seq.store(pos + count + 1, std::memory_order_release);
+      }
+      head_.store(pos + count, std::memory_order_relaxed);
+      return count;
+    }
+
+    std::size_t try_pop_n(std::span<T> out)
+    {
+      const auto pos = tail_.load(std::memory_order_relaxed);
+      std::size_t count = 0;
+      for(; count < out.size(); ++count) {
+        auto& s = slots_[(pos + count) & (N - 1)];
+        if(s.seq.load(std::memory_order_acquire) != pos + count + 1) break;
+        out[count] = s.value;
+        s.seq.store(pos + count + N, std::memory_order_release);
+      }
+      tail_.store(pos + count, std::memory_order_relaxed);
+      return count;
+    }
+
+  private:
+    struct slot {
+      std::atomic<std::size_t> seq;
+      T value;
+    };
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::array<slot, N> slots_;
+  };
+
+  // thread 0 produces and thread 1 consumes batches of up to Batch elements; items are counted only for successful
+  // operations
+  template<typename Queue, std::size_t Batch>
+  void throughput(benchmark::State& state)
+  {
+    static Queue queue;
+    const bool producer = state.thread_index() == 0;
+    std::array<long, Batch> buf{};
+    long sum = 0;
+    std::size_t items = 0;
+    for(auto _ : state) {
+      if(producer) {
+        for(auto& b : buf) b = static_cast<long>(items);
+        items += queue.try_push_n(buf);
+      }
+      else {
+        const auto n = queue.try_pop_n(buf);
+        for(std::size_t i = 0; i < n; ++i) sum += buf[i];
+        items += n;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(static_cast<std::int64_t>(items));
+  }
+
+  using sequence = sequence_queue<long, ring_size>;
+  using ring = opt_ring<long, long_policy, ring_size>;
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(throughput, sequence, 1)->Name("queue/sequence")->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(throughput, ring, 1)->Name("queue/opt_ring")->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(throughput, sequence, 16)->Name("queue/sequence_batch16")->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(throughput, ring, 16)->Name("queue/opt_ring_batch16")->Threads(2)->UseRealTime();
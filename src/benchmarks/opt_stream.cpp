@@ -0,0 +1,96 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_stream.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using opt_long = opt<long, policy>;
+
+  constexpr std::size_t column_size = 1 << 20;
+  constexpr std::size_t chunk_size = 4096;
+
+  // state.range(0) is the percentage of empty elements
+  std::vector<opt_long> make_column(const benchmark::State& state)
+  {
+    std::mt19937 gen{42};
+    std::bernoulli_distribution is_null{static_cast<double>(state.range(0)) / 100};
+    std::vector<opt_long> v(column_size);
+    for(std::size_t i = 0; i < v.size(); ++i)
+      if(!is_null(gen)) v[i] = opt_long{static_cast<long>(i)};
+    return v;
+  }
+
+  std::vector<std::byte> encode(std::span<const opt_long> column)
+  {
+    opt_stream_writer<long, policy> writer;
+    std::vector<std::byte> out;
+    for(std::size_t i = 0; i < column.size(); i += chunk_size) writer.write(column.subspan(i, chunk_size), out);
+    writer.flush(out);
+    return out;
+  }
+
+  void set_counters(benchmark::State& state, std::size_t encoded_size)
+  {
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * column_size * sizeof(opt_long)));
+    state.counters["bytes_per_element"] = static_cast<double>(encoded_size) / column_size;
+  }
+
+  void stream_encode(benchmark::State& state)
+  {
+    const auto column = make_column(state);
+    opt_stream_writer<long, policy> writer;
+    std::vector<std::byte> out;
+    out.reserve(column_size * sizeof(opt_long) * 2);
+    for(auto _ : state) {
+      out.clear();
+      for(std::size_t i = 0; i < column.size(); i += chunk_size)
+        writer.write(std::span{column}.subspan(i, chunk_size), out);
+      writer.flush(out);
+      benchmark::DoNotOptimize(out.data());
+    }
+    set_counters(state, out.size());
+  }
+
+  void stream_decode(benchmark::State& state)
+  {
+    const auto stream = encode(make_column(state));
+    std::vector<opt_long> chunk(chunk_size);
+    for(auto _ : state) {
+      opt_stream_reader<long, policy> reader;
+      std::span<const std::byte> in{stream};
+      while(reader.read(in, chunk) > 0) benchmark::DoNotOptimize(chunk.data());
+    }
+    set_counters(state, stream.size());
+  }
+
+}  // namespace
+
+BENCHMARK(stream_encode)->Arg(1)->Arg(50)->Arg(99)->Unit(benchmark::kMicrosecond);
+BENCHMARK(stream_decode)->Arg(1)->Arg(50)->Arg(99)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_table.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using policy = opt_null_value_policy<int, -1>;
+
+  // built by the compiler
+  constexpr auto retries_table = make_opt_table<int, policy, 600>({{408, 2}, {429, 5}, {500, 1}, {502, 2}, {503, 3}});
+
+  std::vector<int> make_codes()
+  {
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{100, 599};
+    std::vector<int> codes(4096);
+    for(auto& c : codes) c = dist(gen);
+    return codes;
+  }
+
+  void lookup_table(benchmark::State& state)
+  {
+    const auto codes = make_codes();
+    for(auto _ : state) {
+      int sum = 0;
+      for(auto c : codes) sum += retries_table[static_cast<std::size_t>(c)].value_or(0);
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(codes.size()));
+  }
+
+  // filled at startup
+  void lookup_unordered_map(benchmark::State& state)
+  {
+    const std::unordered_map<int, int> retries{{408, 2}, {429, 5}, {500, 1}, {502, 2}, {503, 3}};
+    const auto codes = make_codes();
+    for(auto _ : state) {
+      int sum = 0;
+      for(auto c : codes)
+        if(const auto it = retries.find(c); it != retries.end()) sum += it->second;
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(codes.size()));
+  }
+
+}  // namespace
+
+BENCHMARK(lookup_table);
+BENCHMARK(lookup_unordered_map);
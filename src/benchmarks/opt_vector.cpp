@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_vector.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  using std_vector = std::vector<opt_int>;
+  using mp_vector = opt_vector<int, opt_null_value_policy<int, -1>>;
+
+  template<typename Vector>
+  void resize_grow(benchmark::State& state)
+  {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for(auto _ : state) {
+      Vector v;
+      v.resize(size / 4);
+      v.resize(size);
+      benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename Vector>
+  void push_back_grow(benchmark::State& state)
+  {
+    const auto size = static_cast<int>(state.range(0));
+    for(auto _ : state) {
+      Vector v;
+      for(int i = 0; i < size; ++i) v.push_back(opt_int{i});
+      benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template<typename Vector>
+  void insert_erase_front(benchmark::State& state)
+  {
+    Vector v(static_cast<std::size_t>(state.range(0)));
+    for(auto _ : state) {
+      v.insert(v.begin(), opt_int{1});
+      v.erase(v.begin());
+      benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(resize_grow, std_vector)->Name("resize_grow/std::vector")->Arg(10'000'000);
+BENCHMARK_TEMPLATE(resize_grow, mp_vector)->Name("resize_grow/opt_vector")->Arg(10'000'000);
+BENCHMARK_TEMPLATE(push_back_grow, std_vector)->Name("push_back_grow/std::vector")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(push_back_grow, mp_vector)->Name("push_back_grow/opt_vector")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(insert_erase_front, std_vector)->Name("insert_erase_front/std::vector")->Arg(1 << 16);
+BENCHMARK_TEMPLATE(insert_erase_front, mp_vector)->Name("insert_erase_front/opt_vector")->Arg(1 << 16);
@@ -0,0 +1,120 @@
+# The MIT License (MIT)
+#
+# Copyright (c) 2016 Mateusz Pusz
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+
+# Compiles SOURCE to assembly and checks that every function `<name>` has the same instructions as
+# `<name>_manual` (local labels are ignored).
+#
+# Additionally SOURCE may contain FileCheck-style directives applied to the function named by the preceding
+# CHECK-LABEL (instructions are matched with CMake regular expressions after normalization of local labels):
+#   // CHECK-LABEL: <function>
+#   // CHECK-MAX-INSTRUCTIONS: <n>   at most n instructions (CET/BTI landing pads and nops are not counted)
+#   // CHECK-NO-CALLS                 no calls and no tail calls
+#   // CHECK: <regex>                 at least one instruction matches
+#   // CHECK-NOT: <regex>             no instruction matches
+#
+# Usage: cmake -DCOMPILER=<c++> -DFLAGS=<list> -DSOURCE=<file> -DOUTPUT=<file.s> -P check_codegen.cmake
+
+execute_process(COMMAND ${COMPILER} ${FLAGS} -S -o ${OUTPUT} ${SOURCE} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Compilation of ${SOURCE} failed")
+endif()
+
+file(STRINGS ${OUTPUT} lines)
+set(functions)
+set(current)
+foreach(line IN LISTS lines)
+    if(line MATCHES "^([A-Za-z_][A-Za-z0-9_]*):")
+        set(current ${CMAKE_MATCH_1})
+        list(APPEND functions ${current})
+        set(body_${current} "")
+    elseif(current AND line MATCHES "^[ \t]+[a-z]")
+        string(STRIP "${line}" instruction)
+        string(REGEX REPLACE "\\.L[A-Za-z0-9_]+" ".L" instruction "${instruction}")
+        string(APPEND body_${current} "  ${instruction}\n")
+        list(APPEND instructions_${current} "${instruction}")
+    endif()
+endforeach()
+
+set(checked 0)
+foreach(function IN LISTS functions)
+    if(function MATCHES "^(.+)_manual$")
+        set(name ${CMAKE_MATCH_1})
+        if(NOT DEFINED body_${name})
+            message(SEND_ERROR "'${name}' not found for '${function}'")
+        elseif(NOT body_${name} STREQUAL body_${function})
+            message(SEND_ERROR "'${name}':\n${body_${name}}differs from '${function}':\n${body_${function}}")
+        else()
+            math(EXPR checked "${checked} + 1")
+        endif()
+    endif()
+endforeach()
+
+# FileCheck-style directives
+set(directives 0)
+set(label)
+file(STRINGS ${SOURCE} source_lines REGEX "^[ \t]*// CHECK")
+foreach(line IN LISTS source_lines)
+    if(line MATCHES "// CHECK-LABEL: *([A-Za-z0-9_]+)")
+        set(label ${CMAKE_MATCH_1})
+        if(NOT DEFINED body_${label})
+            message(SEND_ERROR "'${label}' not found")
+        endif()
+        continue()
+    elseif(NOT label)
+        message(SEND_ERROR "'${line}' is not preceded by CHECK-LABEL")
+        continue()
+    endif()
+    math(EXPR directives "${directives} + 1")
+    set(instructions ${instructions_${label}})
+    if(line MATCHES "// CHECK-MAX-INSTRUCTIONS: *([0-9]+)")
+        set(max ${CMAKE_MATCH_1})
+        list(FILTER instructions EXCLUDE REGEX "^(endbr(32|64)|bti|nop)")
+        list(LENGTH instructions count)
+        if(count GREATER max)
+            message(SEND_ERROR "'${label}' has ${count} instructions (at most ${max} expected):\n${body_${label}}")
+        endif()
+    elseif(line MATCHES "// CHECK-NO-CALLS")
+        # x86 `call`/`jmp symbol`, AArch64 `bl`/`b symbol` (local labels start with '.')
+        list(FILTER instructions INCLUDE REGEX "^(call|bl[ \t]|blr[ \t]|jmp[ \t]+[^.]|b[ \t]+[^.])")
+        if(instructions)
+            message(SEND_ERROR "'${label}' calls other functions:\n${body_${label}}")
+        endif()
+    elseif(line MATCHES "// CHECK-NOT: *(.+)$")
+        list(FILTER instructions INCLUDE REGEX "${CMAKE_MATCH_1}")
+        if(instructions)
+            message(SEND_ERROR "'${label}' matches '${CMAKE_MATCH_1}':\n${body_${label}}")
+        endif()
+    elseif(line MATCHES "// CHECK: *(.+)$")
+        list(FILTER instructions INCLUDE REGEX "${CMAKE_MATCH_1}")
+        if(NOT instructions)
+            message(SEND_ERROR "'${label}' does not match '${CMAKE_MATCH_1}':\n${body_${label}}")
+        endif()
+    else()
+        message(SEND_ERROR "Unknown directive '${line}'")
+    endif()
+endforeach()
+
+if(checked EQUAL 0 AND directives EQUAL 0)
+    message(FATAL_ERROR "No '<name>_manual' functions or CHECK directives found in ${SOURCE}")
+endif()
+message(STATUS "${checked} function pairs compiled to the same code, ${directives} directives checked")
@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Kernels for the codegen test of opt_checking modes (compiled with -fno-exceptions): value() never uses
+// exception machinery and in opt_checking::assume mode it is a plain load.
+
+#include "opt.h"
+
+namespace {
+
+  template<mp::opt_checking Mode>
+  struct checking_policy {
+    static constexpr long null_value() noexcept { return -1; }
+    static constexpr mp::opt_checking checking = Mode;
+  };
+
+  template<mp::opt_checking Mode>
+  using opt_long = mp::opt<long, checking_policy<Mode>>;
+
+}  // namespace
+
+// CHECK-LABEL: value_standard
+// CHECK-NO-CALLS
+// CHECK-NOT: bad_optional_access
+extern "C" long value_standard(const opt_long<mp::opt_checking::standard>& o) { return o.value(); }
+
+// CHECK-LABEL: value_exception
+// CHECK-NO-CALLS
+// CHECK-NOT: bad_optional_access
+extern "C" long value_exception(const opt_long<mp::opt_checking::exception>& o) { return o.value(); }
+
+// CHECK-LABEL: value_trap
+// CHECK-NO-CALLS
+// CHECK-NOT: bad_optional_access
+extern "C" long value_trap(const opt_long<mp::opt_checking::trap>& o) { return o.value(); }
+
+// CHECK-LABEL: value_assume
+// CHECK-MAX-INSTRUCTIONS: 2
+// CHECK-NO-CALLS
+extern "C" long value_assume(const opt_long<mp::opt_checking::assume>& o) { return o.value(); }
+extern "C" long value_assume_manual(const long& v) { return v; }
+
+// the check of the first access makes the other ones redundant
+// CHECK-LABEL: value_trap_twice
+// CHECK-MAX-INSTRUCTIONS: 8
+// CHECK-NO-CALLS
+extern "C" long value_trap_twice(const opt_long<mp::opt_checking::trap>& o) { return o.value() + *o * o.value(); }
+
+// CHECK-LABEL: value_callback
+// CHECK: opt_check_failed
+// CHECK-NOT: bad_optional_access
+extern "C" long value_callback(const opt_long<mp::opt_checking::callback>& o) { return o.value(); }
@@ -0,0 +1,62 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Kernels for the codegen test of comparisons: with mp::opt_branchless_less (and operator<=> for integral values)
+// integral and NaN-boxed values are compared without branches for both null orders.
+
+#define OPT_REL_OPS
+#include "opt.h"
+
+namespace {
+
+  using opt_long = mp::opt<long, mp::opt_null_value_policy<long, -1>>;
+  using opt_double = mp::opt<double, mp::opt_nan_policy<double>>;
+
+  struct nulls_last_policy {
+    static constexpr long null_value() noexcept { return -1; }
+    static constexpr mp::opt_null_order null_order = mp::opt_null_order::last;
+  };
+  using opt_long_last = mp::opt<long, nulls_last_policy>;
+
+  constexpr mp::opt_branchless_less less;
+
+}  // namespace
+
+// CHECK-LABEL: less_long
+// CHECK-NO-CALLS
+// CHECK-NOT: ^(j[a-z]+|b\.[a-z]+|cbn?z|tbn?z)[^a-z]
+extern "C" bool less_long(const opt_long& lhs, const opt_long& rhs) { return less(lhs, rhs); }
+
+// CHECK-LABEL: less_long_last
+// CHECK-NO-CALLS
+// CHECK-NOT: ^(j[a-z]+|b\.[a-z]+|cbn?z|tbn?z)[^a-z]
+extern "C" bool less_long_last(const opt_long_last& lhs, const opt_long_last& rhs) { return less(lhs, rhs); }
+
+// CHECK-LABEL: three_way_long
+// CHECK-NO-CALLS
+// CHECK-NOT: ^(j[a-z]+|b\.[a-z]+|cbn?z|tbn?z)[^a-z]
+extern "C" bool three_way_long(const opt_long& lhs, const opt_long& rhs) { return (lhs <=> rhs) < 0; }
+
+// CHECK-LABEL: less_double
+// CHECK-NO-CALLS
+// CHECK-NOT: ^(j[a-z]+|b\.[a-z]+|cbn?z|tbn?z)[^a-z]
+extern "C" bool less_double(const opt_double& lhs, const opt_double& rhs) { return less(lhs, rhs); }
@@ -0,0 +1,63 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Kernels for the codegen test: every `<name>` function has to compile to the same instructions as `<name>_manual`.
+
+#include "opt.h"
+
+namespace {
+
+  enum class level : int {};
+
+}  // namespace
+
+namespace mp {
+
+  template<>
+  struct opt_default_policy<level> {
+    static constexpr level null_value() noexcept { return level{-1}; }
+  };
+
+}  // namespace mp
+
+namespace {
+
+  using opt_long = mp::opt<long, mp::opt_null_value_policy<long, -1>>;
+
+  constexpr long twice(long v) noexcept { return 2 * v; }
+  constexpr level to_level(long v) noexcept { return level{static_cast<int>(v & 0xFF)}; }
+
+}  // namespace
+
+// std::optional<long> result
+extern "C" long transform_value_or(opt_long o) { return o.transform(twice).value_or(0); }
+extern "C" long transform_value_or_manual(opt_long o) { return o.has_value() ? twice(*o) : 0; }
+
+// opt<level> result
+extern "C" level transform_opt_value_or(opt_long o) { return o.transform(to_level).value_or(level{0}); }
+extern "C" level transform_opt_value_or_manual(opt_long o) { return o.has_value() ? to_level(*o) : level{0}; }
+
+extern "C" long or_else_value(opt_long o) { return *o.or_else([] { return opt_long{42}; }); }
+extern "C" long or_else_value_manual(opt_long o) { return o.has_value() ? *o : 42; }
+
+extern "C" long value_or_else(opt_long o) { return o.value_or_else([] { return 42L; }); }
+extern "C" long value_or_else_manual(opt_long o) { return o.has_value() ? *o : 42; }
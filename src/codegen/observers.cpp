@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Kernels for the codegen test: the hot observers and modifiers of opt<T, Policy> have to compile to the same
+// instructions as the raw sentinel checks (`<name>_manual`), i.e. one compare or one store.
+
+#include "opt.h"
+
+namespace {
+
+  enum class level : int {};
+
+}  // namespace
+
+namespace mp {
+
+  template<>
+  struct opt_default_policy<level> {
+    static constexpr level null_value() noexcept { return level{-1}; }
+  };
+
+}  // namespace mp
+
+namespace {
+
+  using opt_long = mp::opt<long, mp::opt_null_value_policy<long, -1>>;
+  using opt_double = mp::opt<double, mp::opt_nan_policy<double>>;
+  using opt_level = mp::opt<level>;
+
+  constexpr double nan_null = __builtin_bit_cast(double, 0x7FF8'0000'0000'0001UL);
+
+}  // namespace
+
+// CHECK-LABEL: has_value
+// CHECK-MAX-INSTRUCTIONS: 4
+// CHECK-NO-CALLS
+extern "C" bool has_value(const opt_long& o) { return o.has_value(); }
+extern "C" bool has_value_manual(const long& v) { return v != -1; }
+
+// CHECK-LABEL: has_value_enum
+// CHECK-MAX-INSTRUCTIONS: 4
+// CHECK-NO-CALLS
+extern "C" bool has_value_enum(const opt_level& o) { return static_cast<bool>(o); }
+extern "C" bool has_value_enum_manual(const level& v) { return v != level{-1}; }
+
+// bit pattern comparison, not a floating-point one
+// CHECK-LABEL: has_value_nan
+// CHECK-MAX-INSTRUCTIONS: 8
+// CHECK-NO-CALLS
+extern "C" bool has_value_nan(const opt_double& o) { return o.has_value(); }
+extern "C" bool has_value_nan_manual(const double& v)
+{
+  return __builtin_bit_cast(unsigned long, v) != __builtin_bit_cast(unsigned long, nan_null);
+}
+
+// CHECK-LABEL: dereference
+// CHECK-MAX-INSTRUCTIONS: 2
+// CHECK-NO-CALLS
+// CHECK-NOT: bad_optional_access
+extern "C" long dereference(const opt_long& o) { return *o; }
+extern "C" long dereference_manual(const long& v) { return v; }
+
+// CHECK-LABEL: value_or
+// CHECK-MAX-INSTRUCTIONS: 5
+// CHECK-NO-CALLS
+extern "C" long value_or(const opt_long& o) { return o.value_or(0); }
+extern "C" long value_or_manual(const long& v) { return v != -1 ? v : 0; }
+
+// CHECK-LABEL: reset
+// CHECK-MAX-INSTRUCTIONS: 3
+// CHECK-NO-CALLS
+extern "C" void reset(opt_long& o) { o.reset(); }
+extern "C" void reset_manual(long& v) { v = -1; }
+
+// CHECK-LABEL: assign
+// CHECK-MAX-INSTRUCTIONS: 2
+// CHECK-NO-CALLS
+extern "C" void assign(opt_long& o, long v) { o = v; }
+extern "C" void assign_manual(long& o, long v) { o = v; }
+
+// CHECK-LABEL: construct
+// CHECK-MAX-INSTRUCTIONS: 2
+// CHECK-NO-CALLS
+extern "C" long construct(long v) { return *opt_long{v}; }
+extern "C" long construct_manual(long v) { return v; }
+
+// the exception is thrown only on the (cold) empty path
+// CHECK-LABEL: value
+// CHECK: bad_optional_access
+extern "C" long value(const opt_long& o) { return o.value(); }
@@ -0,0 +1,150 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <atomic>
+#include <cassert>
+
+namespace mp {
+
+  // atomic_opt<T, Policy> is an atomic "value or nothing" slot. Policy::null_value() marks an empty state so no
+  // additional flag is needed and the object has the size of T. It is lock-free if std::atomic of the same size
+  // is (see is_always_lock_free).
+  //
+  // Like std::atomic, store() and exchange() do not wake up waiting threads - notify_one() or notify_all() has to be
+  // called explicitly.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class atomic_opt {
+  public:
+    using value_type = opt<T, Policy>;
+
+    static_assert(std::is_trivially_copyable_v<value_type>,
+                  "trivially copyable opt<T, Policy> required, consider using opt<T, Policy> guarded by a mutex");
+    static_assert(sizeof(value_type) <= 16, "'sizeof(T) > 16' consider using opt<T, Policy> guarded by a mutex");
+
+    static constexpr bool is_always_lock_free = std::atomic<value_type>::is_always_lock_free;
+
+    atomic_opt() noexcept = default;
+    constexpr atomic_opt(value_type desired) noexcept : value_{desired} {}
+    atomic_opt(const atomic_opt&) = delete;
+    atomic_opt& operator=(const atomic_opt&) = delete;
+
+    bool is_lock_free() const noexcept { return value_.is_lock_free(); }
+
+    value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept { return value_.load(order); }
+    void store(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      value_.store(desired, order);
+    }
+    void reset(std::memory_order order = std::memory_order_seq_cst) noexcept { store(value_type{}, order); }
+
+    value_type exchange(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      return value_.exchange(desired, order);
+    }
+
+    // atomically empties the slot and returns its previous content
+    value_type take(std::memory_order order = std::memory_order_seq_cst) noexcept { return exchange(value_type{}, order); }
+
+    // objects are compared bitwise
+    bool compare_exchange_weak(value_type& expected, value_type desired, std::memory_order success,
+                               std::memory_order failure) noexcept
+    {
+      return value_.compare_exchange_weak(expected, desired, success, failure);
+    }
+    bool compare_exchange_weak(value_type& expected, value_type desired,
+                               std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      return value_.compare_exchange_weak(expected, desired, order);
+    }
+    bool compare_exchange_strong(value_type& expected, value_type desired, std::memory_order success,
+                                 std::memory_order failure) noexcept
+    {
+      return value_.compare_exchange_strong(expected, desired, success, failure);
+    }
+    bool compare_exchange_strong(value_type& expected, value_type desired,
+                                 std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      return value_.compare_exchange_strong(expected, desired, order);
+    }
+
+    // stores desired only if the slot is empty; the content is compared with has_value() and not bitwise, so it works
+    // also for policies that accept many empty bit patterns
+    bool try_store(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      auto expected = load(std::memory_order_relaxed);
+      do {
+        if(expected.has_value()) return false;
+      } while(!compare_exchange_weak(expected, desired, order));
+      return true;
+    }
+
+    // blocking; as for std::atomic::wait() order cannot be std::memory_order_release or std::memory_order_acq_rel
+    void wait(value_type old, std::memory_order order = std::memory_order_seq_cst) const noexcept
+    {
+      assert(valid_wait_order(order));
+      value_.wait(old, order);
+    }
+
+    // blocks until the slot is not empty and returns its content
+    value_type wait_value(std::memory_order order = std::memory_order_seq_cst) const noexcept
+    {
+      assert(valid_wait_order(order));
+      auto v = load(order);
+      while(!v.has_value()) {
+        value_.wait(v, order);
+        v = load(order);
+      }
+      return v;
+    }
+
+    // blocks until the slot is not empty and atomically empties it
+    value_type wait_take(std::memory_order order = std::memory_order_seq_cst) noexcept
+    {
+      assert(valid_wait_order(order));
+      auto v = load(order);
+      for(;;) {
+        if(!v.has_value()) {
+          value_.wait(v, order);
+          v = load(order);
+        }
+        else if(compare_exchange_weak(v, value_type{}, order)) {
+          return v;
+        }
+      }
+    }
+
+    void notify_one() noexcept { value_.notify_one(); }
+    void notify_all() noexcept { value_.notify_all(); }
+
+  private:
+    std::atomic<value_type> value_{value_type{}};
+
+    static constexpr bool valid_wait_order(std::memory_order order) noexcept
+    {
+      return order != std::memory_order_release && order != std::memory_order_acq_rel;
+    }
+  };
+
+}
@@ -0,0 +1,235 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <exception>
+
+namespace mp {
+
+  // error wrapper used to construct niche_expected<T, E, Policy> with an error
+  template<typename E>
+  class unexpected {
+  public:
+    constexpr explicit unexpected(E e) noexcept : error_{e} {}
+    constexpr E error() const noexcept { return error_; }
+
+  private:
+    E error_;
+  };
+
+  template<typename E>
+  class bad_expected_access : public std::exception {
+  public:
+    explicit bad_expected_access(E e) noexcept : error_{e} {}
+    const char* what() const noexcept override { return "bad niche_expected access"; }
+    E error() const noexcept { return error_; }
+
+  private:
+    E error_;
+  };
+
+  template<typename T, typename E, typename Policy = opt_default_policy<T>>
+  class niche_expected;
+
+  namespace detail {
+
+    template<typename T>
+    struct is_niche_expected : std::false_type {
+    };
+    template<typename T, typename E, typename P>
+    struct is_niche_expected<niche_expected<T, E, P>> : std::true_type {
+    };
+
+    // as access_failed() but throwing modes throw bad_expected_access<E> with the error
+    template<opt_checking Mode, typename E>
+    [[noreturn]] void expected_access_failed([[maybe_unused]] E e)
+    {
+      if constexpr(Mode == opt_checking::callback) {
+        opt_check_failed();
+      }
+      else {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        if constexpr(Mode != opt_checking::trap) throw bad_expected_access<E>{e};
+#endif
+        trap();
+      }
+    }
+
+  }  // namespace detail
+
+  // niche_expected<T, E, Policy> contains either a value of type T or an error of an enumeration (or integral) type E.
+  // The error e is stored as the `e`-th niche of Policy (see opt_policy_traits::niche_value()) so there is no separate
+  // discriminator and the object has the same size as T. Errors have to be in [0, niche_count) range.
+  template<typename T, typename E, typename Policy>
+  class niche_expected {
+  public:
+    using value_type = T;
+    using error_type = E;
+    using policy_type = Policy;
+    using traits_type = opt_policy_traits<T, Policy>;
+
+    static_assert(std::is_enum_v<E> || std::is_integral_v<E>,
+                  "enumeration or integral error type required, consider using std::variant<T, E>");
+    static_assert(traits_type::niche_count > 1,
+                  "Policy with more than one niche required, consider using opt<T, Policy> or std::variant<T, E>");
+
+  private:
+    using storage_type = typename traits_type::storage_type;
+    storage_type storage_;
+
+    // storage of type T is accessed directly so it may be used in constant expressions
+    constexpr const T& data() const
+    {
+      if constexpr(std::is_same_v<storage_type, T>)
+        return storage_;
+      else
+        return *reinterpret_cast<const T*>(&storage_);
+    }
+    constexpr T& data()
+    {
+      if constexpr(std::is_same_v<storage_type, T>)
+        return storage_;
+      else
+        return *reinterpret_cast<T*>(&storage_);
+    }
+
+    // access to an error is handled according to traits_type::checking (see opt_checking) but bad_expected_access<E>
+    // is thrown instead of std::bad_optional_access
+    template<bool Value>
+    constexpr void check_access() const
+    {
+      constexpr opt_checking mode = traits_type::checking;
+      if constexpr(mode == opt_checking::assertion || mode == opt_checking::assume ||
+                   (mode == opt_checking::standard && !Value)) {
+        detail::check_access<mode, Value>(has_value());
+      }
+      else {
+        if(!has_value()) [[unlikely]]
+          detail::expected_access_failed<mode>(error());
+      }
+    }
+
+    static constexpr std::size_t to_index(E e) noexcept { return static_cast<std::size_t>(e); }
+
+    static constexpr storage_type to_storage(E e) noexcept(noexcept(traits_type::niche_value(0)))
+    {
+      assert(to_index(e) < traits_type::niche_count);
+      return traits_type::niche_value(to_index(e));
+    }
+
+  public:
+    // constructors
+    template<typename U = T, detail::Requires<std::is_default_constructible<U>> = true>
+    constexpr niche_expected() : storage_{T{}}
+    {
+    }
+
+    template<typename U = T,
+             detail::Requires<std::is_constructible<T, U&&>, std::negation<std::is_same<std::decay_t<U>, niche_expected>>,
+                              std::negation<std::is_same<std::decay_t<U>, unexpected<E>>>> = true>
+    constexpr niche_expected(U&& value) : storage_{std::forward<U>(value)}
+    {
+      assert(has_value());
+    }
+
+    constexpr niche_expected(unexpected<E> e) noexcept(noexcept(to_storage(e.error()))) : storage_{to_storage(e.error())}
+    {
+    }
+
+    // assignment
+    template<typename U = T,
+             detail::Requires<std::is_constructible<T, U&&>, std::negation<std::is_same<std::decay_t<U>, niche_expected>>,
+                              std::negation<std::is_same<std::decay_t<U>, unexpected<E>>>> = true>
+    constexpr niche_expected& operator=(U&& value)
+    {
+      storage_ = storage_type{std::forward<U>(value)};
+      assert(has_value());
+      return *this;
+    }
+
+    constexpr niche_expected& operator=(unexpected<E> e) noexcept(noexcept(to_storage(e.error())))
+    {
+      storage_ = to_storage(e.error());
+      return *this;
+    }
+
+    // observers
+    constexpr bool has_value() const noexcept(noexcept(traits_type::niche_index(std::declval<storage_type>())))
+    {
+      return traits_type::niche_index(storage_) == traits_type::niche_count;
+    }
+    constexpr explicit operator bool() const noexcept(noexcept(std::declval<niche_expected>().has_value()))
+    {
+      return has_value();
+    }
+
+    // clang-format off
+    constexpr const T* operator->() const { check_access<false>(); return &data(); }
+    constexpr T* operator->() { check_access<false>(); return &data(); }
+    constexpr const T& operator*() const & { check_access<false>(); return data(); }
+    constexpr T& operator*() & { check_access<false>(); return data(); }
+    constexpr T&& operator*() && { check_access<false>(); return std::move(data()); }
+
+    constexpr const T& value() const&   { check_access<true>(); return data(); }
+    constexpr T& value() &              { check_access<true>(); return data(); }
+    constexpr T&& value() &&            { check_access<true>(); return std::move(data()); }
+    template<typename U>
+    constexpr T value_or(U&& default_value) const& { return has_value() ? **this : T{ std::forward<U>(default_value) }; }
+    // clang-format on
+
+    constexpr E error() const
+    {
+      assert(!has_value());
+      return static_cast<E>(traits_type::niche_index(storage_));
+    }
+  };
+
+  template<typename T, typename E, typename P>
+  constexpr bool operator==(const niche_expected<T, E, P>& lhs, const niche_expected<T, E, P>& rhs)
+  {
+    if(lhs.has_value() != rhs.has_value()) return false;
+    return lhs.has_value() ? *lhs == *rhs : lhs.error() == rhs.error();
+  }
+
+  template<typename T, typename E, typename P>
+  constexpr bool operator!=(const niche_expected<T, E, P>& lhs, const niche_expected<T, E, P>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template<typename T, typename E, typename P, typename U,
+           detail::Requires<std::negation<detail::is_niche_expected<U>>, std::negation<std::is_same<U, unexpected<E>>>> =
+               true>
+  constexpr bool operator==(const niche_expected<T, E, P>& lhs, const U& value)
+  {
+    return lhs.has_value() && *lhs == value;
+  }
+
+  template<typename T, typename E, typename P>
+  constexpr bool operator==(const niche_expected<T, E, P>& lhs, const unexpected<E>& e)
+  {
+    return !lhs.has_value() && lhs.error() == e.error();
+  }
+
+}
@@ -23,6 +23,10 @@
 #pragma once
 
 #include "opt_bits.h"
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <limits>
 
 namespace mp {
 
@@ -43,12 +47,65 @@ namespace mp {
     static constexpr T null_value() noexcept { return NullType::null_value; }
   };
 
+  // uses one specific quiet NaN bit pattern (not produced by any arithmetic operation) as a null value so all other
+  // values (including other NaNs and 0.0) are still valid; has_value() is an integer comparison of bit patterns
+  template<typename T>
+  struct opt_nan_policy {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "'float' or 'double' is required, consider using opt_null_type_policy<T, NullType>");
+    static_assert(std::numeric_limits<T>::is_iec559, "IEEE 754 floating-point representation is required");
+    using bits_type = std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+    static constexpr bits_type null_bits =
+        static_cast<bits_type>(sizeof(T) == sizeof(std::uint32_t) ? 0x7FC0'0001 : 0x7FF8'0000'0000'0001);
+    static constexpr bool bitwise_null = true;
+    static constexpr T null_value() noexcept { return std::bit_cast<T>(null_bits); }
+    static constexpr bool has_value(T value) noexcept { return std::bit_cast<bits_type>(value) != null_bits; }
+
+    // all the following positive quiet NaN payloads are niches
+    static constexpr std::size_t niche_count =
+        sizeof(T) == sizeof(std::uint32_t)
+            ? std::size_t{0x3F'FFFF}
+            : static_cast<std::size_t>(std::min<std::uint64_t>(0x7'FFFF'FFFF'FFFF, std::numeric_limits<std::size_t>::max()));
+    static constexpr T niche_value(std::size_t i) noexcept
+    {
+      assert(i < niche_count);
+      return std::bit_cast<T>(static_cast<bits_type>(null_bits + i));
+    }
+    static constexpr std::size_t niche_index(T value) noexcept
+    {
+      const auto i = static_cast<bits_type>(std::bit_cast<bits_type>(value) - null_bits);
+      return i < niche_count ? static_cast<std::size_t>(i) : niche_count;
+    }
+  };
+
+  // uses all values from the [First, Last] range as niches (First is a null value) so i.e. opt<opt<T, Policy>> has
+  // the same size as T
+  template<typename T, T First, T Last>
+  struct opt_niche_range_policy {
+    static_assert(First <= Last, "'First > Last'");
+    static constexpr std::size_t niche_count = static_cast<std::size_t>(Last) - static_cast<std::size_t>(First) + 1;
+    static constexpr T null_value() noexcept { return First; }
+    static constexpr bool has_value(T value) noexcept { return value < First || Last < value; }
+    static constexpr T niche_value(std::size_t i) noexcept
+    {
+      assert(i < niche_count);
+      return static_cast<T>(static_cast<std::size_t>(First) + i);
+    }
+    static constexpr std::size_t niche_index(T value) noexcept
+    {
+      return has_value(value) ? niche_count : static_cast<std::size_t>(value) - static_cast<std::size_t>(First);
+    }
+  };
+
   // opt_policy_traits class template provides the standardized way to access properties of user Policy types
   template<typename T, typename Policy>
   struct opt_policy_traits {
     // Policy::storage_type if exists, T otherwise
     using storage_type = typename detail::detect_storage_type<T, Policy>::type;
 
+    // true if emptiness may be checked with a bitwise comparison of storage with null_value()
+    static constexpr bool bitwise_null = detail::is_bitwise_null<storage_type, Policy>::value;
+
     // always calls Policy::null_value()
     static constexpr storage_type null_value() noexcept(noexcept(Policy::null_value())) { return Policy::null_value(); }
 
@@ -65,6 +122,44 @@ namespace mp {
     {
       return !(value == null_value());
     }
+
+    // number of storage values that are never used by T values (Policy::niche_count if available, 1 otherwise);
+    // niche 0 is always null_value()
+    static constexpr std::size_t niche_count = detail::detect_niche_count<Policy>::value;
+
+    // Policy::checking if available, opt_default_checking otherwise
+    static constexpr opt_checking checking = detail::detect_checking<Policy>::value;
+
+    // Policy::null_order if available, opt_default_null_order otherwise
+    static constexpr opt_null_order null_order = detail::detect_null_order<Policy>::value;
+
+    // i-th niche; calls Policy::niche_value() if available
+    template<typename P = Policy, detail::Requires<std::bool_constant<(detail::detect_niche_count<P>::value > 1)>> = true>
+    static constexpr storage_type niche_value(std::size_t i) noexcept(noexcept(Policy::niche_value(i)))
+    {
+      return Policy::niche_value(i);
+    }
+
+    template<typename P = Policy, detail::Requires<std::bool_constant<detail::detect_niche_count<P>::value == 1>> = true>
+    static constexpr storage_type niche_value([[maybe_unused]] std::size_t i) noexcept(noexcept(null_value()))
+    {
+      assert(i == 0);
+      return null_value();
+    }
+
+    // index of the niche stored in storage or niche_count if storage contains a value; calls Policy::niche_index() if
+    // available
+    template<typename P = Policy, detail::Requires<std::bool_constant<(detail::detect_niche_count<P>::value > 1)>> = true>
+    static constexpr std::size_t niche_index(const storage_type& storage) noexcept(noexcept(Policy::niche_index(storage)))
+    {
+      return Policy::niche_index(storage);
+    }
+
+    template<typename P = Policy, detail::Requires<std::bool_constant<detail::detect_niche_count<P>::value == 1>> = true>
+    static constexpr std::size_t niche_index(const storage_type& storage) noexcept(noexcept(has_value(storage)))
+    {
+      return has_value(storage) ? niche_count : 0;
+    }
   };
 
   template<typename T, typename Policy = opt_default_policy<T>>
@@ -78,8 +173,92 @@ namespace mp {
     using storage_type = typename traits_type::storage_type;
     storage_type storage_;
 
-    constexpr const T& data() const { return *reinterpret_cast<const T*>(&storage_); }
-    constexpr T& data() { return *reinterpret_cast<T*>(&storage_); }
+    friend struct detail::opt_access;
+    template<typename, typename>
+    friend class opt;
+    struct storage_tag {
+    };
+    constexpr opt(storage_tag, const storage_type& storage) : storage_{storage} {}
+
+    // initializes the storage directly with the result of `f` (used by transform()); the result equal to the null
+    // value leaves the object empty, as with any other construction, unless opt_checking::assume lets the optimizer
+    // drop the redundant check in the chained calls
+    template<typename F, typename Arg>
+    constexpr opt(detail::invoke_tag, F&& f, Arg&& arg) noexcept(
+        noexcept(storage_type{std::invoke(std::forward<F>(f), std::forward<Arg>(arg))}))
+        : storage_{std::invoke(std::forward<F>(f), std::forward<Arg>(arg))}
+    {
+      if constexpr(traits_type::checking == opt_checking::assume) {
+#ifdef NDEBUG
+        detail::assume(has_value());
+#else
+        assert(has_value());
+#endif
+      }
+    }
+
+    template<typename F, typename Arg>
+    static constexpr bool nothrow_transform() noexcept
+    {
+      using result_type = detail::transform_result_t<F, Arg>;
+      if constexpr(detail::is_opt<result_type>::value)
+        return noexcept(result_type{detail::invoke_tag{}, std::declval<F>(), std::declval<Arg>()});
+      else
+        return std::is_nothrow_invocable_v<F, Arg> &&
+               std::is_nothrow_constructible_v<result_type, std::in_place_t, std::invoke_result_t<F, Arg>>;
+    }
+
+    template<typename Self, typename F>
+    static constexpr auto transform_impl(Self&& self, F&& f) noexcept(
+        nothrow_transform<F, decltype(*std::forward<Self>(self))>())
+    {
+      using arg_type = decltype(*std::forward<Self>(self));
+      using result_type = detail::transform_result_t<F, arg_type>;
+      using value_type = detail::transform_value_t<F, arg_type>;
+      static_assert(!std::is_reference_v<std::invoke_result_t<F, arg_type>> && !std::is_array_v<value_type> &&
+                        !std::is_same_v<value_type, std::nullopt_t> && !std::is_same_v<value_type, std::in_place_t>,
+                    "'transform()' should return a non-array object type");
+      if(!self.has_value()) return result_type{};
+      if constexpr(detail::is_opt<result_type>::value)
+        return result_type{detail::invoke_tag{}, std::forward<F>(f), *std::forward<Self>(self)};
+      else
+        return result_type{std::in_place, std::invoke(std::forward<F>(f), *std::forward<Self>(self))};
+    }
+
+    template<typename Self, typename F>
+    static constexpr auto and_then_impl(Self&& self, F&& f) noexcept(
+        std::is_nothrow_invocable_v<F, decltype(*std::forward<Self>(self))> &&
+        std::is_nothrow_move_constructible_v<
+            std::remove_cvref_t<std::invoke_result_t<F, decltype(*std::forward<Self>(self))>>>)
+    {
+      using result_type = std::remove_cvref_t<std::invoke_result_t<F, decltype(*std::forward<Self>(self))>>;
+      static_assert(detail::is_opt<result_type>::value || detail::is_std_optional<result_type>::value,
+                    "'and_then()' should return opt<U, P> or std::optional<U>");
+      if(!self.has_value()) return result_type{};
+      return std::invoke(std::forward<F>(f), *std::forward<Self>(self));
+    }
+
+    template<bool Value>
+    constexpr void check_access() const
+    {
+      detail::check_access<traits_type::checking, Value>(has_value());
+    }
+
+    // storage of type T is accessed directly so it may be used and modified in constant expressions
+    constexpr const T& data() const
+    {
+      if constexpr(std::is_same_v<storage_type, T>)
+        return storage_;
+      else
+        return *reinterpret_cast<const T*>(&storage_);
+    }
+    constexpr T& data()
+    {
+      if constexpr(std::is_same_v<storage_type, T>)
+        return storage_;
+      else
+        return *reinterpret_cast<T*>(&storage_);
+    }
 
   public:
     // constructors
@@ -108,7 +287,7 @@ namespace mp {
              detail::Requires<std::is_constructible<T, U&&>,
                               std::negation<std::is_same<std::decay_t<U>, std::in_place_t>>,
                               std::negation<std::is_same<opt<T, Policy>, std::decay_t<U>>>,
-                              std::negation<detail::is_opt<std::decay_t<U>>>> = true,
+                              std::negation<detail::converts_opt_to_bool<T, U>>> = true,
              detail::Requires<std::negation<std::is_convertible<U&&, T>>> = true>
     explicit constexpr opt(U&& value) : storage_{std::forward<U>(value)}
     {
@@ -119,7 +298,7 @@ namespace mp {
              detail::Requires<std::is_constructible<T, U&&>,
                               std::negation<std::is_same<std::decay_t<U>, std::in_place_t>>,
                               std::negation<std::is_same<opt<T, Policy>, std::decay_t<U>>>,
-                              std::negation<detail::is_opt<std::decay_t<U>>>> = true,
+                              std::negation<detail::converts_opt_to_bool<T, U>>> = true,
              detail::Requires<std::is_convertible<U&&, T>> = true>
     constexpr opt(U&& value) : storage_{std::forward<U>(value)}
     {
@@ -131,7 +310,7 @@ namespace mp {
                               std::disjunction<std::is_same<std::decay_t<T>, bool>,
                                                std::negation<detail::constructs_or_converts_from_opt<T, U, P>>>> = true,
              detail::Requires<std::negation<std::is_convertible<const U&, T>>> = true>
-    explicit opt(const opt<U, P>& other) : storage_{other.has_value() ? T{*other} : traits_type::null_value()}
+    explicit constexpr opt(const opt<U, P>& other) : storage_{other.has_value() ? T{*other} : traits_type::null_value()}
     {
     }
 
@@ -140,7 +319,7 @@ namespace mp {
                               std::disjunction<std::is_same<std::decay_t<T>, bool>,
                                                std::negation<detail::constructs_or_converts_from_opt<T, U, P>>>> = true,
              detail::Requires<std::is_convertible<const U&, T>> = true>
-    opt(const opt<U, P>& other) : storage_{other.has_value() ? T{*other} : traits_type::null_value()}
+    constexpr opt(const opt<U, P>& other) : storage_{other.has_value() ? T{*other} : traits_type::null_value()}
     {
     }
 
@@ -164,7 +343,7 @@ namespace mp {
     }
 
     // assignment
-    opt& operator=(std::nullopt_t) noexcept(noexcept(std::declval<opt<T, Policy>>().reset()))
+    constexpr opt& operator=(std::nullopt_t) noexcept(noexcept(std::declval<opt<T, Policy>>().reset()))
     {
       reset();
       return *this;
@@ -176,7 +355,7 @@ namespace mp {
              detail::Requires<std::negation<std::is_same<opt<T, Policy>, std::decay<U>>>,
                               std::negation<std::conjunction<std::is_scalar<T>, std::is_same<T, std::decay_t<U>>>>,
                               std::is_constructible<T, U>, std::is_assignable<T&, U>> = true>
-    opt& operator=(U&& value)
+    constexpr opt& operator=(U&& value)
     {
       data() = std::forward<U>(value);
       assert(has_value());
@@ -187,7 +366,7 @@ namespace mp {
              detail::Requires<std::is_constructible<T, const U&>, std::is_assignable<T&, const U&>,
                               std::negation<detail::constructs_or_converts_from_opt<T, U, P>>,
                               std::negation<detail::assigns_from_opt<T, U, P>>> = true>
-    opt& operator=(const opt<U, P>& other)
+    constexpr opt& operator=(const opt<U, P>& other)
     {
       if(other.has_value())
         *this = *other;
@@ -200,7 +379,7 @@ namespace mp {
              detail::Requires<std::is_constructible<T, U>, std::is_assignable<T&, U>,
                               std::negation<detail::constructs_or_converts_from_opt<T, U, P>>,
                               std::negation<detail::assigns_from_opt<T, U, P>>> = true>
-    opt& operator=(opt<U, P>&& other)
+    constexpr opt& operator=(opt<U, P>&& other)
     {
       if(other.has_value())
         *this = std::move(*other);
@@ -210,19 +389,21 @@ namespace mp {
     }
 
     // swap
-    void swap(opt& other) noexcept(
+    constexpr void swap(opt& other) noexcept(
         std::is_nothrow_move_constructible<storage_type>::value /* && std::is_nothrow_swappable<storage_type>::value */)
     {
       std::swap(storage_, other.storage_);
     }
 
     // observers
-    constexpr const T* operator->() const { assert(has_value()); return &data(); }
-    constexpr T* operator->() { assert(has_value()); return &data(); }
-    constexpr const T& operator*() const & { assert(has_value()); return data(); }
-    constexpr T& operator*() & { assert(has_value()); return data(); }
-    constexpr T&& operator*() && { assert(has_value()); return std::move(data()); }
-    constexpr const T&& operator*() const && { assert(has_value()); return std::move(data()); }
+    //
+    // access to an empty object is handled according to traits_type::checking (see opt_checking)
+    constexpr const T* operator->() const { check_access<false>(); return &data(); }
+    constexpr T* operator->() { check_access<false>(); return &data(); }
+    constexpr const T& operator*() const & { check_access<false>(); return data(); }
+    constexpr T& operator*() & { check_access<false>(); return data(); }
+    constexpr T&& operator*() && { check_access<false>(); return std::move(data()); }
+    constexpr const T&& operator*() const && { check_access<false>(); return std::move(data()); }
 
     constexpr bool has_value() const noexcept(noexcept(traits_type::has_value(std::declval<storage_type>())))
     {
@@ -234,18 +415,146 @@ namespace mp {
     }
 
     // clang-format off
-    constexpr const T& value() const&              { if (!has_value()) throw std::bad_optional_access{}; return **this; }
-    constexpr T& value() &                         { if (!has_value()) throw std::bad_optional_access{}; return **this; }
-    constexpr T&& value() &&                       { if (!has_value()) throw std::bad_optional_access{}; return std::move(**this); }
-    constexpr const T&& value() const&&            { if (!has_value()) throw std::bad_optional_access{}; return std::move(**this); }
+    constexpr const T& value() const&              { check_access<true>(); return data(); }
+    constexpr T& value() &                         { check_access<true>(); return data(); }
+    constexpr T&& value() &&                       { check_access<true>(); return std::move(data()); }
+    constexpr const T&& value() const&&            { check_access<true>(); return std::move(data()); }
     template<typename U>
     constexpr T value_or(U&& default_value) const& { return has_value() ? **this : T{ std::forward<U>(default_value) }; }
     template<typename U>
     constexpr T value_or(U&& default_value) &&     { return has_value() ? std::move(**this) : T{ std::forward<U>(default_value) }; }
     // clang-format on
 
+    // monadic operations
+    //
+    // transform() returns opt<U> if U has a default policy and std::optional<U> otherwise; for opt<U> the result of `f`
+    // is written directly to its storage so it should not be a null value
+    // clang-format off
+    template<typename F>
+    constexpr auto transform(F&& f) & noexcept(noexcept(transform_impl(std::declval<opt&>(), std::declval<F>())))
+    { return transform_impl(*this, std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto transform(F&& f) const& noexcept(noexcept(transform_impl(std::declval<const opt&>(), std::declval<F>())))
+    { return transform_impl(*this, std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto transform(F&& f) && noexcept(noexcept(transform_impl(std::declval<opt>(), std::declval<F>())))
+    { return transform_impl(std::move(*this), std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto transform(F&& f) const&& noexcept(noexcept(transform_impl(std::declval<const opt>(), std::declval<F>())))
+    { return transform_impl(std::move(*this), std::forward<F>(f)); }
+
+    template<typename F>
+    constexpr auto and_then(F&& f) & noexcept(noexcept(and_then_impl(std::declval<opt&>(), std::declval<F>())))
+    { return and_then_impl(*this, std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto and_then(F&& f) const& noexcept(noexcept(and_then_impl(std::declval<const opt&>(), std::declval<F>())))
+    { return and_then_impl(*this, std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto and_then(F&& f) && noexcept(noexcept(and_then_impl(std::declval<opt>(), std::declval<F>())))
+    { return and_then_impl(std::move(*this), std::forward<F>(f)); }
+    template<typename F>
+    constexpr auto and_then(F&& f) const&& noexcept(noexcept(and_then_impl(std::declval<const opt>(), std::declval<F>())))
+    { return and_then_impl(std::move(*this), std::forward<F>(f)); }
+    // clang-format on
+
+    template<typename F>
+    constexpr opt or_else(F&& f) const& noexcept(std::is_nothrow_invocable_v<F> &&
+                                                 std::is_nothrow_copy_constructible_v<storage_type>)
+    {
+      static_assert(std::is_same_v<std::remove_cvref_t<std::invoke_result_t<F>>, opt>,
+                    "'or_else()' should return the same opt<T, Policy> type");
+      return has_value() ? *this : std::invoke(std::forward<F>(f));
+    }
+    template<typename F>
+    constexpr opt or_else(F&& f) && noexcept(std::is_nothrow_invocable_v<F> &&
+                                             std::is_nothrow_move_constructible_v<storage_type>)
+    {
+      static_assert(std::is_same_v<std::remove_cvref_t<std::invoke_result_t<F>>, opt>,
+                    "'or_else()' should return the same opt<T, Policy> type");
+      return has_value() ? std::move(*this) : std::invoke(std::forward<F>(f));
+    }
+
+    // value_or() with the default computed only for an empty opt
+    template<typename F>
+    constexpr T value_or_else(F&& f) const& noexcept(std::is_nothrow_invocable_r_v<T, F> &&
+                                                     std::is_nothrow_copy_constructible_v<T>)
+    {
+      return has_value() ? **this : static_cast<T>(std::invoke(std::forward<F>(f)));
+    }
+    template<typename F>
+    constexpr T value_or_else(F&& f) && noexcept(std::is_nothrow_invocable_r_v<T, F> &&
+                                                 std::is_nothrow_move_constructible_v<T>)
+    {
+      return has_value() ? std::move(**this) : static_cast<T>(std::invoke(std::forward<F>(f)));
+    }
+
     // modifiers
-    void reset() noexcept(noexcept(traits_type::null_value())) { storage_ = traits_type::null_value(); }
+    constexpr void reset() noexcept(noexcept(traits_type::null_value())) { storage_ = traits_type::null_value(); }
+  };
+
+  namespace detail {
+
+    // raw access to the storage of opt<T, Policy> used to implement policies for nested opt objects
+    struct opt_access {
+      template<typename T, typename P>
+      static constexpr const auto& storage(const opt<T, P>& o) noexcept
+      {
+        return o.storage_;
+      }
+
+      template<typename Opt, typename Storage>
+      static constexpr Opt from_storage(const Storage& storage)
+      {
+        return Opt{typename Opt::storage_tag{}, storage};
+      }
+    };
+
+  }  // namespace detail
+
+  // opt-in trait for types whose objects may be relocated (moved to a new address and destroyed at the old one) with
+  // memcpy()/memmove(); true for trivially copyable types and may be specialized for others (i.e. types with a
+  // non-trivial destructor owning a heap buffer but no pointers to themselves)
+  template<typename T>
+  struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+  };
+
+  // opt<T, Policy> is relocatable if its storage is
+  template<typename T, typename P>
+  struct is_trivially_relocatable<opt<T, P>>
+      : is_trivially_relocatable<typename opt_policy_traits<T, P>::storage_type> {
+  };
+
+  template<typename T>
+  inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+  // opt<opt<T, P>> uses the next unused niche of the inner opt<T, P> as its null value so it has the same size as T
+  template<typename T, typename P>
+    requires(opt_policy_traits<T, P>::niche_count > 1)
+  struct opt_default_policy<opt<T, P>> {
+  private:
+    using inner_traits = opt_policy_traits<T, P>;
+
+  public:
+    static constexpr std::size_t niche_count = inner_traits::niche_count - 1;
+
+    static constexpr opt<T, P> niche_value(std::size_t i)
+    {
+      assert(i < niche_count);
+      return detail::opt_access::from_storage<opt<T, P>>(inner_traits::niche_value(i + 1));
+    }
+
+    // inner niche 0 (an empty inner opt) is a value of the outer one
+    static constexpr std::size_t niche_index(const opt<T, P>& value)
+    {
+      const auto i = inner_traits::niche_index(detail::opt_access::storage(value));
+      return i == 0 || i == inner_traits::niche_count ? niche_count : i - 1;
+    }
+
+    static constexpr opt<T, P> null_value() { return niche_value(0); }
+    static constexpr bool has_value(const opt<T, P>& value)
+    {
+      return inner_traits::niche_index(detail::opt_access::storage(value)) != 1;
+    }
   };
 
   // relational operators
@@ -261,11 +570,82 @@ namespace mp {
     return !(lhs == rhs);
   }
 
+  namespace detail {
+
+    template<typename T, typename P>
+    inline constexpr bool nulls_first = opt_policy_traits<T, P>::null_order == opt_null_order::first;
+
+    template<typename T, typename P, typename U, typename R>
+    constexpr bool common_nulls_first() noexcept
+    {
+      static_assert(opt_policy_traits<T, P>::null_order == opt_policy_traits<U, R>::null_order,
+                    "'opt' objects with different null orders are not comparable, consider using the same "
+                    "'Policy::null_order'");
+      return nulls_first<T, P>;
+    }
+
+    // values stored directly in opt with a bitwise null (integral ones or floating-point ones with a NaN null as for
+    // opt_nan_policy<T>) are compared without branches: the null value is treated as a key that sorts to the chosen
+    // end and emptiness flags are combined with the result of comparing the raw values
+    template<typename T, typename P>
+    constexpr int branchless_order() noexcept
+    {
+      using traits = opt_policy_traits<T, P>;
+      if constexpr(!std::is_same_v<typename traits::storage_type, T> || !traits::bitwise_null)
+        return 0;
+      else if constexpr((std::is_integral_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>)
+        return 1;
+      else if constexpr(std::is_floating_point_v<T>) {
+        // NaN null is unordered with everything so comparing raw values is already false for any empty object
+        constexpr T null = traits::null_value();
+        return null != null ? 2 : 0;
+      }
+      else
+        return 0;
+    }
+
+    // bitwise operations on unsigned flags instead of `&&` and `?:` as compilers tend to turn those into branches
+    template<typename T, typename P, typename U, typename R>
+    constexpr bool branchless_less(const opt<T, P>& lhs, const opt<U, R>& rhs)
+    {
+      constexpr bool first = common_nulls_first<T, P, U, R>();
+      constexpr int order = std::is_same_v<opt<T, P>, opt<U, R>> ? branchless_order<T, P>() : 0;
+      if constexpr(order != 0) {
+        const unsigned l = lhs.has_value(), r = rhs.has_value();
+        unsigned less = opt_access::storage(lhs) < opt_access::storage(rhs);
+        if constexpr(order == 1) less &= l & r;
+        return (less | (first ? (l ^ 1u) & r : l & (r ^ 1u))) != 0;
+      }
+      else {
+        const bool l = lhs.has_value(), r = rhs.has_value();
+        if(l && r) return *lhs < *rhs;
+        return first ? !l && r : l && !r;
+      }
+    }
+
+  }  // namespace detail
+
+  // the same ordering as operator<, computed without branches for values stored directly with a bitwise null; it pays
+  // off where the result is consumed without branching (e.g. std::max_element() or counting ordered pairs) but slows
+  // down std::sort(), which branches on every comparison anyway, so it is not used by operator<
+  struct opt_branchless_less {
+    using is_transparent = void;
+
+    template<typename T, typename P, typename U, typename R>
+    constexpr bool operator()(const opt<T, P>& lhs, const opt<U, R>& rhs) const
+    {
+      return detail::branchless_less(lhs, rhs);
+    }
+  };
+
 #ifdef OPT_REL_OPS
   template<typename T, typename P, typename U, typename R>
   constexpr bool operator<(const opt<T, P>& lhs, const opt<U, R>& rhs)
   {
-    return (!rhs) ? false : (!lhs) ? true : *lhs < *rhs;
+    if constexpr(detail::common_nulls_first<T, P, U, R>())
+      return (!rhs) ? false : (!lhs) ? true : *lhs < *rhs;
+    else
+      return (!lhs) ? false : (!rhs) ? true : *lhs < *rhs;
   }
 
   template<typename T, typename P, typename U, typename R>
@@ -285,6 +665,36 @@ namespace mp {
   {
     return !(lhs < rhs);
   }
+
+  // not constrained with concepts (the return type is SFINAE-friendly) so that for `a < b` the above operators are
+  // still a better match than a rewritten operator<=>()
+  template<typename T, typename P, typename U, typename R>
+  constexpr std::compare_three_way_result_t<T, U> operator<=>(const opt<T, P>& lhs, const opt<U, R>& rhs)
+  {
+    constexpr bool first = detail::common_nulls_first<T, P, U, R>();
+    if constexpr(std::is_same_v<opt<T, P>, opt<U, R>> && detail::branchless_order<T, P>() == 1) {
+      using detail::branchless_less;
+      return static_cast<int>(branchless_less(rhs, lhs)) - static_cast<int>(branchless_less(lhs, rhs)) <=> 0;
+    }
+    else {
+      const bool l = lhs.has_value(), r = rhs.has_value();
+      if(l && r) return *lhs <=> *rhs;
+      return first ? l <=> r : r <=> l;
+    }
+  }
+
+  template<typename T, typename P>
+  constexpr std::strong_ordering operator<=>(const opt<T, P>& o, std::nullopt_t) noexcept
+  {
+    return detail::nulls_first<T, P> ? o.has_value() <=> false : false <=> o.has_value();
+  }
+
+  template<typename T, typename P, typename U, detail::Requires<std::negation<detail::is_opt<U>>> = true>
+  constexpr std::compare_three_way_result_t<T, U> operator<=>(const opt<T, P>& o, const U& value)
+  {
+    if(o) return *o <=> value;
+    return detail::nulls_first<T, P> ? std::strong_ordering::less : std::strong_ordering::greater;
+  }
 #endif
 
   // clang-format off
@@ -295,14 +705,14 @@ namespace mp {
 	template<typename T, typename P> constexpr bool operator!=(std::nullopt_t, const opt<T, P>& o) noexcept { return static_cast<bool>(o); }
 
 #ifdef OPT_REL_OPS
-  template<typename T, typename P> constexpr bool operator< (const opt<T, P>&, std::nullopt_t) noexcept { return false; }
-	template<typename T, typename P> constexpr bool operator< (std::nullopt_t, const opt<T, P>& o) noexcept { return static_cast<bool>(o); }
-	template<typename T, typename P> constexpr bool operator<=(const opt<T, P>& o, std::nullopt_t) noexcept { return !o; }
-	template<typename T, typename P> constexpr bool operator<=(std::nullopt_t, const opt<T, P>&) noexcept { return true; }
-	template<typename T, typename P> constexpr bool operator> (const opt<T, P>& o, std::nullopt_t) noexcept { return static_cast<bool>(o); }
-	template<typename T, typename P> constexpr bool operator> (std::nullopt_t, const opt<T, P>&) noexcept { return false; }
-	template<typename T, typename P> constexpr bool operator>=(const opt<T, P>&, std::nullopt_t) noexcept { return true; }
-	template<typename T, typename P> constexpr bool operator>=(std::nullopt_t, const opt<T, P>& o) noexcept { return !o; }
+  template<typename T, typename P> constexpr bool operator< (const opt<T, P>& o, std::nullopt_t) noexcept { return !detail::nulls_first<T, P> && o; }
+	template<typename T, typename P> constexpr bool operator< (std::nullopt_t, const opt<T, P>& o) noexcept { return detail::nulls_first<T, P> && o; }
+	template<typename T, typename P> constexpr bool operator<=(const opt<T, P>& o, std::nullopt_t) noexcept { return !detail::nulls_first<T, P> || !o; }
+	template<typename T, typename P> constexpr bool operator<=(std::nullopt_t, const opt<T, P>& o) noexcept { return detail::nulls_first<T, P> || !o; }
+	template<typename T, typename P> constexpr bool operator> (const opt<T, P>& o, std::nullopt_t) noexcept { return detail::nulls_first<T, P> && o; }
+	template<typename T, typename P> constexpr bool operator> (std::nullopt_t, const opt<T, P>& o) noexcept { return !detail::nulls_first<T, P> && o; }
+	template<typename T, typename P> constexpr bool operator>=(const opt<T, P>& o, std::nullopt_t) noexcept { return detail::nulls_first<T, P> || !o; }
+	template<typename T, typename P> constexpr bool operator>=(std::nullopt_t, const opt<T, P>& o) noexcept { return !detail::nulls_first<T, P> || !o; }
 #endif
 
 	// comparison with T
@@ -312,14 +722,14 @@ namespace mp {
 	template<typename T, typename P, typename U> constexpr bool operator!=(const U& value, const opt<T, P>& o) { return !o || value != *o; }
 
 #ifdef OPT_REL_OPS
-	template<typename T, typename P, typename U> constexpr bool operator< (const opt<T, P>& o, const U& value) { return !o || *o < value; }
-	template<typename T, typename P, typename U> constexpr bool operator< (const U& value, const opt<T, P>& o) { return  o && value < *o; }
-	template<typename T, typename P, typename U> constexpr bool operator<=(const opt<T, P>& o, const U& value) { return !o || *o <= value; }
-	template<typename T, typename P, typename U> constexpr bool operator<=(const U& value, const opt<T, P>& o) { return  o && value <= *o; }
-	template<typename T, typename P, typename U> constexpr bool operator> (const opt<T, P>& o, const U& value) { return  o && *o > value; }
-	template<typename T, typename P, typename U> constexpr bool operator> (const U& value, const opt<T, P>& o) { return !o || value > *o; }
-	template<typename T, typename P, typename U> constexpr bool operator>=(const opt<T, P>& o, const U& value) { return  o && *o >= value; }
-	template<typename T, typename P, typename U> constexpr bool operator>=(const U& value, const opt<T, P>& o) { return !o || value >= *o; }
+	template<typename T, typename P, typename U> constexpr bool operator< (const opt<T, P>& o, const U& value) { return o ? *o < value : detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator< (const U& value, const opt<T, P>& o) { return o ? value < *o : !detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator<=(const opt<T, P>& o, const U& value) { return o ? *o <= value : detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator<=(const U& value, const opt<T, P>& o) { return o ? value <= *o : !detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator> (const opt<T, P>& o, const U& value) { return o ? *o > value : !detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator> (const U& value, const opt<T, P>& o) { return o ? value > *o : detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator>=(const opt<T, P>& o, const U& value) { return o ? *o >= value : !detail::nulls_first<T, P>; }
+	template<typename T, typename P, typename U> constexpr bool operator>=(const U& value, const opt<T, P>& o) { return o ? value >= *o : detail::nulls_first<T, P>; }
 #endif
   // clang-format on
 }
@@ -328,14 +738,13 @@ namespace mp {
 namespace std {
 
   template<typename T, typename P>
-  inline void swap(mp::opt<T, P>& lhs, mp::opt<T, P>& rhs) noexcept(noexcept(lhs.swap(rhs)))
+  constexpr void swap(mp::opt<T, P>& lhs, mp::opt<T, P>& rhs) noexcept(noexcept(lhs.swap(rhs)))
   {
     lhs.swap(rhs);
   }
 
   // hash support
-  // template<typename T>
-  // struct hash;
-  // template<typename T, typename P>
-  // struct hash<opt<T, P>>;
+  template<typename T, typename P>
+  struct hash<mp::opt<T, P>> : mp::detail::opt_hash_base<T, P> {
+  };
 }
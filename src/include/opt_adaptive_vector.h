@@ -0,0 +1,273 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt_algorithms.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace mp {
+
+  // Sequence of opt<T, Policy> elements stored in blocks of block_size rows. Every block is kept in one of the
+  // representations:
+  // - empty - no memory is allocated
+  // - sparse - sorted positions of not empty rows and their values
+  // - dense - plain array of opt<T, Policy>
+  //
+  // A block is converted to dense when the number of its values exceeds to_dense_threshold (half of the count at
+  // which sparse storage would use the same memory) and back to sparse when it drops below to_sparse_threshold.
+  // The gap between the thresholds prevents a block from changing its representation on every assignment.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class opt_adaptive_vector {
+  public:
+    using value_type = opt<T, Policy>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr size_type block_size = 4096;
+    static constexpr size_type sparse_entry_size = sizeof(std::uint16_t) + sizeof(T);
+    static constexpr size_type to_dense_threshold = block_size * sizeof(value_type) / sparse_entry_size / 2;
+    static constexpr size_type to_sparse_threshold = to_dense_threshold / 2;
+
+    enum class block_kind { empty, sparse, dense };
+
+    class const_iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = opt_adaptive_vector::value_type;
+      using difference_type = std::ptrdiff_t;
+      using reference = value_type;
+      using pointer = void;
+
+      const_iterator() = default;
+
+      value_type operator*() const
+      {
+        const auto& b = v_->blocks_[i_ / block_size];
+        switch(b.kind) {
+          case block_kind::dense:
+            return b.dense[i_ % block_size];
+          case block_kind::sparse:
+            return cursor_ < b.positions.size() && b.positions[cursor_] == i_ % block_size ? value_type{b.values[cursor_]}
+                                                                                              : value_type{};
+          default:
+            return value_type{};
+        }
+      }
+
+      const_iterator& operator++()
+      {
+        const auto& b = v_->blocks_[i_ / block_size];
+        if(b.kind == block_kind::sparse && cursor_ < b.positions.size() && b.positions[cursor_] == i_ % block_size)
+          ++cursor_;
+        if(++i_ % block_size == 0) cursor_ = 0;
+        return *this;
+      }
+      const_iterator operator++(int)
+      {
+        auto it = *this;
+        ++*this;
+        return it;
+      }
+
+      friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept { return lhs.i_ == rhs.i_; }
+
+    private:
+      friend class opt_adaptive_vector;
+      const opt_adaptive_vector* v_ = nullptr;
+      size_type i_ = 0;
+      size_type cursor_ = 0;  // first position in a sparse block not smaller than i_ % block_size
+
+      const_iterator(const opt_adaptive_vector* v, size_type i) : v_{v}, i_{i} {}
+    };
+    using iterator = const_iterator;
+
+    opt_adaptive_vector() = default;
+    explicit opt_adaptive_vector(size_type count) { resize(count); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    const_iterator begin() const noexcept { return {this, 0}; }
+    const_iterator end() const noexcept { return {this, size_}; }
+
+    // elements are returned by value as sparse blocks do not store empty ones
+    value_type operator[](size_type i) const
+    {
+      assert(i < size_);
+      const auto& b = blocks_[i / block_size];
+      const auto off = static_cast<std::uint16_t>(i % block_size);
+      switch(b.kind) {
+        case block_kind::dense:
+          return b.dense[off];
+        case block_kind::sparse: {
+          const auto it = std::lower_bound(b.positions.begin(), b.positions.end(), off);
+          return it != b.positions.end() && *it == off ? value_type{b.values[static_cast<size_type>(it - b.positions.begin())]}
+                                                       : value_type{};
+        }
+        default:
+          return value_type{};
+      }
+    }
+
+    void set(size_type i, const value_type& value)
+    {
+      assert(i < size_);
+      auto& b = blocks_[i / block_size];
+      const auto off = static_cast<std::uint16_t>(i % block_size);
+      if(b.kind == block_kind::dense) {
+        auto& slot = b.dense[off];
+        b.count = b.count - slot.has_value() + value.has_value();
+        slot = value;
+        if(b.count < to_sparse_threshold) to_sparse(b);
+        return;
+      }
+
+      const auto it = std::lower_bound(b.positions.begin(), b.positions.end(), off);
+      const auto k = it - b.positions.begin();
+      const bool found = it != b.positions.end() && *it == off;
+      if(value.has_value()) {
+        if(found) {
+          b.values[static_cast<size_type>(k)] = *value;
+          return;
+        }
+        b.positions.insert(it, off);
+        b.values.insert(b.values.begin() + k, *value);
+        b.kind = block_kind::sparse;
+        if(++b.count > to_dense_threshold) to_dense(b);
+      }
+      else if(found) {
+        b.positions.erase(it);
+        b.values.erase(b.values.begin() + k);
+        if(--b.count == 0) b = block{};
+      }
+    }
+    void reset(size_type i) { set(i, value_type{}); }
+
+    void push_back(const value_type& value)
+    {
+      resize(size_ + 1);
+      if(value.has_value()) set(size_ - 1, value);
+    }
+
+    // new elements are empty
+    void resize(size_type count)
+    {
+      if(count < size_) {
+        // reset the elements removed from the last kept block
+        for(size_type i = count; i < std::min(size_, (count + block_size - 1) / block_size * block_size); ++i) reset(i);
+      }
+      blocks_.resize((count + block_size - 1) / block_size);
+      size_ = count;
+    }
+
+    void clear() noexcept
+    {
+      blocks_.clear();
+      size_ = 0;
+    }
+
+    // number of not empty elements
+    size_type count_values() const noexcept
+    {
+      size_type count = 0;
+      for(const auto& b : blocks_) count += b.count;
+      return count;
+    }
+
+    // calls f(index, value) for all not empty elements in order; empty blocks are skipped in O(1)
+    template<typename F>
+    void for_each_value(F&& f) const
+    {
+      for(size_type n = 0; n < blocks_.size(); ++n) {
+        const auto& b = blocks_[n];
+        const size_type first = n * block_size;
+        if(b.kind == block_kind::dense) {
+          const std::span<const value_type> values{b.dense.data(), std::min(block_size, size_ - first)};
+          for(size_type i = find_first_value(values); i < values.size(); ++i)
+            if(values[i].has_value()) f(first + i, *values[i]);
+        }
+        else {
+          for(size_type k = 0; k < b.positions.size(); ++k) f(first + b.positions[k], b.values[k]);
+        }
+      }
+    }
+
+    block_kind kind_of_block(size_type n) const noexcept { return blocks_[n].kind; }
+
+    // bytes allocated for the elements (excluding the block table)
+    size_type memory_usage() const noexcept
+    {
+      size_type bytes = 0;
+      for(const auto& b : blocks_)
+        bytes += b.dense.capacity() * sizeof(value_type) + b.positions.capacity() * sizeof(std::uint16_t) +
+                 b.values.capacity() * sizeof(T);
+      return bytes;
+    }
+
+  private:
+    struct block {
+      block_kind kind = block_kind::empty;
+      size_type count = 0;
+      std::vector<std::uint16_t> positions;  // sparse
+      std::vector<T> values;                 // sparse
+      std::vector<value_type> dense;
+    };
+
+    std::vector<block> blocks_;
+    size_type size_ = 0;
+
+    static void to_dense(block& b)
+    {
+      b.dense.assign(block_size, value_type{});
+      for(size_type k = 0; k < b.positions.size(); ++k) b.dense[b.positions[k]] = value_type{std::move(b.values[k])};
+      // release the memory (assignment of `{}` would keep the capacity)
+      b.positions = std::vector<std::uint16_t>{};
+      b.values = std::vector<T>{};
+      b.kind = block_kind::dense;
+    }
+
+    static void to_sparse(block& b)
+    {
+      if(b.count == 0) {
+        b = block{};
+        return;
+      }
+      b.positions.reserve(b.count);
+      b.values.reserve(b.count);
+      for(size_type i = 0; i < block_size; ++i)
+        if(b.dense[i].has_value()) {
+          b.positions.push_back(static_cast<std::uint16_t>(i));
+          b.values.push_back(std::move(*b.dense[i]));
+        }
+      b.dense = std::vector<value_type>{};
+      b.kind = block_kind::sparse;
+    }
+  };
+
+}
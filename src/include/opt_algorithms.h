@@ -0,0 +1,275 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include "opt_simd.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <span>
+
+namespace mp {
+
+  namespace detail {
+
+    template<typename Opt>
+    using opt_traits_t = typename std::remove_const_t<Opt>::traits_type;
+
+    template<typename Opt>
+    using opt_storage_t = typename opt_traits_t<Opt>::storage_type;
+
+    // storage of opt<T, Policy> may be processed as raw integers compared with Policy::null_value() bit pattern
+    template<typename Opt>
+    inline constexpr bool is_raw_opt = opt_traits_t<Opt>::bitwise_null && simd::has_raw_type<opt_storage_t<Opt>> &&
+                                       sizeof(Opt) == sizeof(opt_storage_t<Opt>);
+
+    // additionally the raw storage is a value of type T
+    template<typename Opt>
+    inline constexpr bool is_raw_value_opt =
+        is_raw_opt<Opt> && std::is_same_v<opt_storage_t<Opt>, typename std::remove_const_t<Opt>::value_type>;
+
+    template<typename Opt>
+    inline auto raw_null() noexcept
+    {
+      return simd::to_raw(opt_storage_t<Opt>{opt_traits_t<Opt>::null_value()});
+    }
+
+    template<typename Opt>
+    using has_value_noexcept = std::bool_constant<noexcept(std::declval<const Opt&>().has_value())>;
+
+    // integral, enumeration and floating-point values are hashed with simd::hash_mix() of their 64-bit key
+    template<typename T>
+    using is_mixable =
+        std::disjunction<std::is_integral<T>, std::is_enum<T>,
+                         std::conjunction<std::is_floating_point<T>, std::bool_constant<sizeof(T) <= sizeof(double)>>>;
+
+    // equal values have equal keys (i.e. -0.0 and 0.0, 1 and 1L)
+    template<typename T>
+    constexpr std::uint64_t hash_key(T v) noexcept
+    {
+      if constexpr(std::is_enum_v<T>)
+        return hash_key(static_cast<std::underlying_type_t<T>>(v));
+      else if constexpr(std::is_floating_point_v<T>)
+        return v == 0 ? 0 : std::bit_cast<std::uint64_t>(static_cast<double>(v));
+      else
+        return static_cast<std::uint64_t>(v);
+    }
+
+  }  // namespace detail
+
+  // Bulk algorithms over contiguous ranges of opt<T, Policy>
+  //
+  // If storage_type is an integral type and Policy does not provide custom has_value() the elements are compared
+  // against Policy::null_value() bit pattern with SSE2/AVX2/AVX-512 instructions (depending on the target ISA).
+  // Otherwise they fall back to opt<T, Policy>::has_value() called for every element.
+
+  // number of not empty elements
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::size_t count_values(std::span<Opt, Extent> values) noexcept(detail::has_value_noexcept<Opt>::value)
+  {
+    if constexpr(detail::is_raw_opt<Opt>) {
+      return values.size() - detail::simd::count_eq(values.data(), values.size(), detail::raw_null<Opt>());
+    }
+    else {
+      std::size_t count = 0;
+      for(const auto& v : values)
+        count += v.has_value();
+      return count;
+    }
+  }
+
+  // index of the first empty element or values.size() if there is none
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::size_t find_first_null(std::span<Opt, Extent> values) noexcept(detail::has_value_noexcept<Opt>::value)
+  {
+    if constexpr(detail::is_raw_opt<Opt>) {
+      return detail::simd::find_eq(values.data(), values.size(), detail::raw_null<Opt>());
+    }
+    else {
+      for(std::size_t i = 0; i < values.size(); ++i)
+        if(!values[i].has_value()) return i;
+      return values.size();
+    }
+  }
+
+  // index of the first not empty element or values.size() if there is none
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::size_t find_first_value(std::span<Opt, Extent> values) noexcept(detail::has_value_noexcept<Opt>::value)
+  {
+    if constexpr(detail::is_raw_opt<Opt>) {
+      return detail::simd::find_ne(values.data(), values.size(), detail::raw_null<Opt>());
+    }
+    else {
+      for(std::size_t i = 0; i < values.size(); ++i)
+        if(values[i].has_value()) return i;
+      return values.size();
+    }
+  }
+
+  // resets all elements
+  template<typename T, typename P, std::size_t Extent>
+  void fill_null(std::span<opt<T, P>, Extent> values) noexcept(noexcept(std::declval<opt<T, P>&>().reset()))
+  {
+    if constexpr(detail::is_raw_opt<opt<T, P>>) {
+      detail::simd::fill(values.data(), values.size(), detail::raw_null<opt<T, P>>());
+    }
+    else {
+      for(auto& v : values)
+        v.reset();
+    }
+  }
+
+  // out[i] = values[i].value_or(default_value)
+  template<typename Opt, std::size_t Extent1, typename T, std::size_t Extent2,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>,
+                            std::is_same<typename std::remove_const_t<Opt>::value_type, T>> = true>
+  void value_or_into(std::span<Opt, Extent1> values, std::span<T, Extent2> out, const std::type_identity_t<T>& default_value)
+  {
+    assert(out.size() >= values.size());
+    if constexpr(detail::is_raw_value_opt<Opt>) {
+      detail::simd::replace_eq(values.data(), out.data(), values.size(), detail::raw_null<Opt>(),
+                               detail::simd::to_raw(default_value));
+    }
+    else {
+      for(std::size_t i = 0; i < values.size(); ++i)
+        out[i] = values[i].value_or(default_value);
+    }
+  }
+
+  // assigns value to all empty elements
+  template<typename T, typename P, std::size_t Extent>
+  void replace_nulls(std::span<opt<T, P>, Extent> values, const std::type_identity_t<T>& value)
+  {
+    if constexpr(detail::is_raw_value_opt<opt<T, P>>) {
+      const auto raw = detail::simd::to_raw(value);
+      assert((raw != detail::raw_null<opt<T, P>>()));
+      detail::simd::replace_eq(values.data(), values.data(), values.size(), detail::raw_null<opt<T, P>>(), raw);
+    }
+    else {
+      for(auto& v : values)
+        if(!v.has_value()) v = value;
+    }
+  }
+
+  // Validity bitmap interoperability (e.g. with Apache Arrow)
+  //
+  // Bit i % 8 of bitmap[i / 8] is set if the i-th element has a value (LSB bit order). If storage_type is T (so the
+  // null value is a valid T object as well) the opt<T, Policy> buffer may be used as a values buffer without any
+  // copying (see as_values() and as_opts()).
+
+  // span of values sharing the memory with opt<T, Policy> elements (empty elements contain Policy::null_value())
+  template<typename Opt, std::size_t Extent,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>,
+                            std::bool_constant<detail::is_raw_value_opt<Opt>>> = true>
+  auto as_values(std::span<Opt, Extent> values) noexcept
+  {
+    using value_type = typename std::remove_const_t<Opt>::value_type;
+    using result_type = std::conditional_t<std::is_const_v<Opt>, const value_type, value_type>;
+    return std::span<result_type, Extent>{reinterpret_cast<result_type*>(values.data()), values.size()};
+  }
+
+  // span of opt<T, Policy> elements sharing the memory with values
+  template<typename Policy, typename T, std::size_t Extent,
+           detail::Requires<std::bool_constant<detail::is_raw_value_opt<opt<std::remove_const_t<T>, Policy>>>> = true>
+  auto as_opts(std::span<T, Extent> values) noexcept
+  {
+    using opt_type = opt<std::remove_const_t<T>, Policy>;
+    using result_type = std::conditional_t<std::is_const_v<T>, const opt_type, opt_type>;
+    return std::span<result_type, Extent>{reinterpret_cast<result_type*>(values.data()), values.size()};
+  }
+
+  // writes validity bitmap of values (bitmap.size() >= (values.size() + 7) / 8)
+  template<typename Opt, std::size_t Extent1, std::size_t Extent2,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  void to_validity_bitmap(std::span<Opt, Extent1> values, std::span<std::uint8_t, Extent2> bitmap) noexcept(
+      detail::has_value_noexcept<Opt>::value)
+  {
+    assert(bitmap.size() >= (values.size() + 7) / 8);
+    std::size_t i = 0;
+    if constexpr(detail::is_raw_opt<Opt>) {
+      const auto null = detail::raw_null<Opt>();
+      for(; i + 64 <= values.size(); i += 64)
+        detail::simd::store_le64(bitmap.data() + i / 8, ~detail::simd::eq_mask64(values.data() + i, null));
+    }
+    for(; i < values.size(); i += 8) {
+      std::uint8_t byte = 0;
+      for(std::size_t j = 0; j < 8 && i + j < values.size(); ++j)
+        byte |= static_cast<std::uint8_t>(values[i + j].has_value() << j);
+      bitmap[i / 8] = byte;
+    }
+  }
+
+  // out[i] = values[i] if i-th bit of bitmap is set, empty otherwise
+  //
+  // values and out may share the same memory (see as_opts())
+  template<typename V, std::size_t Extent1, typename B, std::size_t Extent2, typename T, typename P,
+           std::size_t Extent3,
+           detail::Requires<std::is_same<std::remove_const_t<V>, T>, std::is_same<std::remove_const_t<B>, std::uint8_t>> =
+               true>
+  void from_validity_bitmap(std::span<V, Extent1> values, std::span<B, Extent2> bitmap, std::span<opt<T, P>, Extent3> out)
+  {
+    assert(out.size() >= values.size());
+    assert(bitmap.size() >= (values.size() + 7) / 8);
+    std::size_t i = 0;
+    if constexpr(detail::is_raw_value_opt<opt<T, P>>) {
+      const auto null = detail::raw_null<opt<T, P>>();
+      for(; i + 64 <= values.size(); i += 64)
+        detail::simd::select_mask64(values.data() + i, out.data() + i, detail::simd::load_le64(bitmap.data() + i / 8),
+                                    null);
+    }
+    for(; i < values.size(); ++i) {
+      if((bitmap[i / 8] >> (i % 8)) & 1)
+        out[i] = values[i];
+      else
+        out[i].reset();
+    }
+  }
+
+  // Hashing
+  //
+  // out[i] is a 64-bit mix of the i-th value (truncated to std::size_t) or a fixed hash for an empty element. Unlike
+  // std::hash<T> (an identity function for integers in most of the implementations) every bit of the result depends
+  // on all bits of the value so any subset of bits may be used for hash partitioning. Note that the result is not
+  // equal to std::hash<opt<T, Policy>>.
+  template<typename Opt, std::size_t Extent1, std::size_t Extent2,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>,
+                            detail::is_mixable<typename std::remove_const_t<Opt>::value_type>> = true>
+  void hash_many(std::span<Opt, Extent1> values, std::span<std::size_t, Extent2> out)
+  {
+    assert(out.size() >= values.size());
+    using value_type = typename std::remove_const_t<Opt>::value_type;
+    // keys are gathered to a small buffer so that the mixing is done in SIMD registers
+    constexpr std::size_t block_size = 256;
+    std::uint64_t keys[block_size];
+    for(std::size_t i = 0; i < values.size(); i += block_size) {
+      const auto count = std::min(block_size, values.size() - i);
+      for(std::size_t j = 0; j < count; ++j)
+        keys[j] = detail::hash_key(values[i + j].value_or(value_type{}));
+      detail::simd::hash_mix(keys, keys, count);
+      for(std::size_t j = 0; j < count; ++j)
+        out[i + j] = values[i + j].has_value() ? static_cast<std::size_t>(keys[j]) : detail::opt_null_hash;
+    }
+  }
+
+}
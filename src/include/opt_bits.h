@@ -25,14 +25,57 @@
 #include <optional>
 #include <type_traits>
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+
+// default checking mode of opt<T, Policy> (the name of one of opt_checking enumerators); may be overridden by
+// Policy::checking
+#ifndef OPT_CHECKING
+#define OPT_CHECKING standard
+#endif
+
+// default position of empty objects in the ordering of opt<T, Policy> (the name of one of opt_null_order
+// enumerators); may be overridden by Policy::null_order
+#ifndef OPT_NULL_ORDER
+#define OPT_NULL_ORDER first
+#endif
 
 namespace mp {
 
+  template<typename T>
+  struct opt_default_policy;
+
+  // reaction to operator*(), operator->() or value() called for an empty opt<T, Policy>
+  enum class opt_checking {
+    standard,   // assert() in operator*() and operator->(), std::bad_optional_access thrown from value()
+    assertion,  // assert() everywhere (no checks with NDEBUG)
+    exception,  // std::bad_optional_access thrown everywhere
+    assume,     // assert(), with NDEBUG the compiler assumes the object is not empty and drops redundant checks
+    trap,       // abnormal termination with a trap instruction
+    callback    // call to mp::opt_check_failed() that has to be defined by the user
+  };
+
+  inline constexpr opt_checking opt_default_checking = opt_checking::OPT_CHECKING;
+
+  // position of empty objects in the ordering defined by relational operators
+  enum class opt_null_order {
+    first,  // an empty object is less than any value (as for std::optional<T>)
+    last    // an empty object is greater than any value
+  };
+
+  inline constexpr opt_null_order opt_default_null_order = opt_null_order::OPT_NULL_ORDER;
+
+  // called in opt_checking::callback mode; has to be defined by the user and should not return
+  [[noreturn]] void opt_check_failed();
+
   template<typename T, typename Policy>
   class opt;
 
   namespace detail {
 
+    struct opt_access;
+
     template<typename... Args>
     using Requires = std::enable_if_t<std::conjunction<Args...>::value, bool>;
 
@@ -51,6 +94,10 @@ namespace mp {
                          std::is_convertible<opt<U, P>&, T>, std::is_convertible<const opt<U, P>&, T>,
                          std::is_convertible<opt<U, P>&&, T>, std::is_convertible<const opt<U, P>&&, T>>;
 
+    // opt<U, P> should not be converted to T == bool with its operator bool()
+    template<typename T, typename U>
+    using converts_opt_to_bool = std::conjunction<std::is_same<std::decay_t<T>, bool>, is_opt<std::decay_t<U>>>;
+
     template<typename T, typename U, typename P>
     using assigns_from_opt =
         std::disjunction<std::is_assignable<T&, opt<U, P>&>, std::is_assignable<T&, const opt<U, P>&>,
@@ -67,6 +114,31 @@ namespace mp {
     struct has_has_value<T, P, std::void_t<has_value_t<T, P>>> : std::is_same<has_value_t<T, P>, bool> {
     };
 
+    // detect if Policy::bitwise_null is present and true
+    template<typename P, typename = std::void_t<>>
+    struct policy_bitwise_null : std::false_type {
+    };
+    template<typename P>
+    struct policy_bitwise_null<P, std::void_t<decltype(P::bitwise_null)>> : std::bool_constant<P::bitwise_null> {
+    };
+
+    // emptiness of integral storage without Policy::has_value() may be checked with a bitwise comparison, other
+    // policies may declare that their has_value() is equivalent to such a comparison with Policy::bitwise_null
+    template<typename T, typename P>
+    using is_bitwise_null = std::disjunction<std::conjunction<std::disjunction<std::is_integral<T>, std::is_enum<T>>,
+                                                              std::negation<has_has_value<T, P>>>,
+                                             policy_bitwise_null<P>>;
+
+    // detect if Policy::niche_count is present
+    template<typename P, typename = std::void_t<>>
+    struct detect_niche_count : std::integral_constant<std::size_t, 1> {
+    };
+    template<typename P>
+    struct detect_niche_count<P, std::void_t<decltype(P::niche_count)>>
+        : std::integral_constant<std::size_t, P::niche_count> {
+      static_assert(P::niche_count >= 1, "'Policy::niche_count' should include Policy::null_value()");
+    };
+
     // detect if Policy::storage_type is present
     template<typename T, typename Policy, typename = std::void_t<>>
     struct detect_storage_type {
@@ -79,5 +151,138 @@ namespace mp {
                     "'sizeof(Policy::storage_type) != sizeof(T)' consider using std::optional<T>");
     };
 
+    // hash of an empty opt<T, Policy>
+    inline constexpr std::size_t opt_null_hash = static_cast<std::size_t>(0x9E37'79B9'7F4A'7C15);
+
+    // std::hash<opt<T, Policy>> is enabled only if std::hash<T> is enabled
+    template<typename T, typename P, bool = std::is_default_constructible_v<std::hash<std::remove_const_t<T>>>>
+    struct opt_hash_base {
+      opt_hash_base() = delete;
+      opt_hash_base(const opt_hash_base&) = delete;
+      opt_hash_base(opt_hash_base&&) = delete;
+      opt_hash_base& operator=(const opt_hash_base&) = delete;
+      opt_hash_base& operator=(opt_hash_base&&) = delete;
+    };
+
+    template<typename T, typename P>
+    struct opt_hash_base<T, P, true> {
+      std::size_t operator()(const opt<T, P>& o) const
+          noexcept(noexcept(std::hash<std::remove_const_t<T>>{}(std::declval<const T&>())))
+      {
+        return o ? std::hash<std::remove_const_t<T>>{}(*o) : opt_null_hash;
+      }
+    };
+
+    // opt_default_policy<T> specialized for T
+    template<typename T, typename = std::void_t<>>
+    struct has_default_policy : std::false_type {
+    };
+    template<typename T>
+    struct has_default_policy<T, std::void_t<decltype(opt_default_policy<T>::null_value())>> : std::true_type {
+    };
+
+    template<typename T>
+    struct is_std_optional : std::false_type {
+    };
+    template<typename T>
+    struct is_std_optional<std::optional<T>> : std::true_type {
+    };
+
+    // result of opt<T, Policy>::transform(): opt<U> if U has a default policy, std::optional<U> otherwise
+    template<typename F, typename Arg>
+    using transform_value_t = std::remove_cv_t<std::invoke_result_t<F, Arg>>;
+    template<typename F, typename Arg>
+    using transform_result_t = std::conditional_t<has_default_policy<transform_value_t<F, Arg>>::value,
+                                                  opt<transform_value_t<F, Arg>, opt_default_policy<transform_value_t<F, Arg>>>,
+                                                  std::optional<transform_value_t<F, Arg>>>;
+
+    struct invoke_tag {
+    };
+
+    [[noreturn]] inline void unreachable() noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_unreachable();
+#elif defined(_MSC_VER)
+      __assume(false);
+#endif
+    }
+
+    // lets the optimizer assume that cond is true; unlike `if(!cond) unreachable();` the dedicated builtins do not add
+    // control flow that could prevent vectorization of loops
+    constexpr void assume(bool cond) noexcept
+    {
+#if defined(__clang__)
+      __builtin_assume(cond);
+#elif defined(_MSC_VER)
+      __assume(cond);
+#elif defined(__GNUC__) && __GNUC__ >= 13
+      __attribute__((assume(cond)));
+#else
+      if(!cond) unreachable();
+#endif
+    }
+
+    [[noreturn]] inline void trap() noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_trap();
+#else
+      std::abort();
+#endif
+    }
+
+    // detect if Policy::checking is present
+    template<typename P, typename = std::void_t<>>
+    struct detect_checking : std::integral_constant<opt_checking, opt_default_checking> {
+    };
+    template<typename P>
+    struct detect_checking<P, std::void_t<decltype(P::checking)>> : std::integral_constant<opt_checking, P::checking> {
+    };
+
+    // detect if Policy::null_order is present
+    template<typename P, typename = std::void_t<>>
+    struct detect_null_order : std::integral_constant<opt_null_order, opt_default_null_order> {
+    };
+    template<typename P>
+    struct detect_null_order<P, std::void_t<decltype(P::null_order)>>
+        : std::integral_constant<opt_null_order, P::null_order> {
+    };
+
+    // without exception support (i.e. -fno-exceptions) throwing modes trap instead
+    template<opt_checking Mode>
+    [[noreturn]] void access_failed()
+    {
+      if constexpr(Mode == opt_checking::callback) {
+        opt_check_failed();
+      }
+      else {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        if constexpr(Mode != opt_checking::trap) throw std::bad_optional_access{};
+#endif
+        trap();
+      }
+    }
+
+    // Value is true for value() and false for operator*() and operator->()
+    template<opt_checking Mode, bool Value>
+    constexpr void check_access([[maybe_unused]] bool has_value)
+    {
+      if constexpr(Mode == opt_checking::assertion || (Mode == opt_checking::standard && !Value)) {
+        assert(has_value);
+      }
+      else if constexpr(Mode == opt_checking::assume) {
+#ifdef NDEBUG
+        assume(has_value);
+#else
+        assert(has_value);
+#endif
+      }
+      else {
+        if(!has_value) [[unlikely]]
+          access_failed<Mode>();
+      }
+    }
+
   }  // namespace detail
 }
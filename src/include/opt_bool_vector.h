@@ -0,0 +1,219 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace mp {
+
+  // Vector of three-valued (true, false, unknown) logic values stored in two bit planes: a validity bit (set for
+  // true and false) and a value bit (set only for true). Logical operators implement Kleene logic on 64 elements at
+  // a time:
+  // - unknown AND false == false, unknown AND true == unknown
+  // - unknown OR true == true, unknown OR false == unknown
+  // - NOT unknown == unknown, unknown XOR anything == unknown
+  //
+  // Elements are converted from and to opt<bool, Policy> (empty opt is unknown).
+  template<typename Policy = opt_default_policy<bool>>
+  class opt_bool_vector {
+  public:
+    using value_type = opt<bool, Policy>;
+    using size_type = std::size_t;
+    using word_type = std::uint64_t;
+
+    static constexpr size_type word_bits = 64;
+
+    opt_bool_vector() = default;
+
+    // all elements are unknown
+    explicit opt_bool_vector(size_type count) { resize(count); }
+    explicit opt_bool_vector(std::span<const value_type> values) { assign(values); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // bit planes; bits past size() are 0 (unknown)
+    std::span<const word_type> validity() const noexcept { return valid_; }
+    std::span<const word_type> values() const noexcept { return value_; }
+
+    value_type operator[](size_type i) const noexcept { return get(i); }
+    value_type get(size_type i) const noexcept
+    {
+      assert(i < size_);
+      const auto bit = word_type{1} << (i % word_bits);
+      if((valid_[i / word_bits] & bit) == 0) return value_type{};
+      return value_type{(value_[i / word_bits] & bit) != 0};
+    }
+    void set(size_type i, const value_type& v) noexcept
+    {
+      assert(i < size_);
+      const auto bit = word_type{1} << (i % word_bits);
+      auto& valid = valid_[i / word_bits];
+      auto& value = value_[i / word_bits];
+      valid = v.has_value() ? valid | bit : valid & ~bit;
+      value = v.has_value() && *v ? value | bit : value & ~bit;
+    }
+
+    // new elements are unknown
+    void resize(size_type count)
+    {
+      const auto words = (count + word_bits - 1) / word_bits;
+      valid_.resize(words);
+      value_.resize(words);
+      size_ = count;
+      clear_tail();
+    }
+
+    void assign(std::span<const value_type> values)
+    {
+      const auto words = (values.size() + word_bits - 1) / word_bits;
+      valid_.assign(words, 0);
+      value_.assign(words, 0);
+      size_ = values.size();
+      for(size_type n = 0; n < words; ++n) {
+        const auto first = n * word_bits;
+        const auto count = std::min(word_bits, size_ - first);
+        word_type valid = 0, value = 0;
+        for(size_type j = 0; j < count; ++j) {
+          const auto& v = values[first + j];
+          valid |= word_type{v.has_value()} << j;
+          value |= word_type{v.has_value() && *v} << j;
+        }
+        valid_[n] = valid;
+        value_[n] = value;
+      }
+    }
+
+    // writes all elements to `out` (out.size() == size())
+    void unpack(std::span<value_type> out) const noexcept
+    {
+      assert(out.size() == size_);
+      for(size_type i = 0; i < size_; ++i) {
+        const auto n = i / word_bits;
+        const auto bit = word_type{1} << (i % word_bits);
+        out[i] = (valid_[n] & bit) ? value_type{(value_[n] & bit) != 0} : value_type{};
+      }
+    }
+
+    size_type count_true() const noexcept { return popcount_sum(value_); }
+    size_type count_false() const noexcept { return popcount_sum(valid_) - count_true(); }
+    size_type count_unknown() const noexcept { return size_ - popcount_sum(valid_); }
+
+    // Kleene logic (both operands should have the same size)
+    opt_bool_vector& operator&=(const opt_bool_vector& other) noexcept
+    {
+      return apply(other, [](word_type& valid, word_type& value, word_type other_valid, word_type other_value) {
+        const auto is_true = value & other_value;
+        const auto is_false = (valid & ~value) | (other_valid & ~other_value);
+        valid = is_true | is_false;
+        value = is_true;
+      });
+    }
+    opt_bool_vector& operator|=(const opt_bool_vector& other) noexcept
+    {
+      return apply(other, [](word_type& valid, word_type& value, word_type other_valid, word_type other_value) {
+        const auto is_true = value | other_value;
+        const auto is_false = (valid & ~value) & (other_valid & ~other_value);
+        valid = is_true | is_false;
+        value = is_true;
+      });
+    }
+    opt_bool_vector& operator^=(const opt_bool_vector& other) noexcept
+    {
+      return apply(other, [](word_type& valid, word_type& value, word_type other_valid, word_type other_value) {
+        valid &= other_valid;
+        value = (value ^ other_value) & valid;
+      });
+    }
+
+    // in-place NOT
+    opt_bool_vector& flip() noexcept
+    {
+      for(size_type n = 0; n < valid_.size(); ++n) value_[n] = ~value_[n] & valid_[n];
+      return *this;
+    }
+
+    // the results are returned by name so they are moved and not copied (a copy could throw)
+    friend opt_bool_vector operator&(opt_bool_vector lhs, const opt_bool_vector& rhs) noexcept
+    {
+      lhs &= rhs;
+      return lhs;
+    }
+    friend opt_bool_vector operator|(opt_bool_vector lhs, const opt_bool_vector& rhs) noexcept
+    {
+      lhs |= rhs;
+      return lhs;
+    }
+    friend opt_bool_vector operator^(opt_bool_vector lhs, const opt_bool_vector& rhs) noexcept
+    {
+      lhs ^= rhs;
+      return lhs;
+    }
+    friend opt_bool_vector operator~(opt_bool_vector v) noexcept
+    {
+      v.flip();
+      return v;
+    }
+
+    friend bool operator==(const opt_bool_vector& lhs, const opt_bool_vector& rhs) noexcept
+    {
+      return lhs.size_ == rhs.size_ && lhs.valid_ == rhs.valid_ && lhs.value_ == rhs.value_;
+    }
+
+  private:
+    std::vector<word_type> valid_;
+    std::vector<word_type> value_;  // 0 for unknown elements
+    size_type size_ = 0;
+
+    static size_type popcount_sum(const std::vector<word_type>& words) noexcept
+    {
+      size_type count = 0;
+      for(const auto w : words) count += static_cast<size_type>(std::popcount(w));
+      return count;
+    }
+
+    void clear_tail() noexcept
+    {
+      if(size_ % word_bits == 0) return;
+      const auto mask = (word_type{1} << (size_ % word_bits)) - 1;
+      valid_.back() &= mask;
+      value_.back() &= mask;
+    }
+
+    template<typename F>
+    opt_bool_vector& apply(const opt_bool_vector& other, F f) noexcept
+    {
+      assert(size_ == other.size_);
+      for(size_type n = 0; n < valid_.size(); ++n) f(valid_[n], value_[n], other.valid_[n], other.value_[n]);
+      return *this;
+    }
+  };
+
+}
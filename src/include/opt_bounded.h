@@ -0,0 +1,193 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include "opt_algorithms.h"
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace mp {
+
+  namespace detail {
+
+    // the narrowest unsigned type able to hold codes [0, MaxCode] and one more code for the null value
+    template<std::uintmax_t MaxCode>
+    using bounded_storage_t = std::conditional_t<
+        (MaxCode < std::numeric_limits<std::uint8_t>::max()), std::uint8_t,
+        std::conditional_t<(MaxCode < std::numeric_limits<std::uint16_t>::max()), std::uint16_t,
+                           std::conditional_t<(MaxCode < std::numeric_limits<std::uint32_t>::max()), std::uint32_t,
+                                              std::uint64_t>>>;
+
+  }  // namespace detail
+
+  // Integer from the [Min, Max] range stored as an offset from Min in the narrowest unsigned type that also has room
+  // for a null value (i.e. bounded_int<0, 100> and bounded_int<1900, 2100> take 1 byte, bounded_int<0, 86'399>
+  // takes 4 bytes). Converts implicitly to and from value_type (int if the range fits in it); the range is checked
+  // with assert() on construction.
+  template<std::intmax_t Min, std::intmax_t Max>
+  class bounded_int {
+    static_assert(Min <= Max, "'Min > Max'");
+
+  public:
+    using value_type = std::conditional_t<(Min >= std::numeric_limits<int>::min() &&
+                                           Max <= std::numeric_limits<int>::max()),
+                                          int, std::intmax_t>;
+
+    // codes of the values are [0, max_code]
+    static constexpr std::uintmax_t max_code = static_cast<std::uintmax_t>(Max) - static_cast<std::uintmax_t>(Min);
+    static_assert(max_code < std::numeric_limits<std::uintmax_t>::max(),
+                  "no room for a null value, consider using opt_null_value_policy<std::intmax_t, NullValue>");
+
+    using storage_type = detail::bounded_storage_t<max_code>;
+
+    static constexpr value_type min() noexcept { return Min; }
+    static constexpr value_type max() noexcept { return Max; }
+
+    bounded_int() = default;
+    constexpr bounded_int(value_type v) noexcept : code_{encode(v)} {}
+
+    constexpr operator value_type() const noexcept { return decode(code_); }
+    constexpr value_type value() const noexcept { return decode(code_); }
+
+    // raw offset-encoded representation
+    constexpr storage_type code() const noexcept { return code_; }
+    static constexpr bounded_int from_code(storage_type code) noexcept
+    {
+      bounded_int b;
+      b.code_ = code;
+      return b;
+    }
+
+    static constexpr storage_type encode(value_type v) noexcept
+    {
+      assert(Min <= v && v <= Max && "value out of the [Min, Max] range");
+      return static_cast<storage_type>(static_cast<std::uintmax_t>(v) - static_cast<std::uintmax_t>(Min));
+    }
+    static constexpr value_type decode(storage_type code) noexcept
+    {
+      return static_cast<value_type>(static_cast<std::intmax_t>(static_cast<std::uintmax_t>(code) +
+                                                                static_cast<std::uintmax_t>(Min)));
+    }
+
+  private:
+    storage_type code_;
+  };
+
+  // all codes above max_code are niches and the all-ones code is the null value
+  template<std::intmax_t Min, std::intmax_t Max>
+  struct opt_default_policy<bounded_int<Min, Max>> {
+  private:
+    using type = bounded_int<Min, Max>;
+    using storage_type = typename type::storage_type;
+    static constexpr storage_type null_code = std::numeric_limits<storage_type>::max();
+
+  public:
+    static constexpr bool bitwise_null = true;
+    static constexpr std::size_t niche_count = static_cast<std::size_t>(
+        std::min<std::uintmax_t>(null_code - type::max_code, std::numeric_limits<std::size_t>::max()));
+
+    // codes [0, max_code] fit in opt_packed_array lanes of that many bits
+    static constexpr std::size_t packed_bits = static_cast<std::size_t>(std::bit_width(type::max_code + 1));
+
+    static constexpr type null_value() noexcept { return type::from_code(null_code); }
+    static constexpr bool has_value(type value) noexcept { return value.code() != null_code; }
+    static constexpr type niche_value(std::size_t i) noexcept
+    {
+      assert(i < niche_count);
+      return type::from_code(static_cast<storage_type>(null_code - i));
+    }
+    static constexpr std::size_t niche_index(type value) noexcept
+    {
+      return value.code() > type::max_code ? static_cast<std::size_t>(null_code - value.code()) : niche_count;
+    }
+  };
+
+  template<std::intmax_t Min, std::intmax_t Max>
+  using opt_bounded = opt<bounded_int<Min, Max>>;
+
+  // out[i] = in[i] converted to opt<V, P> (i.e. opt<int, opt_null_value_policy<int, -1>>)
+  //
+  // For integral V with a bitwise null the loop works on raw codes without branches so it is vectorized by the
+  // compiler. P::null_value() should not be one of the [Min, Max] values.
+  template<std::intmax_t Min, std::intmax_t Max, std::size_t Extent1, typename V, typename P, std::size_t Extent2>
+  void widen(std::span<const opt_bounded<Min, Max>, Extent1> in, std::span<opt<V, P>, Extent2> out)
+  {
+    using out_type = opt<V, P>;
+    static_assert(std::is_integral_v<V>, "integral 'V' is required");
+    static_assert(std::in_range<V>(Min) && std::in_range<V>(Max),
+                  "'V' cannot hold [Min, Max], consider using a wider type");
+    assert(out.size() >= in.size());
+    if constexpr(detail::is_raw_value_opt<out_type>) {
+      using code_type = typename bounded_int<Min, Max>::storage_type;
+      const V null = out_type::traits_type::null_value();
+      assert((std::cmp_less(null, Min) || std::cmp_less(Max, null)) &&
+             "null value of the output is one of the [Min, Max] values");
+      constexpr code_type null_code = std::numeric_limits<code_type>::max();
+      for(std::size_t i = 0; i < in.size(); ++i) {
+        const auto code = static_cast<code_type>(detail::simd::to_raw(in[i]));
+        const auto v = code == null_code ? null : static_cast<V>(static_cast<V>(code) + static_cast<V>(Min));
+        detail::simd::store(&out[i], v);
+      }
+    }
+    else {
+      for(std::size_t i = 0; i < in.size(); ++i)
+        out[i] = in[i].has_value() ? out_type{static_cast<V>(*in[i])} : out_type{};
+    }
+  }
+
+  // out[i] = in[i] converted to opt_bounded<Min, Max> (values are range-checked with assert())
+  template<std::intmax_t Min, std::intmax_t Max, typename V, typename P, std::size_t Extent1, std::size_t Extent2>
+  void narrow(std::span<const opt<V, P>, Extent1> in, std::span<opt_bounded<Min, Max>, Extent2> out)
+  {
+    using in_type = opt<V, P>;
+    using out_type = opt_bounded<Min, Max>;
+    static_assert(std::is_integral_v<V>, "integral 'V' is required");
+    assert(out.size() >= in.size());
+    if constexpr(detail::is_raw_value_opt<in_type>) {
+      using code_type = typename bounded_int<Min, Max>::storage_type;
+      const V null = in_type::traits_type::null_value();
+      constexpr code_type null_code = std::numeric_limits<code_type>::max();
+      for(std::size_t i = 0; i < in.size(); ++i) {
+        const auto v = static_cast<V>(detail::simd::to_raw(in[i]));
+        assert((v == null || (std::cmp_less_equal(Min, v) && std::cmp_less_equal(v, Max))) &&
+               "value out of the [Min, Max] range");
+        const auto code =
+            v == null ? null_code : static_cast<code_type>(static_cast<code_type>(v) - static_cast<code_type>(Min));
+        detail::simd::store(&out[i], code);
+      }
+    }
+    else {
+      for(std::size_t i = 0; i < in.size(); ++i)
+        out[i] = in[i].has_value() ? out_type{static_cast<typename bounded_int<Min, Max>::value_type>(*in[i])}
+                                   : out_type{};
+    }
+  }
+
+}  // namespace mp
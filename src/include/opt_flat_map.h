@@ -0,0 +1,650 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include "opt_simd.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace mp {
+
+  namespace detail {
+
+    // Open-addressing hash table with linear probing that uses Policy::null_value() of the key as an empty slot
+    // marker. Keys and values (if V is not void) are stored in separate arrays. Erased entries are removed with
+    // backward shift so no tombstones are needed.
+    template<typename K, typename V, typename Policy, typename Hash, typename KeyEqual>
+    class opt_flat_table {
+    public:
+      using key_type = K;
+      using size_type = std::size_t;
+      using hasher = Hash;
+      using key_equal = KeyEqual;
+
+      static constexpr size_type cache_line_size = 64;
+
+      opt_flat_table() = default;
+
+      explicit opt_flat_table(size_type bucket_count, const Hash& hash = Hash{}, const KeyEqual& equal = KeyEqual{})
+          : hash_{hash}, equal_{equal}
+      {
+        rehash(bucket_count);
+      }
+
+      opt_flat_table(const opt_flat_table& other) : hash_{other.hash_}, equal_{other.equal_}
+      {
+        reserve(other.size_);
+        for(size_type i = 0; i < other.capacity_; ++i)
+          if(other.keys_[i].has_value()) {
+            if constexpr(has_values)
+              emplace_new(*other.keys_[i], other.values_[i]);
+            else
+              emplace_new(*other.keys_[i]);
+          }
+      }
+
+      opt_flat_table(opt_flat_table&& other) noexcept
+          : keys_{std::exchange(other.keys_, nullptr)},
+            values_{std::exchange(other.values_, nullptr)},
+            capacity_{std::exchange(other.capacity_, 0)},
+            size_{std::exchange(other.size_, 0)},
+            shift_{std::exchange(other.shift_, 64)},
+            hash_{std::move(other.hash_)},
+            equal_{std::move(other.equal_)}
+      {
+      }
+
+      opt_flat_table& operator=(const opt_flat_table& other)
+      {
+        if(this != &other) {
+          opt_flat_table tmp{other};
+          swap(tmp);
+        }
+        return *this;
+      }
+
+      opt_flat_table& operator=(opt_flat_table&& other) noexcept
+      {
+        opt_flat_table tmp{std::move(other)};
+        swap(tmp);
+        return *this;
+      }
+
+      ~opt_flat_table() { deallocate(); }
+
+      void swap(opt_flat_table& other) noexcept
+      {
+        using std::swap;
+        swap(keys_, other.keys_);
+        swap(values_, other.values_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+        swap(shift_, other.shift_);
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+      }
+
+      // capacity
+      [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+      size_type size() const noexcept { return size_; }
+      size_type bucket_count() const noexcept { return capacity_; }
+      static constexpr float max_load_factor() noexcept { return 0.75f; }
+      float load_factor() const noexcept
+      {
+        return capacity_ ? static_cast<float>(size_) / static_cast<float>(capacity_) : 0.0f;
+      }
+
+      // modifiers
+      void clear() noexcept
+      {
+        if constexpr(has_values && !std::is_trivially_destructible_v<V>)
+          for(size_type i = 0; i < capacity_; ++i)
+            if(keys_[i].has_value()) std::destroy_at(values_ + i);
+        std::fill_n(keys_, capacity_, key_opt{});
+        size_ = 0;
+      }
+
+      size_type erase(const K& key)
+      {
+        const auto i = find_index(key);
+        if(i == npos) return 0;
+        erase_index(i);
+        return 1;
+      }
+
+      // bucket interface
+      void reserve(size_type count) { rehash(min_capacity(count)); }
+
+      void rehash(size_type count)
+      {
+        count = std::max({count, min_capacity(size_), size_type{16}});
+        const auto capacity = std::bit_ceil(count);
+        if(capacity == capacity_) return;
+
+        // the entries are moved to new arrays that replace the current ones only when all of them are there, so an
+        // exception leaves the table unchanged (values are copied if their move constructor may throw)
+        opt_flat_table tmp{allocate_tag{}, capacity, hash_, equal_};
+        for(size_type i = 0; i < capacity_; ++i) {
+          if(!keys_[i].has_value()) continue;
+          if constexpr(has_values)
+            tmp.emplace_new(*keys_[i], std::move_if_noexcept(values_[i]));
+          else
+            tmp.emplace_new(*keys_[i]);
+        }
+        swap(tmp);
+      }
+
+      // observers
+      hasher hash_function() const { return hash_; }
+      key_equal key_eq() const { return equal_; }
+
+    protected:
+      using key_opt = opt<K, Policy>;
+      static constexpr bool has_values = !std::is_void_v<V>;
+      using value_storage = std::conditional_t<has_values, V, char>;
+      static constexpr size_type npos = static_cast<size_type>(-1);
+
+      key_opt* keys_ = nullptr;
+      value_storage* values_ = nullptr;
+      size_type capacity_ = 0;  // power of 2 or 0
+      size_type size_ = 0;
+      int shift_ = 64;
+      [[no_unique_address]] Hash hash_;
+      [[no_unique_address]] KeyEqual equal_;
+
+      static size_type min_capacity(size_type count) noexcept
+      {
+        return static_cast<size_type>(static_cast<double>(count) / max_load_factor()) + 1;
+      }
+
+      // Fibonacci hashing - the top bits of the product spread poor quality (e.g. identity) hashes over the table
+      size_type home_index(const K& key) const noexcept(noexcept(hash_(key)))
+      {
+        return static_cast<size_type>((static_cast<std::uint64_t>(hash_(key)) * 0x9E37'79B9'7F4A'7C15) >> shift_);
+      }
+
+      size_type find_index_from(const K& key, size_type i) const
+      {
+        const auto mask = capacity_ - 1;
+        for(;; i = (i + 1) & mask) {
+          const auto& k = keys_[i];
+          if(!k.has_value()) return npos;
+          if(equal_(*k, key)) return i;
+        }
+      }
+
+      size_type find_index(const K& key) const
+      {
+        if(size_ == 0) return npos;
+        return find_index_from(key, home_index(key));
+      }
+
+      // index of the first empty slot for the key that is known not to be in the table
+      size_type free_index(const K& key) const
+      {
+        const auto mask = capacity_ - 1;
+        auto i = home_index(key);
+        while(keys_[i].has_value())
+          i = (i + 1) & mask;
+        return i;
+      }
+
+      // returns the index of the key and true if the key was inserted; the table grows only if a new entry is needed
+      template<typename... Args>
+      std::pair<size_type, bool> emplace_key(const K& key, Args&&... args)
+      {
+        assert(key_opt{key}.has_value() && "null value cannot be used as a key");
+        if(capacity_ != 0) {
+          const auto mask = capacity_ - 1;
+          auto i = home_index(key);
+          for(; keys_[i].has_value(); i = (i + 1) & mask)
+            if(equal_(*keys_[i], key)) return {i, false};
+          if(size_ + 1 <= static_cast<size_type>(static_cast<float>(capacity_) * max_load_factor())) {
+            emplace_at(i, key, std::forward<Args>(args)...);
+            return {i, true};
+          }
+        }
+        // key and args may refer to an entry of the table, so they are copied before it is rehashed
+        const K k = key;
+        if constexpr(has_values) {
+          V value(std::forward<Args>(args)...);
+          rehash(capacity_ * 2);
+          return {emplace_new(k, std::move(value)), true};
+        }
+        else {
+          rehash(capacity_ * 2);
+          return {emplace_new(k), true};
+        }
+      }
+
+      template<typename... Args>
+      size_type emplace_new(const K& key, Args&&... args)
+      {
+        const auto i = free_index(key);
+        emplace_at(i, key, std::forward<Args>(args)...);
+        return i;
+      }
+
+      template<typename... Args>
+      void emplace_at(size_type i, const K& key, Args&&... args)
+      {
+        if constexpr(has_values) std::construct_at(values_ + i, std::forward<Args>(args)...);
+        keys_[i] = key;
+        ++size_;
+      }
+
+      void erase_index(size_type hole)
+      {
+        if constexpr(has_values) std::destroy_at(values_ + hole);
+        const auto mask = capacity_ - 1;
+        for(auto i = (hole + 1) & mask; keys_[i].has_value(); i = (i + 1) & mask) {
+          // the entry may be moved back only if the hole is between its home slot and its current position
+          const auto home = home_index(*keys_[i]);
+          if(((i - home) & mask) >= ((i - hole) & mask)) {
+            keys_[hole] = std::move(keys_[i]);
+            if constexpr(has_values) {
+              std::construct_at(values_ + hole, std::move(values_[i]));
+              std::destroy_at(values_ + i);
+            }
+            hole = i;
+          }
+        }
+        keys_[hole].reset();
+        --size_;
+      }
+
+      // Iteration starts after `stop`, the first empty slot of the table, and goes around to it. No cluster wraps
+      // around the end of such a range, so the backward shift in erase_index() moves entries only to the slots that
+      // are not visited yet and erasing while iterating visits every entry once.
+      size_type first_empty() const noexcept
+      {
+        size_type i = 0;
+        while(keys_[i].has_value())
+          ++i;
+        return i;
+      }
+
+      // index of the first entry after i in iteration order or capacity_ at the end; `stop` equal to npos (an iterator
+      // returned from a lookup) is found on first use
+      size_type next_index(size_type i, size_type& stop) const noexcept
+      {
+        if(stop == npos) stop = first_empty();
+        const auto mask = capacity_ - 1;
+        for(i = (i + 1) & mask; i != stop; i = (i + 1) & mask)
+          if(keys_[i].has_value()) return i;
+        return capacity_;
+      }
+
+      // erases the entry at `pos` and returns the index of the next entry in iteration order
+      size_type erase_at(size_type pos, size_type& stop)
+      {
+        if(stop == npos) stop = first_empty();
+        erase_index(pos);
+        // an entry that is not visited yet might be shifted back to the erased slot
+        return keys_[pos].has_value() ? pos : next_index(pos, stop);
+      }
+
+      // finds `keys.size()` keys calling f(i, index) for each of them; home slots of a batch of keys are prefetched
+      // before probing so that the memory accesses of independent lookups overlap (values are not prefetched as
+      // for missing keys it only wastes line fill buffers)
+      template<typename F>
+      void find_many_impl(std::span<const K> keys, F f) const
+      {
+        constexpr size_type batch_size = 16;
+        size_type home[batch_size];
+        for(size_type base = 0; base < keys.size(); base += batch_size) {
+          const auto count = std::min(batch_size, keys.size() - base);
+          if(size_ == 0) {
+            for(size_type j = 0; j < count; ++j)
+              f(base + j, npos);
+            continue;
+          }
+          for(size_type j = 0; j < count; ++j) {
+            home[j] = home_index(keys[base + j]);
+            simd::prefetch(keys_ + home[j]);
+          }
+          for(size_type j = 0; j < count; ++j)
+            f(base + j, find_index_from(keys[base + j], home[j]));
+        }
+      }
+
+    private:
+      struct allocate_tag {
+      };
+      opt_flat_table(allocate_tag, size_type capacity, const Hash& hash, const KeyEqual& equal)
+          : hash_{hash}, equal_{equal}
+      {
+        allocate(capacity);
+      }
+
+      void allocate(size_type capacity)
+      {
+        keys_ = static_cast<key_opt*>(::operator new(capacity * sizeof(key_opt), std::align_val_t{cache_line_size}));
+        std::uninitialized_value_construct_n(keys_, capacity);
+        if constexpr(has_values) {
+          try {
+            values_ = static_cast<V*>(::operator new(capacity * sizeof(V),
+                                                     std::align_val_t{std::max(cache_line_size, alignof(V))}));
+          }
+          catch(...) {
+            ::operator delete(keys_, std::align_val_t{cache_line_size});
+            keys_ = nullptr;
+            throw;
+          }
+        }
+        capacity_ = capacity;
+        shift_ = 64 - std::countr_zero(capacity);
+        size_ = 0;
+      }
+
+      void deallocate() noexcept
+      {
+        if(!keys_) return;
+        if constexpr(has_values) {
+          if constexpr(!std::is_trivially_destructible_v<V>)
+            for(size_type i = 0; i < capacity_; ++i)
+              if(keys_[i].has_value()) std::destroy_at(values_ + i);
+          ::operator delete(values_, std::align_val_t{std::max(cache_line_size, alignof(V))});
+        }
+        std::destroy_n(keys_, capacity_);
+        ::operator delete(keys_, std::align_val_t{cache_line_size});
+        keys_ = nullptr;
+        values_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        shift_ = 64;
+      }
+    };
+
+  }  // namespace detail
+
+  // Hash map with keys of type K where K value equal to Policy::null_value() marks an empty slot so no additional
+  // control bytes are needed. Such a key cannot be inserted into the map.
+  template<typename K, typename V, typename Policy = opt_default_policy<K>, typename Hash = std::hash<K>,
+           typename KeyEqual = std::equal_to<K>>
+  class opt_flat_map : public detail::opt_flat_table<K, V, Policy, Hash, KeyEqual> {
+    using base = detail::opt_flat_table<K, V, Policy, Hash, KeyEqual>;
+    using base::npos;
+
+  public:
+    using mapped_type = V;
+    using reference = std::pair<const K&, V&>;
+    using const_reference = std::pair<const K&, const V&>;
+
+    template<bool Const>
+    class basic_iterator {
+      friend class opt_flat_map;
+      friend class basic_iterator<!Const>;
+      using map_type = std::conditional_t<Const, const opt_flat_map, opt_flat_map>;
+      map_type* map_ = nullptr;
+      std::size_t index_ = 0;
+      std::size_t stop_ = npos;  // empty slot that ends the iteration
+      basic_iterator(map_type* map, std::size_t index, std::size_t stop = npos) : map_{map}, index_{index}, stop_{stop}
+      {
+      }
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = std::pair<const K, V>;
+      using difference_type = std::ptrdiff_t;
+      using reference = std::conditional_t<Const, opt_flat_map::const_reference, opt_flat_map::reference>;
+
+      struct pointer {
+        reference ref;
+        const reference* operator->() const noexcept { return &ref; }
+      };
+
+      basic_iterator() = default;
+      template<bool C>
+        requires(Const && !C)
+      basic_iterator(const basic_iterator<C>& other) : map_{other.map_}, index_{other.index_}, stop_{other.stop_}
+      {
+      }
+
+      reference operator*() const { return {*map_->keys_[index_], map_->values_[index_]}; }
+      pointer operator->() const { return {**this}; }
+      basic_iterator& operator++()
+      {
+        index_ = map_->next_index(index_, stop_);
+        return *this;
+      }
+      basic_iterator operator++(int)
+      {
+        auto tmp = *this;
+        ++*this;
+        return tmp;
+      }
+      friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) noexcept
+      {
+        return lhs.index_ == rhs.index_;
+      }
+      friend bool operator!=(const basic_iterator& lhs, const basic_iterator& rhs) noexcept { return !(lhs == rhs); }
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    using base::base;
+
+    // iterators
+    iterator begin() noexcept
+    {
+      if(this->empty()) return end();
+      auto stop = this->first_empty();
+      return {this, this->next_index(stop, stop), stop};
+    }
+    const_iterator begin() const noexcept
+    {
+      if(this->empty()) return end();
+      auto stop = this->first_empty();
+      return {this, this->next_index(stop, stop), stop};
+    }
+    iterator end() noexcept { return {this, this->capacity_}; }
+    const_iterator end() const noexcept { return {this, this->capacity_}; }
+
+    // modifiers
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+      const auto [i, inserted] = this->emplace_key(key, std::forward<Args>(args)...);
+      return {iterator{this, i}, inserted};
+    }
+
+    std::pair<iterator, bool> insert(const K& key, const V& value) { return try_emplace(key, value); }
+    std::pair<iterator, bool> insert(const K& key, V&& value) { return try_emplace(key, std::move(value)); }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value)
+    {
+      auto res = try_emplace(key, std::forward<M>(value));
+      if(!res.second) this->values_[res.first.index_] = std::forward<M>(value);
+      return res;
+    }
+
+    // iterators to the other entries are invalidated, but erasing with the returned iterator while iterating visits
+    // every entry once
+    iterator erase(const_iterator pos)
+    {
+      assert(pos != end());
+      auto stop = pos.stop_;
+      const auto i = this->erase_at(pos.index_, stop);
+      return {this, i, stop};
+    }
+    using base::erase;
+
+    // lookup
+    V& operator[](const K& key)
+    {
+      // emplace_key() may reallocate values_
+      const auto i = this->emplace_key(key).first;
+      return this->values_[i];
+    }
+
+    V& at(const K& key)
+    {
+      const auto i = this->find_index(key);
+      if(i == npos) throw std::out_of_range{"opt_flat_map::at: key not found"};
+      return this->values_[i];
+    }
+    const V& at(const K& key) const
+    {
+      const auto i = this->find_index(key);
+      if(i == npos) throw std::out_of_range{"opt_flat_map::at: key not found"};
+      return this->values_[i];
+    }
+
+    iterator find(const K& key)
+    {
+      const auto i = this->find_index(key);
+      return i == npos ? end() : iterator{this, i};
+    }
+    const_iterator find(const K& key) const
+    {
+      const auto i = this->find_index(key);
+      return i == npos ? end() : const_iterator{this, i};
+    }
+
+    bool contains(const K& key) const { return this->find_index(key) != npos; }
+    std::size_t count(const K& key) const { return contains(key); }
+
+    // results[i] = pointer to the value mapped to keys[i] or nullptr if not found
+    void find_many(std::span<const K> keys, std::span<const V*> results) const
+    {
+      assert(results.size() >= keys.size());
+      this->find_many_impl(keys, [&](std::size_t i, std::size_t index) {
+        results[i] = index == npos ? nullptr : this->values_ + index;
+      });
+    }
+    void find_many(std::span<const K> keys, std::span<V*> results)
+    {
+      assert(results.size() >= keys.size());
+      this->find_many_impl(keys, [&](std::size_t i, std::size_t index) {
+        results[i] = index == npos ? nullptr : this->values_ + index;
+      });
+    }
+  };
+
+  // Hash set with keys of type K where K value equal to Policy::null_value() marks an empty slot
+  template<typename K, typename Policy = opt_default_policy<K>, typename Hash = std::hash<K>,
+           typename KeyEqual = std::equal_to<K>>
+  class opt_flat_set : public detail::opt_flat_table<K, void, Policy, Hash, KeyEqual> {
+    using base = detail::opt_flat_table<K, void, Policy, Hash, KeyEqual>;
+    using base::npos;
+
+  public:
+    class const_iterator {
+      friend class opt_flat_set;
+      const opt_flat_set* set_ = nullptr;
+      std::size_t index_ = 0;
+      std::size_t stop_ = npos;  // empty slot that ends the iteration
+      const_iterator(const opt_flat_set* set, std::size_t index, std::size_t stop = npos)
+          : set_{set}, index_{index}, stop_{stop}
+      {
+      }
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = K;
+      using difference_type = std::ptrdiff_t;
+      using reference = const K&;
+      using pointer = const K*;
+
+      const_iterator() = default;
+      reference operator*() const { return *set_->keys_[index_]; }
+      pointer operator->() const { return &**this; }
+      const_iterator& operator++()
+      {
+        index_ = set_->next_index(index_, stop_);
+        return *this;
+      }
+      const_iterator operator++(int)
+      {
+        auto tmp = *this;
+        ++*this;
+        return tmp;
+      }
+      friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept
+      {
+        return lhs.index_ == rhs.index_;
+      }
+      friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) noexcept { return !(lhs == rhs); }
+    };
+    using iterator = const_iterator;
+
+    using base::base;
+
+    // iterators
+    const_iterator begin() const noexcept
+    {
+      if(this->empty()) return end();
+      auto stop = this->first_empty();
+      return {this, this->next_index(stop, stop), stop};
+    }
+    const_iterator end() const noexcept { return {this, this->capacity_}; }
+
+    // modifiers
+    std::pair<iterator, bool> insert(const K& key)
+    {
+      const auto [i, inserted] = this->emplace_key(key);
+      return {iterator{this, i}, inserted};
+    }
+
+    // iterators to the other keys are invalidated, but erasing with the returned iterator while iterating visits
+    // every key once
+    iterator erase(const_iterator pos)
+    {
+      assert(pos != end());
+      auto stop = pos.stop_;
+      const auto i = this->erase_at(pos.index_, stop);
+      return {this, i, stop};
+    }
+    using base::erase;
+
+    // lookup
+    const_iterator find(const K& key) const
+    {
+      const auto i = this->find_index(key);
+      return i == npos ? end() : const_iterator{this, i};
+    }
+
+    bool contains(const K& key) const { return this->find_index(key) != npos; }
+    std::size_t count(const K& key) const { return contains(key); }
+
+    // results[i] = contains(keys[i])
+    void contains_many(std::span<const K> keys, std::span<bool> results) const
+    {
+      assert(results.size() >= keys.size());
+      this->find_many_impl(keys, [&](std::size_t i, std::size_t index) { results[i] = index != npos; });
+    }
+  };
+
+}
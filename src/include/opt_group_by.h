@@ -0,0 +1,406 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt_reduce.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mp {
+
+  // aggregates of the measure values of one group
+  template<typename Key, typename Measure, typename R>
+  struct opt_group {
+    Key key;                // empty for the group of empty keys
+    std::size_t rows = 0;   // rows with the key
+    std::size_t count = 0;  // rows with a not empty measure
+    detail::reduce_result_t<R> sum;
+    Measure min;
+    Measure max;
+    opt<double, opt_nan_policy<double>> mean;
+  };
+
+  namespace detail {
+
+    // accumulators of one group; min is greater than max until there is a value other than NaN
+    template<typename T, typename Acc>
+    struct group_state {
+      std::size_t rows = 0;
+      std::size_t count = 0;
+      Acc sum{};
+      T min = reduce_highest<T>;
+      T max = reduce_lowest<T>;
+
+      // empty measures are masked out instead of branching as they are usually mixed with values at random
+      template<typename Measure>
+      void add(const Measure& m) noexcept
+      {
+        ++rows;
+        if constexpr(is_raw_value_opt<Measure>) {
+          using raw = simd::raw_type<T>;
+          const raw r = simd::load<raw>(&m);
+          const raw mask = static_cast<raw>(raw{0} - static_cast<raw>(r != raw_null<Measure>()));
+          count += mask & 1u;
+          sum += static_cast<Acc>(std::bit_cast<T>(static_cast<raw>(r & mask)));
+          const T lo = std::bit_cast<T>(static_cast<raw>((r & mask) | (std::bit_cast<raw>(reduce_highest<T>) & ~mask)));
+          const T hi = std::bit_cast<T>(static_cast<raw>((r & mask) | (std::bit_cast<raw>(reduce_lowest<T>) & ~mask)));
+          min = lo < min ? lo : min;
+          max = max < hi ? hi : max;
+        }
+        else {
+          if(!m.has_value()) return;
+          const T x = *m;
+          ++count;
+          sum += static_cast<Acc>(x);
+          min = x < min ? x : min;
+          max = max < x ? x : max;
+        }
+      }
+
+      void merge(const group_state& other) noexcept
+      {
+        rows += other.rows;
+        count += other.count;
+        sum += other.sum;
+        min = other.min < min ? other.min : min;
+        max = max < other.max ? other.max : max;
+      }
+    };
+
+    // raw storage of a key with -0.0 replaced with 0.0, so that equal keys have equal bits
+    template<typename Key>
+    simd::raw_type<typename Key::value_type> group_key(const Key& key) noexcept
+    {
+      using T = typename Key::value_type;
+      const auto raw = simd::load<simd::raw_type<T>>(&key);
+      if constexpr(std::is_floating_point_v<T>)
+        return std::bit_cast<T>(raw) == T{0} ? simd::raw_type<T>{0} : raw;
+      else
+        return raw;
+    }
+
+    template<typename T>
+    std::uint64_t group_hash(simd::raw_type<T> key) noexcept
+    {
+      return simd::hash_mix(hash_key(std::bit_cast<T>(key)));
+    }
+
+    // Open-addressing hash table with linear probing from the groups of not empty keys to their states. Keys are kept
+    // as raw bits and the null value marks an empty slot, so mask_lanes slots are probed at once with one SIMD
+    // comparison. The slots are followed by mask_lanes always empty ones, so the comparisons never read past the end.
+    // Hashes are provided by the caller so that they are computed in batches; their top bits select the home slot.
+    template<typename Key, typename State>
+    class group_table {
+      using T = typename Key::value_type;
+
+    public:
+      using raw = simd::raw_type<T>;
+      static constexpr std::size_t lanes = simd::mask_lanes<raw>;
+
+      std::size_t size() const noexcept { return size_; }
+
+      void prefetch(std::uint64_t hash) const noexcept
+      {
+        if(capacity_ == 0) return;
+        const auto i = home_index(hash);
+        simd::prefetch(keys_.data() + i);
+        simd::prefetch(states_.data() + i);
+      }
+
+      // the group is created if it does not exist
+      State& find_or_insert(raw key, std::uint64_t hash)
+      {
+        assert(key != empty());
+        if(size_ + 1 > capacity_ / 4 * 3) rehash(capacity_ == 0 ? 16 : capacity_ * 2);
+        auto i = home_index(hash);
+        for(;;) {
+          if(const auto m = simd::eq_either_mask(keys_.data() + i, key, empty()); m != 0) {
+            const auto j = i + static_cast<std::size_t>(std::countr_zero(m));
+            if(j < capacity_) {
+              if(keys_[j] != key) {
+                keys_[j] = key;
+                ++size_;
+              }
+              return states_[j];
+            }
+            // the probe sequence continues at the beginning of the table
+            i = 0;
+          }
+          else if((i += lanes) == capacity_)
+            i = 0;
+        }
+      }
+
+      const State* find(raw key, std::uint64_t hash) const noexcept
+      {
+        if(size_ == 0) return nullptr;
+        const auto mask = capacity_ - 1;
+        for(auto i = home_index(hash); keys_[i] != empty(); i = (i + 1) & mask)
+          if(keys_[i] == key) return &states_[i];
+        return nullptr;
+      }
+
+      // Calls f(key, state) for every group. Slots are visited with a stride of about 0.618 of the capacity instead of
+      // in order, as keys ordered by their hashes would form one long run of linear probing when inserted into
+      // another table that is smaller than all of them.
+      template<typename F>
+      void for_each(F f) const
+      {
+        const auto mask = capacity_ - 1;
+        const auto stride = static_cast<std::size_t>(static_cast<double>(capacity_) * 0.6180339887) | 1;
+        for(std::size_t n = 0, i = 0; n < capacity_; ++n, i = (i + stride) & mask)
+          if(keys_[i] != empty()) f(keys_[i], states_[i]);
+      }
+
+    private:
+      std::vector<raw> keys_;
+      std::vector<State> states_;
+      std::size_t capacity_ = 0;  // power of 2 or 0
+      std::size_t size_ = 0;
+      int shift_ = 64;
+
+      static raw empty() noexcept { return raw_null<Key>(); }
+
+      std::size_t home_index(std::uint64_t hash) const noexcept { return static_cast<std::size_t>(hash >> shift_); }
+
+      void rehash(std::size_t capacity)
+      {
+        auto keys = std::exchange(keys_, std::vector<raw>(capacity + lanes, empty()));
+        auto states = std::exchange(states_, std::vector<State>(capacity));
+        capacity_ = capacity;
+        shift_ = 64 - std::countr_zero(capacity);
+        size_ = 0;
+        for(std::size_t i = 0; i < states.size(); ++i)
+          if(keys[i] != empty()) find_or_insert(keys[i], group_hash<T>(keys[i])) = states[i];
+      }
+    };
+
+  }  // namespace detail
+
+  // Hash aggregation of `Measure` values grouped by `Key` values, where both are opt<T, Policy> types
+  //
+  // Empty keys form their own group and empty measures are skipped by count, sum, min, max and mean of a group (rows
+  // counts them too). Keys are hashed in batches with simd::hash_mix() and the groups are kept in open-addressing
+  // tables probed with SIMD comparisons. With `threads` other than 1 (0 uses all hardware threads) every thread
+  // aggregates its own chunk of rows and splits the groups into partitions by hash, and then every thread merges the
+  // groups of one partition.
+  template<typename Key, typename Measure, typename R = void>
+  class opt_group_by {
+    static_assert(detail::is_opt<Key>::value && detail::is_opt<Measure>::value, "opt<T, Policy> types are required");
+    static_assert(detail::is_raw_value_opt<Key> && detail::is_mixable<typename Key::value_type>::value,
+                  "integral, enumeration or floating-point keys stored with a bitwise null are required, consider "
+                  "using std::unordered_map");
+    static_assert(std::is_arithmetic_v<typename Measure::value_type> &&
+                      !std::is_same_v<typename Measure::value_type, bool>,
+                  "arithmetic measures are required, consider using std::unordered_map");
+
+  public:
+    using key_type = Key;
+    using measure_type = Measure;
+    using sum_type = detail::reduce_sum_type<R, Measure>;
+    using group_type = opt_group<Key, Measure, sum_type>;
+
+    // number of groups
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    std::size_t size() const noexcept
+    {
+      std::size_t size = null_.rows != 0;
+      for(const auto& p : parts_) size += p.size();
+      return size;
+    }
+
+    // aggregates the rows of `keys` and the corresponding `measures`
+    void add(std::span<const Key> keys, std::span<const Measure> measures, unsigned threads = 1)
+    {
+      assert(keys.size() == measures.size());
+      if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+      threads = static_cast<unsigned>(std::clamp<std::size_t>(keys.size() / min_chunk, 1, threads));
+      if(threads == 1) {
+        if(parts_.size() == 1) {
+          aggregate(keys, measures);
+        }
+        else {
+          opt_group_by tmp;
+          tmp.aggregate(keys, measures);
+          merge(tmp);
+        }
+        return;
+      }
+
+      if(parts_.size() != threads) repartition(threads);
+      std::vector<opt_group_by> local(threads);
+      std::vector<std::vector<std::vector<entry>>> partitioned(threads, std::vector<std::vector<entry>>(threads));
+      parallel(threads, [&](unsigned t) {
+        const std::size_t begin = keys.size() * t / threads;
+        const std::size_t end = keys.size() * (t + 1) / threads;
+        local[t].aggregate(keys.subspan(begin, end - begin), measures.subspan(begin, end - begin));
+        local[t].parts_[0].for_each([&](raw key, const state& s) {
+          const auto hash = detail::group_hash<value_type>(key);
+          partitioned[t][partition(hash)].push_back({key, hash, s});
+        });
+      });
+      parallel(threads, [&](unsigned p) {
+        for(const auto& groups : partitioned)
+          for(const auto& e : groups[p]) parts_[p].find_or_insert(e.key, e.hash).merge(e.s);
+      });
+      for(const auto& l : local) null_.merge(l.null_);
+    }
+
+    // adds groups of `other` (i.e. aggregated from another part of the data)
+    void merge(const opt_group_by& other)
+    {
+      for(const auto& p : other.parts_) p.for_each([&](raw key, const state& s) { merge(key, s); });
+      null_.merge(other.null_);
+    }
+
+    std::optional<group_type> find(const Key& key) const
+    {
+      if(!key.has_value()) {
+        if(null_.rows == 0) return std::nullopt;
+        return make_group(Key{}, null_);
+      }
+      const auto k = detail::group_key(key);
+      const auto hash = detail::group_hash<value_type>(k);
+      const state* s = parts_[partition(hash)].find(k, hash);
+      if(!s) return std::nullopt;
+      return make_group(key, *s);
+    }
+
+    // all groups in an unspecified order
+    std::vector<group_type> groups() const
+    {
+      std::vector<group_type> result;
+      result.reserve(size());
+      if(null_.rows != 0) result.push_back(make_group(Key{}, null_));
+      for(const auto& p : parts_)
+        p.for_each([&](raw key, const state& s) { result.push_back(make_group(std::bit_cast<value_type>(key), s)); });
+      return result;
+    }
+
+    void clear() noexcept
+    {
+      parts_.assign(1, table{});
+      null_ = state{};
+    }
+
+  private:
+    using value_type = typename Key::value_type;
+    using state = detail::group_state<typename Measure::value_type, detail::reduce_acc_t<sum_type>>;
+    using table = detail::group_table<Key, state>;
+    using raw = typename table::raw;
+
+    struct entry {
+      raw key;
+      std::uint64_t hash;
+      state s;
+    };
+
+    // rows per thread below which additional threads are not worth starting
+    static constexpr std::size_t min_chunk = std::size_t{1} << 16;
+    // rows hashed at once
+    static constexpr std::size_t block_size = 256;
+    // rows ahead of the current one for which slots of the table are prefetched
+    static constexpr std::size_t prefetch_distance = 16;
+
+    std::vector<table> parts_ = std::vector<table>(1);
+    state null_;
+
+    // the low bits of a hash select the partition and the top ones a slot in its table
+    std::size_t partition(std::uint64_t hash) const noexcept
+    {
+      return static_cast<std::size_t>(((hash & 0xFFFF'FFFF) * parts_.size()) >> 32);
+    }
+
+    // rows are aggregated into the only partition
+    void aggregate(std::span<const Key> keys, std::span<const Measure> measures)
+    {
+      assert(parts_.size() == 1);
+      auto& t = parts_[0];
+      const raw null = detail::raw_null<Key>();
+      raw raw_keys[block_size];
+      std::uint64_t hashes[block_size];
+      for(std::size_t i = 0; i < keys.size(); i += block_size) {
+        const auto count = std::min(block_size, keys.size() - i);
+        for(std::size_t j = 0; j < count; ++j) {
+          raw_keys[j] = detail::group_key(keys[i + j]);
+          hashes[j] = detail::hash_key(std::bit_cast<value_type>(raw_keys[j]));
+        }
+        detail::simd::hash_mix(hashes, hashes, count);
+        for(std::size_t j = 0; j < std::min(prefetch_distance, count); ++j) t.prefetch(hashes[j]);
+        for(std::size_t j = 0; j < count; ++j) {
+          if(j + prefetch_distance < count) t.prefetch(hashes[j + prefetch_distance]);
+          state& s = raw_keys[j] == null ? null_ : t.find_or_insert(raw_keys[j], hashes[j]);
+          s.add(measures[i + j]);
+        }
+      }
+    }
+
+    void merge(raw key, const state& s)
+    {
+      const auto hash = detail::group_hash<value_type>(key);
+      parts_[partition(hash)].find_or_insert(key, hash).merge(s);
+    }
+
+    void repartition(std::size_t count)
+    {
+      auto parts = std::exchange(parts_, std::vector<table>(count));
+      for(const auto& p : parts) p.for_each([&](raw key, const state& s) { merge(key, s); });
+    }
+
+    template<typename F>
+    static void parallel(unsigned threads, F f)
+    {
+      std::vector<std::jthread> workers;
+      workers.reserve(threads - 1);
+      for(unsigned t = 1; t < threads; ++t) workers.emplace_back(f, t);
+      f(0);
+    }
+
+    static group_type make_group(const Key& key, const state& s)
+    {
+      group_type g;
+      g.key = key;
+      g.rows = s.rows;
+      g.count = s.count;
+      if(s.count != 0) {
+        g.sum = detail::make_reduce_result(static_cast<sum_type>(s.sum));
+        g.mean = static_cast<double>(static_cast<sum_type>(s.sum)) / static_cast<double>(s.count);
+      }
+      if(s.min <= s.max) {
+        g.min = s.min;
+        g.max = s.max;
+      }
+      return g;
+    }
+  };
+
+}  // namespace mp
@@ -0,0 +1,275 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mp {
+
+  // header of the opt_mmap_array file; elements follow it directly so they are 64-byte aligned in the mapping
+  struct opt_mmap_header {
+    static constexpr std::array<char, 8> magic_value{'M', 'P', 'O', 'P', 'T', 'A', 'R', 'R'};
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t endianness_value = 0x0102'0304;
+    static constexpr std::size_t max_element_size = 32;
+
+    std::array<char, 8> magic = magic_value;
+    std::uint32_t version = current_version;
+    std::uint32_t endianness = endianness_value;  // byte order of the writer
+    std::uint64_t element_size = 0;               // sizeof(storage_type)
+    std::uint64_t count = 0;
+    std::array<unsigned char, max_element_size> null_pattern{};  // bytes of Policy::null_value()
+  };
+  static_assert(sizeof(opt_mmap_header) == 64);
+
+  enum class opt_mmap_mode {
+    read_only,     // pages shared with the page cache, writes are not allowed
+    copy_on_write  // private pages are copied on the first write, the file is never modified
+  };
+
+  namespace detail {
+
+    // read-only or private mapping of the whole file
+    class mapped_file {
+    public:
+      mapped_file() = default;
+      mapped_file(const std::filesystem::path& path, opt_mmap_mode mode)
+      {
+#if defined(_WIN32)
+        try {
+          file_ = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+          if(file_ == INVALID_HANDLE_VALUE) throw_last_error("CreateFileW");
+          LARGE_INTEGER size;
+          if(!::GetFileSizeEx(file_, &size)) throw_last_error("GetFileSizeEx");
+          size_ = static_cast<std::size_t>(size.QuadPart);
+          if(size_ > 0) {
+            const bool read_only = mode == opt_mmap_mode::read_only;
+            mapping_ = ::CreateFileMappingW(file_, nullptr, read_only ? PAGE_READONLY : PAGE_WRITECOPY, 0, 0, nullptr);
+            if(!mapping_) throw_last_error("CreateFileMappingW");
+            data_ = ::MapViewOfFile(mapping_, read_only ? FILE_MAP_READ : FILE_MAP_COPY, 0, 0, 0);
+            if(!data_) throw_last_error("MapViewOfFile");
+          }
+        }
+        catch(...) {
+          // the destructor is not called for an object that failed to construct
+          unmap();
+          throw;
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) throw_last_error("open");
+        struct ::stat st;
+        if(::fstat(fd, &st) < 0) {
+          ::close(fd);
+          throw_last_error("fstat");
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if(size_ > 0) {
+          const int prot = mode == opt_mmap_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+          void* p = ::mmap(nullptr, size_, prot, MAP_PRIVATE, fd, 0);
+          if(p == MAP_FAILED) {
+            ::close(fd);
+            throw_last_error("mmap");
+          }
+          data_ = p;
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+#endif
+      }
+
+      mapped_file(mapped_file&& other) noexcept { swap(other); }
+      mapped_file& operator=(mapped_file&& other) noexcept
+      {
+        mapped_file{std::move(other)}.swap(*this);
+        return *this;
+      }
+      ~mapped_file() { unmap(); }
+
+      void swap(mapped_file& other) noexcept
+      {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#if defined(_WIN32)
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#endif
+      }
+
+      void* data() const noexcept { return data_; }
+      std::size_t size() const noexcept { return size_; }
+
+    private:
+      void* data_ = nullptr;
+      std::size_t size_ = 0;
+#if defined(_WIN32)
+      HANDLE file_ = INVALID_HANDLE_VALUE;
+      HANDLE mapping_ = nullptr;
+#endif
+
+      [[noreturn]] static void throw_last_error(const char* what)
+      {
+#if defined(_WIN32)
+        throw std::system_error(static_cast<int>(::GetLastError()), std::system_category(), what);
+#else
+        throw std::system_error(errno, std::system_category(), what);
+#endif
+      }
+
+      void unmap() noexcept
+      {
+#if defined(_WIN32)
+        if(data_) ::UnmapViewOfFile(data_);
+        if(mapping_) ::CloseHandle(mapping_);
+        if(file_ != INVALID_HANDLE_VALUE) ::CloseHandle(file_);
+#else
+        if(data_) ::munmap(data_, size_);
+#endif
+      }
+    };
+
+  }  // namespace detail
+
+  // Array of opt<T, Policy> objects stored in a file and mapped to memory without copying or converting elements,
+  // so pages are loaded lazily on the first access.
+  //
+  // The file header records sizeof(storage_type), the byte order and the bit pattern of Policy::null_value().
+  // Files whose header does not match the compiled opt<T, Policy> type are refused with std::runtime_error.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class opt_mmap_array {
+  public:
+    using value_type = opt<T, Policy>;
+    using size_type = std::size_t;
+    using const_iterator = const value_type*;
+
+    static_assert(std::is_trivially_copyable_v<value_type>,
+                  "trivially copyable opt<T, Policy> required, consider serializing elements one by one");
+    static_assert(sizeof(value_type) <= opt_mmap_header::max_element_size,
+                  "'sizeof(T) > 32' consider serializing elements one by one");
+    static_assert(alignof(value_type) <= sizeof(opt_mmap_header), "'alignof(T) > 64' is not supported");
+
+    // header describing the compiled opt<T, Policy> type
+    static opt_mmap_header make_header(size_type count) noexcept
+    {
+      opt_mmap_header h;
+      h.element_size = sizeof(value_type);
+      h.count = count;
+      const value_type null;
+      std::memcpy(h.null_pattern.data(), &null, sizeof(null));
+      return h;
+    }
+
+    // writes the header and raw elements to the file
+    static void save(const std::filesystem::path& path, std::span<const value_type> values)
+    {
+      std::ofstream file{path, std::ios::binary | std::ios::trunc};
+      const auto h = make_header(values.size());
+      file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      file.write(reinterpret_cast<const char*>(values.data()),
+                 static_cast<std::streamsize>(values.size_bytes()));
+      if(!file.flush()) throw std::runtime_error("opt_mmap_array: cannot write '" + path.string() + "'");
+    }
+
+    opt_mmap_array() = default;
+    explicit opt_mmap_array(const std::filesystem::path& path, opt_mmap_mode mode = opt_mmap_mode::read_only)
+        : file_{path, mode}, mode_{mode}
+    {
+      if(file_.size() < sizeof(opt_mmap_header))
+        throw std::runtime_error("opt_mmap_array: '" + path.string() + "' is too small");
+      opt_mmap_header h;
+      std::memcpy(&h, file_.data(), sizeof(h));
+      const auto expected = make_header(h.count);
+      if(h.magic != expected.magic || h.version != expected.version)
+        throw std::runtime_error("opt_mmap_array: '" + path.string() + "' is not an opt_mmap_array file");
+      if(h.endianness != expected.endianness)
+        throw std::runtime_error("opt_mmap_array: '" + path.string() + "' was written with a different byte order");
+      if(h.element_size != expected.element_size || h.null_pattern != expected.null_pattern)
+        throw std::runtime_error("opt_mmap_array: '" + path.string() +
+                                 "' stores elements of a different type or null value");
+      if(h.count > (file_.size() - sizeof(h)) / sizeof(value_type))
+        throw std::runtime_error("opt_mmap_array: '" + path.string() + "' is truncated");
+      size_ = static_cast<size_type>(h.count);
+    }
+
+    opt_mmap_mode mode() const noexcept { return mode_; }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    const value_type* data() const noexcept
+    {
+      return file_.data()
+                 ? reinterpret_cast<const value_type*>(static_cast<const char*>(file_.data()) + sizeof(opt_mmap_header))
+                 : nullptr;
+    }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size_; }
+    const value_type& operator[](size_type i) const
+    {
+      assert(i < size_);
+      return data()[i];
+    }
+
+    std::span<const value_type> values() const noexcept { return {data(), size_}; }
+
+    // private writable view of copy_on_write mappings; changes are never written back to the file
+    std::span<value_type> mutable_values()
+    {
+      if(mode_ != opt_mmap_mode::copy_on_write)
+        throw std::logic_error("opt_mmap_array: mutable_values() requires opt_mmap_mode::copy_on_write");
+      return {const_cast<value_type*>(data()), size_};
+    }
+
+  private:
+    detail::mapped_file file_;
+    opt_mmap_mode mode_ = opt_mmap_mode::read_only;
+    size_type size_ = 0;
+  };
+
+}
@@ -0,0 +1,329 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include "opt_simd.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace mp {
+
+  namespace detail {
+
+    template<typename P, typename = std::void_t<>>
+    struct declared_packed_bits : std::integral_constant<std::size_t, 0> {
+    };
+    template<typename P>
+    struct declared_packed_bits<P, std::void_t<decltype(P::packed_bits)>>
+        : std::integral_constant<std::size_t, P::packed_bits> {
+    };
+
+    // integral or enumeration values are assumed to be smaller than a non-negative null_value() known at compile time
+    template<typename T, typename P, typename = std::void_t<>>
+    struct null_value_bits : std::integral_constant<std::size_t, 0> {
+    };
+    template<typename T, typename P>
+    struct null_value_bits<T, P,
+                           std::void_t<std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>,
+                                       std::integral_constant<T, P::null_value()>>> {
+      static constexpr std::size_t value = [] {
+        using underlying = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                                                       std::type_identity<T>>::type;
+        const auto v = static_cast<underlying>(P::null_value());
+        return v > 0 ? static_cast<std::size_t>(std::bit_width(static_cast<std::make_unsigned_t<underlying>>(v))) : 0;
+      }();
+    };
+
+    // Policy::packed_bits if provided, otherwise derived from null_value() (0 if unknown)
+    template<typename T, typename P>
+    inline constexpr std::size_t default_packed_bits =
+        declared_packed_bits<P>::value ? declared_packed_bits<P>::value : null_value_bits<T, P>::value;
+
+  }  // namespace detail
+
+  // Array of opt<T, Policy> elements packed with Bits bits per element in 64-bit words (elements never cross word
+  // boundaries, so 64 % Bits bits of every word are unused).
+  //
+  // Elements are stored as the low Bits bits of the raw storage_type bit pattern and the all-ones code marks an empty
+  // element, so values have to be represented by bit patterns smaller than 2^Bits - 1. By default Bits is taken from
+  // Policy::packed_bits or derived from an integral null_value() that is greater than all the values (i.e. weekday
+  // values 0..6 with null 7 need 3 bits).
+  //
+  // Bulk operations process one word at a time with SWAR (SIMD within a register) arithmetic.
+  template<typename T, typename Policy = opt_default_policy<T>, std::size_t Bits = detail::default_packed_bits<T, Policy>>
+  class opt_packed_array {
+  public:
+    using value_type = opt<T, Policy>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using word_type = std::uint64_t;
+
+    static_assert(Bits > 0, "Policy does not define the range of values, consider providing 'Bits' explicitly");
+    static_assert(Bits <= 32, "'Bits > 32' consider using a vector of opt<T, Policy>");
+    static_assert(std::is_trivially_copyable_v<value_type> && detail::simd::has_raw_type<value_type>,
+                  "opt<T, Policy> should be a trivially copyable object of 1, 2, 4 or 8 bytes");
+
+    static constexpr size_type bits = Bits;
+    static constexpr size_type per_word = 64 / Bits;
+    static constexpr word_type code_mask = (word_type{1} << Bits) - 1;
+    static constexpr word_type null_code = code_mask;
+
+  private:
+    using raw_type = detail::simd::raw_type<value_type>;
+
+    // lowest bit of every used lane
+    static constexpr word_type lanes_low = [] {
+      word_type w = 0;
+      for(size_type i = 0; i < per_word; ++i) w |= word_type{1} << (i * Bits);
+      return w;
+    }();
+    static constexpr word_type lanes_high = lanes_low << (Bits - 1);
+    static constexpr word_type lanes_all = lanes_low * code_mask;
+    static constexpr word_type lanes_rest = lanes_all & ~lanes_high;
+    static constexpr word_type null_word = lanes_all;
+
+    // highest bit of every lane set if the lane of w is not zero
+    static constexpr word_type non_zero_lanes(word_type w) noexcept
+    {
+      return (((w & lanes_rest) + lanes_rest) | w) & lanes_high;
+    }
+
+    static raw_type raw_null() noexcept { return detail::simd::to_raw(value_type{}); }
+
+    static word_type encode(const value_type& v) noexcept
+    {
+      if(!v.has_value()) return null_code;
+      const auto code = static_cast<word_type>(detail::simd::to_raw(v));
+      assert(code < null_code && "value does not fit in 'Bits' bits");
+      return code;
+    }
+
+    static value_type decode(word_type code) noexcept
+    {
+      value_type v;
+      if(code != null_code) detail::simd::store(&v, static_cast<raw_type>(code));
+      return v;
+    }
+
+  public:
+    // proxy to an element
+    class reference {
+    public:
+      reference(const reference&) = default;
+      operator value_type() const noexcept { return a_->get(i_); }
+      reference& operator=(const value_type& v) noexcept
+      {
+        a_->set(i_, v);
+        return *this;
+      }
+      reference& operator=(const reference& other) noexcept { return *this = static_cast<value_type>(other); }
+
+      bool has_value() const noexcept { return a_->code(i_) != null_code; }
+      T operator*() const noexcept { return *a_->get(i_); }
+      void reset() noexcept { a_->set(i_, value_type{}); }
+
+    private:
+      friend class opt_packed_array;
+      opt_packed_array* a_;
+      size_type i_;
+
+      reference(opt_packed_array* a, size_type i) noexcept : a_{a}, i_{i} {}
+    };
+
+    template<bool Const>
+    class basic_iterator {
+      using array_type = std::conditional_t<Const, const opt_packed_array, opt_packed_array>;
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = opt_packed_array::value_type;
+      using difference_type = std::ptrdiff_t;
+      using reference = std::conditional_t<Const, value_type, opt_packed_array::reference>;
+      using pointer = void;
+
+      basic_iterator() = default;
+      template<bool C>
+        requires(Const && !C)
+      basic_iterator(const basic_iterator<C>& other) noexcept : a_{other.a_}, i_{other.i_}
+      {
+      }
+
+      reference operator*() const noexcept
+      {
+        if constexpr(Const)
+          return a_->get(i_);
+        else
+          return (*a_)[i_];
+      }
+      basic_iterator& operator++() noexcept
+      {
+        ++i_;
+        return *this;
+      }
+      basic_iterator operator++(int) noexcept
+      {
+        auto it = *this;
+        ++i_;
+        return it;
+      }
+      friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) noexcept { return lhs.i_ == rhs.i_; }
+
+    private:
+      friend class opt_packed_array;
+      friend class basic_iterator<!Const>;
+      array_type* a_ = nullptr;
+      size_type i_ = 0;
+
+      basic_iterator(array_type* a, size_type i) noexcept : a_{a}, i_{i} {}
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    opt_packed_array() = default;
+    explicit opt_packed_array(size_type count) { resize(count); }
+    explicit opt_packed_array(std::span<const value_type> values) { assign(values); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // packed representation (unused lanes of the last word are empty)
+    std::span<const word_type> words() const noexcept { return words_; }
+    size_type memory_usage() const noexcept { return words_.capacity() * sizeof(word_type); }
+
+    iterator begin() noexcept { return {this, 0}; }
+    iterator end() noexcept { return {this, size_}; }
+    const_iterator begin() const noexcept { return {this, 0}; }
+    const_iterator end() const noexcept { return {this, size_}; }
+
+    value_type get(size_type i) const noexcept { return decode(code(i)); }
+    void set(size_type i, const value_type& v) noexcept
+    {
+      assert(i < size_);
+      const auto shift = i % per_word * Bits;
+      auto& w = words_[i / per_word];
+      w = (w & ~(code_mask << shift)) | encode(v) << shift;
+    }
+
+    value_type operator[](size_type i) const noexcept { return get(i); }
+    reference operator[](size_type i) noexcept
+    {
+      assert(i < size_);
+      return {this, i};
+    }
+
+    // new elements are empty
+    void resize(size_type count)
+    {
+      words_.resize((count + per_word - 1) / per_word, null_word);
+      if(count < size_ && count % per_word != 0) {
+        // empty the unused lanes of the last word
+        const auto used = (word_type{1} << (count % per_word * Bits)) - 1;
+        words_.back() = (words_.back() & used) | (null_word & ~used);
+      }
+      size_ = count;
+    }
+
+    void push_back(const value_type& v)
+    {
+      resize(size_ + 1);
+      set(size_ - 1, v);
+    }
+
+    // replaces the content with packed `values`
+    void assign(std::span<const value_type> values)
+    {
+      words_.assign((values.size() + per_word - 1) / per_word, null_word);
+      size_ = values.size();
+      for(size_type n = 0; n < words_.size(); ++n) {
+        const auto first = n * per_word;
+        const auto count = std::min(per_word, size_ - first);
+        word_type w = count == per_word ? 0 : null_word & ~((word_type{1} << (count * Bits)) - 1);
+        for(size_type j = 0; j < count; ++j) w |= encode(values[first + j]) << (j * Bits);
+        words_[n] = w;
+      }
+    }
+
+    // unpacks all elements to `out` (out.size() == size())
+    void unpack(std::span<value_type> out) const noexcept
+    {
+      assert(out.size() == size_);
+      const auto null = raw_null();
+      const auto unpack_word = [&](word_type w, value_type* dst, size_type count) {
+        for(size_type j = 0; j < count; ++j) {
+          const auto c = (w >> (j * Bits)) & code_mask;
+          detail::simd::store(dst + j, c == null_code ? null : static_cast<raw_type>(c));
+        }
+      };
+      size_type n = 0;
+      // constant trip count for complete words lets the compiler unroll and vectorize the loop
+      for(; (n + 1) * per_word <= size_; ++n) unpack_word(words_[n], out.data() + n * per_word, per_word);
+      if(n < words_.size()) unpack_word(words_[n], out.data() + n * per_word, size_ - n * per_word);
+    }
+
+    // number of not empty elements
+    size_type count_values() const noexcept
+    {
+      size_type count = 0;
+      for(const auto w : words_) count += static_cast<size_type>(std::popcount(non_zero_lanes(~w & lanes_all)));
+      return count;
+    }
+
+    // index of the first element equal to v (empty elements are equal to each other) or size() if there is none
+    size_type find(const value_type& v) const noexcept
+    {
+      const auto pattern = lanes_low * encode(v);
+      for(size_type n = 0; n < words_.size(); ++n)
+        if(const auto eq = ~non_zero_lanes(words_[n] ^ pattern) & lanes_high; eq != 0)
+          return std::min(n * per_word + static_cast<size_type>(std::countr_zero(eq)) / Bits, size_);
+      return size_;
+    }
+
+    size_type find_first_null() const noexcept { return find(value_type{}); }
+
+    size_type find_first_value() const noexcept
+    {
+      for(size_type n = 0; n < words_.size(); ++n)
+        if(const auto nz = non_zero_lanes(~words_[n] & lanes_all); nz != 0)
+          return std::min(n * per_word + static_cast<size_type>(std::countr_zero(nz)) / Bits, size_);
+      return size_;
+    }
+
+  private:
+    std::vector<word_type> words_;
+    size_type size_ = 0;
+
+    word_type code(size_type i) const noexcept
+    {
+      assert(i < size_);
+      return (words_[i / per_word] >> (i % per_word * Bits)) & code_mask;
+    }
+  };
+
+}
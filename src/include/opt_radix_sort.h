@@ -0,0 +1,326 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt_algorithms.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mp {
+
+  namespace detail {
+
+    // integral, enumeration and IEEE 754 floating-point values stored directly with a bitwise null
+    template<typename Opt>
+    inline constexpr bool is_radix_sortable =
+        is_raw_value_opt<Opt> &&
+        ((std::is_integral_v<typename Opt::value_type> && !std::is_same_v<typename Opt::value_type, bool>) ||
+         std::is_enum_v<typename Opt::value_type> ||
+         (std::is_floating_point_v<typename Opt::value_type> &&
+          std::numeric_limits<typename Opt::value_type>::is_iec559));
+
+    // bijection between raw values of opt<T, P> and unsigned keys that are in the order of T values (IEEE 754
+    // totalOrder for floating-point ones) with the null value moved to the chosen end
+    template<typename T, typename P, opt_null_order Order>
+    struct radix_key {
+      using key_type = simd::raw_type<T>;
+      static constexpr int bits = std::numeric_limits<key_type>::digits;
+      static constexpr key_type sign = static_cast<key_type>(key_type{1} << (bits - 1));
+
+      // flips the sign bit of signed integers and all bits of negative floating-point values
+      static constexpr key_type ordered(key_type raw) noexcept
+      {
+        if constexpr(std::is_floating_point_v<T>)
+          return static_cast<key_type>(raw ^ (static_cast<key_type>(key_type{0} - (raw >> (bits - 1))) | sign));
+        else if constexpr(std::is_signed_v<typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                                                                         std::type_identity<T>>::type>)
+          return static_cast<key_type>(raw ^ sign);
+        else
+          return raw;
+      }
+
+      static constexpr key_type unordered(key_type key) noexcept
+      {
+        if constexpr(std::is_floating_point_v<T>)
+          return static_cast<key_type>(key ^ (static_cast<key_type>((key >> (bits - 1)) - 1) | sign));
+        else
+          return ordered(key);
+      }
+
+      static constexpr key_type null = ordered(std::bit_cast<key_type>(T{opt_policy_traits<T, P>::null_value()}));
+
+      // keys on one side of the null one are shifted by one to take its place
+      static constexpr key_type encode(key_type raw) noexcept
+      {
+        const key_type key = ordered(raw);
+        if constexpr(Order == opt_null_order::first)
+          return static_cast<key_type>((key + (key < null)) & (key_type{0} - (key != null)));
+        else
+          return static_cast<key_type>((key - (key > null)) | (key_type{0} - (key == null)));
+      }
+
+      static constexpr key_type decode(key_type key) noexcept
+      {
+        if constexpr(Order == opt_null_order::first)
+          return unordered(key == 0 ? null : static_cast<key_type>(key - (key <= null)));
+        else
+          return unordered(key == std::numeric_limits<key_type>::max() ? null
+                                                                       : static_cast<key_type>(key + (key >= null)));
+      }
+    };
+
+    inline constexpr std::size_t radix_buckets = 256;
+
+    // elements per thread below which additional threads are not worth starting
+    inline constexpr std::size_t radix_min_chunk = std::size_t{1} << 16;
+
+    // keys scattered to 256 buckets are first gathered in cache line sized buffers and written in whole lines
+    template<typename Key>
+    class radix_scatter_buffers {
+      static constexpr std::size_t line = 64 / sizeof(Key);
+      alignas(64) Key buffers_[radix_buckets][line];
+      std::uint8_t used_[radix_buckets] = {};
+
+    public:
+      void push(std::byte* out, std::size_t* offsets, std::size_t bucket, Key key) noexcept
+      {
+        std::size_t used = used_[bucket];
+        buffers_[bucket][used++] = key;
+        if(used == line) {
+          std::memcpy(out + offsets[bucket] * sizeof(Key), buffers_[bucket], sizeof(buffers_[bucket]));
+          offsets[bucket] += line;
+          used = 0;
+        }
+        used_[bucket] = static_cast<std::uint8_t>(used);
+      }
+
+      void flush(std::byte* out, const std::size_t* offsets) noexcept
+      {
+        for(std::size_t b = 0; b < radix_buckets; ++b) {
+          std::memcpy(out + offsets[b] * sizeof(Key), buffers_[b], used_[b] * sizeof(Key));
+          used_[b] = 0;
+        }
+      }
+    };
+
+    // Stable LSD radix sort of opt<T, P> objects (and optionally of payload permuted in the same way) with 8-bit
+    // digits. Keys are encoded in place and sorted back and forth between `values` and a temporary buffer. Digits
+    // that are equal for all elements are skipped. With many threads each of them processes a chunk of the same size
+    // and scatters it to its own part of every bucket. Returns false without touching the input if not all of the
+    // threads could be started.
+    template<opt_null_order Order, typename T, typename P, typename V>
+    bool radix_sort_chunks(opt<T, P>* values, V* payload, std::size_t size, unsigned threads)
+    {
+      using traits = radix_key<T, P, Order>;
+      using key_type = typename traits::key_type;
+      using histogram = std::array<std::size_t, radix_buckets>;
+      constexpr std::size_t digits = sizeof(key_type);
+      constexpr bool has_payload = !std::is_void_v<V>;
+      using payload_type = std::conditional_t<has_payload, V, char>;
+
+      const std::size_t chunk = (size + threads - 1) / threads;
+
+      // keys are accessed with simd::load()/store() as the memory of `values` holds opt<T, P> objects
+      const auto tmp_keys = std::make_unique_for_overwrite<key_type[]>(size);
+      std::byte* const keys[2] = {reinterpret_cast<std::byte*>(values), reinterpret_cast<std::byte*>(tmp_keys.get())};
+      auto key_at = [&](int buffer, std::size_t i) {
+        return simd::load<key_type>(keys[buffer] + i * sizeof(key_type));
+      };
+      payload_type* payloads[2] = {};
+      std::unique_ptr<payload_type[]> tmp_payload;
+      if constexpr(has_payload) {
+        tmp_payload = std::make_unique_for_overwrite<payload_type[]>(size);
+        payloads[0] = payload;
+        payloads[1] = tmp_payload.get();
+      }
+      // per thread histograms of all digits of its chunk
+      std::vector<std::array<histogram, digits>> counts(threads);
+      std::vector<radix_scatter_buffers<key_type>> scatters(has_payload ? 0 : threads);
+      std::barrier sync{static_cast<std::ptrdiff_t>(threads)};
+
+      auto work = [&](unsigned t) {
+        const std::size_t begin = std::min(size, t * chunk), end = std::min(size, begin + chunk);
+        auto& own = counts[t];
+        {
+          // local copies are not aliased by the stores of keys; even and odd elements are counted separately so that
+          // runs of equal digits (i.e. of null values) do not make every increment wait for the previous one
+          std::array<histogram, digits> local[2] = {};
+          for(std::size_t i = begin; i < end; ++i) {
+            const key_type key = traits::encode(key_at(0, i));
+            simd::store(keys[0] + i * sizeof(key_type), key);
+            for(std::size_t d = 0; d < digits; ++d) ++local[i & 1][d][(key >> (8 * d)) & 0xFF];
+          }
+          for(std::size_t d = 0; d < digits; ++d)
+            for(std::size_t b = 0; b < radix_buckets; ++b) own[d][b] = local[0][d][b] + local[1][d][b];
+        }
+        sync.arrive_and_wait();
+
+        // the histograms of the whole input do not change between the passes
+        std::array<bool, digits> active{};
+        for(std::size_t d = 0; d < digits; ++d)
+          for(std::size_t b = 0; b < radix_buckets; ++b) {
+            std::size_t total = 0;
+            for(const auto& c : counts) total += c[d][b];
+            if(total != 0) {
+              active[d] = total != size;
+              break;
+            }
+          }
+        // the histograms are recounted in the following passes
+        if(threads > 1) sync.arrive_and_wait();
+
+        int src = 0;
+        bool first_pass = true;
+        for(std::size_t d = 0; d < digits; ++d) {
+          if(!active[d]) continue;
+          const unsigned shift = static_cast<unsigned>(8 * d);
+          // the chunk of the input is different than in the previous pass
+          if(!first_pass && threads > 1) {
+            own[d].fill(0);
+            for(std::size_t i = begin; i < end; ++i) ++own[d][(key_at(src, i) >> shift) & 0xFF];
+            sync.arrive_and_wait();
+          }
+          histogram offsets;
+          std::size_t offset = 0;
+          for(std::size_t b = 0; b < radix_buckets; ++b) {
+            for(unsigned u = 0; u < threads; ++u) {
+              if(u == t) offsets[b] = offset;
+              offset += counts[u][d][b];
+            }
+          }
+          std::byte* const out = keys[src ^ 1];
+          if constexpr(has_payload) {
+            const payload_type* pin = payloads[src];
+            payload_type* pout = payloads[src ^ 1];
+            for(std::size_t i = begin; i < end; ++i) {
+              const key_type key = key_at(src, i);
+              const std::size_t j = offsets[(key >> shift) & 0xFF]++;
+              simd::store(out + j * sizeof(key_type), key);
+              pout[j] = pin[i];
+            }
+          }
+          else {
+            for(std::size_t i = begin; i < end; ++i) {
+              const key_type key = key_at(src, i);
+              scatters[t].push(out, offsets.data(), (key >> shift) & 0xFF, key);
+            }
+            scatters[t].flush(out, offsets.data());
+          }
+          src ^= 1;
+          first_pass = false;
+          sync.arrive_and_wait();
+        }
+
+        for(std::size_t i = begin; i < end; ++i)
+          simd::store(keys[0] + i * sizeof(key_type), traits::decode(key_at(src, i)));
+        if constexpr(has_payload) {
+          if(src == 1) std::copy(payloads[1] + begin, payloads[1] + end, payload + begin);
+        }
+      };
+
+      // workers start only when all of them are created; otherwise they quit before arriving at the barrier that
+      // would wait for the missing ones
+      enum class start { pending, run, quit };
+      std::atomic<start> go{start::pending};
+      std::vector<std::jthread> workers;
+      try {
+        workers.reserve(threads - 1);
+        for(unsigned t = 1; t < threads; ++t)
+          workers.emplace_back([&, t] {
+            go.wait(start::pending);
+            if(go.load() == start::run) work(t);
+          });
+      }
+      catch(...) {
+        go = start::quit;
+        go.notify_all();
+        return false;
+      }
+      go = start::run;
+      go.notify_all();
+      work(0);
+      return true;
+    }
+
+    template<opt_null_order Order, typename T, typename P, typename V>
+    void radix_sort(opt<T, P>* values, V* payload, std::size_t size, unsigned threads)
+    {
+      if(size < 2) return;
+      if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+      threads = static_cast<unsigned>(std::clamp<std::size_t>(size / radix_min_chunk, 1, threads));
+      // the calling thread sorts alone if the system cannot provide more of them
+      if(!radix_sort_chunks<Order>(values, payload, size, threads)) radix_sort_chunks<Order>(values, payload, size, 1);
+    }
+
+    template<typename T, typename P, typename V>
+    void radix_sort(opt<T, P>* values, V* payload, std::size_t size, opt_null_order order, unsigned threads)
+    {
+      static_assert(is_radix_sortable<opt<T, P>>,
+                    "integral, enumeration or floating-point values stored with a bitwise null are required, consider "
+                    "using std::sort() with OPT_REL_OPS");
+      if(order == opt_null_order::first)
+        radix_sort<opt_null_order::first>(values, payload, size, threads);
+      else
+        radix_sort<opt_null_order::last>(values, payload, size, threads);
+    }
+
+  }  // namespace detail
+
+  // Sorts opt<T, Policy> objects storing integral, enumeration or floating-point values with a bitwise null (i.e.
+  // opt_null_value_policy<T, V> or opt_nan_policy<T>) in O(n) with a stable LSD radix sort. Empty objects are
+  // placed at the beginning or at the end depending on `order`. Floating-point values are ordered according to IEEE 754
+  // totalOrder (-0.0 before 0.0, negative NaNs first and positive ones last). `threads` of 0 uses all hardware
+  // threads; small inputs are always sorted by the calling thread only.
+  template<typename T, typename P, std::size_t Extent>
+  void opt_radix_sort(std::span<opt<T, P>, Extent> values, opt_null_order order = opt_policy_traits<T, P>::null_order,
+                      unsigned threads = 1)
+  {
+    detail::radix_sort(values.data(), static_cast<void*>(nullptr), values.size(), order, threads);
+  }
+
+  // as above but additionally permutes `payload` in the same way as `keys` (i.e. row indices or values of another
+  // column); the relative order of payload elements with equal keys is preserved
+  template<typename T, typename P, std::size_t Extent1, typename V, std::size_t Extent2>
+  void opt_radix_sort(std::span<opt<T, P>, Extent1> keys, std::span<V, Extent2> payload,
+                      opt_null_order order = opt_policy_traits<T, P>::null_order, unsigned threads = 1)
+  {
+    static_assert(std::is_trivially_copyable_v<V> && !std::is_const_v<V>,
+                  "trivially copyable payload is required, consider sorting indices of the elements instead");
+    assert(payload.size() >= keys.size());
+    detail::radix_sort(keys.data(), payload.data(), keys.size(), order, threads);
+  }
+
+}  // namespace mp
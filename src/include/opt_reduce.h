@@ -0,0 +1,321 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt_algorithms.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mp {
+
+  namespace detail {
+
+    // default type of sums of T values
+    template<typename T>
+    using reduce_sum_t =
+        std::conditional_t<std::is_floating_point_v<T>, std::conditional_t<(sizeof(T) > sizeof(double)), T, double>,
+                           std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>>;
+
+    // null of integral sums; without extreme values only a sum that wraps on overflow can be equal to it
+    template<typename R>
+    inline constexpr R reduce_sum_null = std::is_signed_v<R> ? std::numeric_limits<R>::min()
+                                                             : std::numeric_limits<R>::max();
+    template<typename R>
+    using reduce_sum_policy = opt_null_value_policy<R, reduce_sum_null<R>>;
+
+    // opt<R> with a NaN null for 'float' and 'double', opt<R> if opt_default_policy<R> is specialized, opt<R> with
+    // reduce_sum_null<R> for other integral types, std::optional<R> otherwise
+    template<typename R>
+    using reduce_result_t =
+        std::conditional_t<std::is_same_v<R, float> || std::is_same_v<R, double>, opt<R, opt_nan_policy<R>>,
+                           std::conditional_t<has_default_policy<R>::value, opt<R, opt_default_policy<R>>,
+                                              std::conditional_t<std::is_integral_v<R>, opt<R, reduce_sum_policy<R>>,
+                                                                 std::optional<R>>>>;
+
+    // a sum equal to reduce_sum_null<R> is returned as empty
+    template<typename R>
+    constexpr reduce_result_t<R> make_reduce_result(R sum) noexcept
+    {
+      if constexpr(std::is_same_v<reduce_result_t<R>, opt<R, reduce_sum_policy<R>>>)
+        if(sum == reduce_sum_null<R>) return {};
+      return sum;
+    }
+
+    // integral sums wrap on overflow instead of invoking undefined behavior
+    template<typename R>
+    using reduce_acc_t = typename std::conditional_t<std::is_integral_v<R>, std::make_unsigned<R>,
+                                                     std::type_identity<R>>::type;
+
+    enum reduce_ops : unsigned { reduce_sum = 1, reduce_min_max = 2 };
+
+    // elements reduced to a single partial result; results do not depend on the number of threads because the blocks
+    // are always the same and their partial results are combined in the same order
+    inline constexpr std::size_t reduce_block = std::size_t{1} << 16;
+
+    template<typename T, typename R>
+    struct reduce_partial {
+      std::size_t count = 0;
+      reduce_acc_t<R> sum{};
+      T min{};
+      T max{};
+      bool ordered = false;  // min and max are valid (there is a value other than NaN)
+
+      void merge(const reduce_partial& other) noexcept
+      {
+        count += other.count;
+        sum += other.sum;
+        if(!other.ordered) return;
+        if(!ordered || other.min < min) min = other.min;
+        if(!ordered || max < other.max) max = other.max;
+        ordered = true;
+      }
+    };
+
+    // initial min and max that are not less or greater than any value
+    template<typename T>
+    inline constexpr T reduce_lowest =
+        std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    template<typename T>
+    inline constexpr T reduce_highest =
+        std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+
+    // Raw values are reduced in `lanes` independent accumulators (element i goes to lane i % lanes) so floating-point
+    // sums do not depend on the target ISA. Empty elements are masked out (replaced with 0 for sums and with values
+    // that do not change min and max) instead of branching, so the loop over lanes is vectorized.
+    template<unsigned Ops, typename R, typename Opt>
+    reduce_partial<typename std::remove_const_t<Opt>::value_type, R> reduce_block_raw(Opt* values,
+                                                                                      std::size_t size) noexcept
+    {
+      using T = typename std::remove_const_t<Opt>::value_type;
+      using raw = simd::raw_type<T>;
+      using acc_type = reduce_acc_t<R>;
+      constexpr std::size_t lanes = 8;
+      constexpr raw raw_lowest = std::bit_cast<raw>(reduce_lowest<T>);
+      constexpr raw raw_highest = std::bit_cast<raw>(reduce_highest<T>);
+
+      const raw null = raw_null<Opt>();
+      const auto* bytes = reinterpret_cast<const std::byte*>(values);
+      std::size_t count[lanes] = {};
+      acc_type sum[lanes] = {};
+      T min[lanes], max[lanes];
+      std::fill_n(min, lanes, reduce_highest<T>);
+      std::fill_n(max, lanes, reduce_lowest<T>);
+
+      const auto step = [&](std::size_t j, std::size_t i) {
+        const raw r = simd::load<raw>(bytes + i * sizeof(T));
+        const raw mask = static_cast<raw>(raw{0} - static_cast<raw>(r != null));
+        count[j] += mask & 1u;
+        if constexpr((Ops & reduce_sum) != 0)
+          sum[j] += static_cast<acc_type>(std::bit_cast<T>(static_cast<raw>(r & mask)));
+        if constexpr((Ops & reduce_min_max) != 0) {
+          // NaN values are never less or greater than the current ones
+          const T lo = std::bit_cast<T>(static_cast<raw>((r & mask) | (raw_highest & ~mask)));
+          const T hi = std::bit_cast<T>(static_cast<raw>((r & mask) | (raw_lowest & ~mask)));
+          min[j] = lo < min[j] ? lo : min[j];
+          max[j] = max[j] < hi ? hi : max[j];
+        }
+      };
+      std::size_t i = 0;
+      for(; i + lanes <= size; i += lanes) {
+#if defined(__GNUC__) && !defined(__clang__)
+        // keeps the loop for the vectorizer, otherwise GCC unrolls it and reduces every lane separately
+#pragma GCC unroll 1
+#endif
+        for(std::size_t j = 0; j < lanes; ++j) step(j, i + j);
+      }
+      for(std::size_t j = 0; i < size; ++i, ++j) step(j, i);
+
+      // pairwise in a fixed order
+      for(std::size_t width = lanes / 2; width > 0; width /= 2)
+        for(std::size_t j = 0; j < width; ++j) {
+          count[j] += count[j + width];
+          sum[j] += sum[j + width];
+          min[j] = min[j + width] < min[j] ? min[j + width] : min[j];
+          max[j] = max[j] < max[j + width] ? max[j + width] : max[j];
+        }
+      // any value that is not NaN is in [min, max]
+      return {count[0], sum[0], min[0], max[0], (Ops & reduce_min_max) != 0 && min[0] <= max[0]};
+    }
+
+    template<unsigned Ops, typename R, typename Opt>
+    reduce_partial<typename std::remove_const_t<Opt>::value_type, R> reduce_block_generic(Opt* values,
+                                                                                          std::size_t size)
+    {
+      reduce_partial<typename std::remove_const_t<Opt>::value_type, R> result;
+      for(std::size_t i = 0; i < size; ++i) {
+        if(!values[i].has_value()) continue;
+        const auto x = *values[i];
+        ++result.count;
+        if constexpr((Ops & reduce_sum) != 0) result.sum += static_cast<reduce_acc_t<R>>(x);
+        if constexpr((Ops & reduce_min_max) != 0) {
+          if(x != x) continue;  // NaN
+          if(!result.ordered || x < result.min) result.min = x;
+          if(!result.ordered || result.max < x) result.max = x;
+          result.ordered = true;
+        }
+      }
+      return result;
+    }
+
+    template<unsigned Ops, typename R, typename Opt, std::size_t Extent>
+    reduce_partial<typename std::remove_const_t<Opt>::value_type, R> reduce(std::span<Opt, Extent> values,
+                                                                            unsigned threads)
+    {
+      using T = typename std::remove_const_t<Opt>::value_type;
+      static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                    "arithmetic values are required, consider using std::reduce() with opt<T, Policy>::value_or()");
+      const auto reduce_one = [&](std::size_t b) {
+        const std::size_t begin = b * reduce_block;
+        const std::size_t size = std::min(reduce_block, values.size() - begin);
+        if constexpr(is_raw_value_opt<Opt>)
+          return reduce_block_raw<Ops, R>(values.data() + begin, size);
+        else
+          return reduce_block_generic<Ops, R>(values.data() + begin, size);
+      };
+
+      const std::size_t blocks = (values.size() + reduce_block - 1) / reduce_block;
+      if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+      threads = static_cast<unsigned>(std::clamp<std::size_t>(blocks, 1, threads));
+
+      reduce_partial<T, R> result;
+      if(threads == 1) {
+        for(std::size_t b = 0; b < blocks; ++b) result.merge(reduce_one(b));
+        return result;
+      }
+
+      // every thread reduces a contiguous range of blocks
+      std::vector<reduce_partial<T, R>> partials(blocks);
+      {
+        const auto work = [&](unsigned t) {
+          const std::size_t end = blocks * (t + 1) / threads;
+          for(std::size_t b = blocks * t / threads; b < end; ++b) partials[b] = reduce_one(b);
+        };
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+        for(unsigned t = 1; t < threads; ++t) workers.emplace_back(work, t);
+        work(0);
+      }
+      for(const auto& p : partials) result.merge(p);
+      return result;
+    }
+
+    template<typename R, typename Opt>
+    using reduce_sum_type =
+        std::conditional_t<std::is_void_v<R>, reduce_sum_t<typename std::remove_const_t<Opt>::value_type>, R>;
+
+  }  // namespace detail
+
+  // Parallel reductions over contiguous ranges of opt<T, Policy> storing arithmetic values
+  //
+  // Empty elements are skipped and the result is empty if there are no values. Elements are reduced in blocks of a
+  // fixed size and the partial results are combined in order, so floating-point results are the same for any
+  // `threads` (0 uses all hardware threads). Values stored directly with a bitwise null are reduced with vectorized
+  // branchless loops. Other ones fall back to opt<T, Policy>::has_value() called for every element.
+
+  // statistics of values computed in one pass
+  template<typename Opt, typename R>
+  struct opt_reduction {
+    std::size_t count = 0;
+    detail::reduce_result_t<R> sum;
+    std::remove_const_t<Opt> min;
+    std::remove_const_t<Opt> max;
+    opt<double, opt_nan_policy<double>> mean;
+  };
+
+  // number of not empty elements
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::size_t opt_reduce_count(std::span<Opt, Extent> values, unsigned threads = 1)
+  {
+    return detail::reduce<0, std::uint64_t>(values, threads).count;
+  }
+
+  // sum of values in R (std::int64_t, std::uint64_t or double by default); integral sums wrap on overflow and use the
+  // smallest signed or the largest unsigned value as null, so such a sum is reported as empty
+  template<typename R = void, typename Opt, std::size_t Extent,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  detail::reduce_result_t<detail::reduce_sum_type<R, Opt>> opt_reduce_sum(std::span<Opt, Extent> values,
+                                                                          unsigned threads = 1)
+  {
+    using sum_type = detail::reduce_sum_type<R, Opt>;
+    const auto result = detail::reduce<detail::reduce_sum, sum_type>(values, threads);
+    if(result.count == 0) return {};
+    return detail::make_reduce_result(static_cast<sum_type>(result.sum));
+  }
+
+  // the smallest value; NaN values are skipped as well
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::remove_const_t<Opt> opt_reduce_min(std::span<Opt, Extent> values, unsigned threads = 1)
+  {
+    const auto result = detail::reduce<detail::reduce_min_max, std::uint64_t>(values, threads);
+    if(!result.ordered) return {};
+    return result.min;
+  }
+
+  // the largest value; NaN values are skipped as well
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  std::remove_const_t<Opt> opt_reduce_max(std::span<Opt, Extent> values, unsigned threads = 1)
+  {
+    const auto result = detail::reduce<detail::reduce_min_max, std::uint64_t>(values, threads);
+    if(!result.ordered) return {};
+    return result.max;
+  }
+
+  // arithmetic mean of values
+  template<typename Opt, std::size_t Extent, detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  opt<double, opt_nan_policy<double>> opt_reduce_mean(std::span<Opt, Extent> values, unsigned threads = 1)
+  {
+    using sum_type = detail::reduce_sum_type<void, Opt>;
+    const auto result = detail::reduce<detail::reduce_sum, sum_type>(values, threads);
+    if(result.count == 0) return {};
+    return static_cast<double>(static_cast<sum_type>(result.sum)) / static_cast<double>(result.count);
+  }
+
+  // count, sum, min, max and mean at once
+  template<typename R = void, typename Opt, std::size_t Extent,
+           detail::Requires<detail::is_opt<std::remove_const_t<Opt>>> = true>
+  opt_reduction<Opt, detail::reduce_sum_type<R, Opt>> opt_reduce(std::span<Opt, Extent> values, unsigned threads = 1)
+  {
+    using sum_type = detail::reduce_sum_type<R, Opt>;
+    const auto result =
+        detail::reduce<detail::reduce_sum | detail::reduce_min_max, sum_type>(values, threads);
+    opt_reduction<Opt, sum_type> reduction;
+    reduction.count = result.count;
+    if(result.count == 0) return reduction;
+    reduction.sum = detail::make_reduce_result(static_cast<sum_type>(result.sum));
+    if(result.ordered) {
+      reduction.min = result.min;
+      reduction.max = result.max;
+    }
+    reduction.mean = static_cast<double>(static_cast<sum_type>(result.sum)) / static_cast<double>(result.count);
+    return reduction;
+  }
+
+}  // namespace mp
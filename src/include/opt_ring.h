@@ -0,0 +1,148 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "atomic_opt.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+namespace mp {
+
+  // Bounded lock-free single-producer single-consumer FIFO queue of N (a power of 2) elements of type T.
+  //
+  // Slots are atomic_opt<T, Policy> objects and an empty one is free, so no sequence numbers or other per-slot state
+  // is needed and the ring takes N * sizeof(T) bytes beside the head and tail counters (placed in separate cache
+  // lines). The producer writes a slot only when it is empty and the consumer reads it only when it is not, so
+  // pushing the null value is not allowed. try_*() functions never wait; a consumer that has to wait for data spins
+  // on try_pop() (i.e. on has_value() of the next slot).
+  template<typename T, typename Policy, std::size_t N>
+  class opt_ring {
+  public:
+    using value_type = T;
+    using opt_type = opt<T, Policy>;
+    using size_type = std::size_t;
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "'N' should be a power of 2");
+    static_assert(atomic_opt<T, Policy>::is_always_lock_free,
+                  "lock-free atomic_opt<T, Policy> required, consider using a queue guarded by a mutex");
+
+    static constexpr size_type cache_line_size = 64;
+
+    opt_ring() noexcept = default;
+    opt_ring(const opt_ring&) = delete;
+    opt_ring& operator=(const opt_ring&) = delete;
+
+    static constexpr size_type capacity() noexcept { return N; }
+
+    // number of elements; may be outdated by the time it returns if other threads are using the queue
+    size_type size() const noexcept
+    {
+      const auto t = tail_.load(std::memory_order_relaxed);
+      const auto h = head_.load(std::memory_order_relaxed);
+      return h > t ? std::min(h - t, N) : 0;
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    // pushes value or returns false if the queue is full; called by the producer only
+    bool try_push(const T& value) noexcept { return try_push_n(std::span<const T>{&value, 1}) == 1; }
+
+    // pops the oldest element or returns an empty opt if the queue is empty; called by the consumer only
+    opt_type try_pop() noexcept
+    {
+      const auto t = tail_.load(std::memory_order_relaxed);
+      auto& slot = slots_[t & mask];
+      const auto v = slot.load(std::memory_order_acquire);
+      if(v.has_value()) {
+        slot.reset(std::memory_order_release);
+        tail_.store(t + 1, std::memory_order_relaxed);
+      }
+      return v;
+    }
+
+    // pushes as many values from the beginning of `values` as there are free slots for and returns their number;
+    // called by the producer only
+    size_type try_push_n(std::span<const T> values) noexcept
+    {
+      const auto h = head_.load(std::memory_order_relaxed);
+      const auto count = ready(h, values.size(), false);
+      for(size_type i = 0; i < count; ++i) {
+        assert(opt_type{values[i]}.has_value() && "null value cannot be pushed");
+        slots_[(h + i) & mask].store(opt_type{values[i]}, std::memory_order_release);
+      }
+      head_.store(h + count, std::memory_order_relaxed);
+      return count;
+    }
+
+    // pops up to `out.size()` elements and returns their number; called by the consumer only
+    size_type try_pop_n(std::span<T> out) noexcept
+    {
+      const auto t = tail_.load(std::memory_order_relaxed);
+      const auto count = ready(t, out.size(), true);
+      for(size_type i = 0; i < count; ++i) {
+        auto& slot = slots_[(t + i) & mask];
+        out[i] = *slot.load(std::memory_order_relaxed);
+        slot.reset(std::memory_order_release);
+      }
+      tail_.store(t + count, std::memory_order_relaxed);
+      return count;
+    }
+
+  private:
+    static constexpr size_type mask = N - 1;
+
+    // number of consecutive slots starting at `pos` (up to `max`) that are full (or empty if `full` is false); the
+    // producer fills and the consumer empties slots in order, so the ready slots always form a prefix that is found
+    // with a binary search; the acquire load of the last ready slot makes all of them visible
+    size_type ready(size_type pos, size_type max, bool full) const noexcept
+    {
+      const auto is_ready = [&](size_type i) {
+        return slots_[(pos + i) & mask].load(std::memory_order_acquire).has_value() == full;
+      };
+      // a full or empty ring and a whole batch take a single load
+      size_type hi = std::min(max, N);
+      if(hi == 0 || !is_ready(0)) return 0;
+      if(is_ready(hi - 1)) return hi;
+      size_type lo = 1;
+      --hi;
+      while(lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if(is_ready(mid))
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      return lo;
+    }
+
+    // head_ and tail_ are written only by the producer and the consumer respectively and are read by size()
+    alignas(cache_line_size) std::atomic<size_type> head_{0};
+    alignas(cache_line_size) std::atomic<size_type> tail_{0};
+    alignas(cache_line_size) std::array<atomic_opt<T, Policy>, N> slots_;
+  };
+
+}
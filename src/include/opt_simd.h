@@ -0,0 +1,553 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define OPT_SIMD_AVX512
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define OPT_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OPT_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(OPT_SIMD_AVX512) || defined(OPT_SIMD_AVX2) || defined(OPT_SIMD_SSE2)
+#define OPT_SIMD
+#endif
+
+namespace mp {
+  namespace detail {
+    namespace simd {
+
+      // unsigned integer type used to process raw bit patterns of T
+      template<std::size_t Size>
+      struct raw_type_impl;
+      template<>
+      struct raw_type_impl<1> {
+        using type = std::uint8_t;
+      };
+      template<>
+      struct raw_type_impl<2> {
+        using type = std::uint16_t;
+      };
+      template<>
+      struct raw_type_impl<4> {
+        using type = std::uint32_t;
+      };
+      template<>
+      struct raw_type_impl<8> {
+        using type = std::uint64_t;
+      };
+      template<typename T>
+      using raw_type = typename raw_type_impl<sizeof(T)>::type;
+
+      template<typename T>
+      inline constexpr bool has_raw_type = sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8;
+
+      // raw (alias-safe) access to the memory of contiguous objects
+      template<typename U>
+      inline U load(const void* ptr) noexcept
+      {
+        U v;
+        std::memcpy(&v, ptr, sizeof(U));
+        return v;
+      }
+
+      template<typename U>
+      inline void store(void* ptr, U v) noexcept
+      {
+        std::memcpy(ptr, &v, sizeof(U));
+      }
+
+      template<typename T>
+      inline raw_type<T> to_raw(const T& v) noexcept
+      {
+        return load<raw_type<T>>(&v);
+      }
+
+      inline void prefetch(const void* ptr) noexcept
+      {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr);
+#elif defined(OPT_SIMD)
+        _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+        (void)ptr;
+#endif
+      }
+
+      // packs 2-bit groups of byte mask produced for 16-bit lanes into one bit per lane
+      inline std::uint64_t compress_16bit_lanes(std::uint64_t m) noexcept
+      {
+        m &= 0x5555'5555'5555'5555;
+        m = (m | (m >> 1)) & 0x3333'3333'3333'3333;
+        m = (m | (m >> 2)) & 0x0f0f'0f0f'0f0f'0f0f;
+        m = (m | (m >> 4)) & 0x00ff'00ff'00ff'00ff;
+        m = (m | (m >> 8)) & 0x0000'ffff'0000'ffff;
+        m = (m | (m >> 16)) & 0x0000'0000'ffff'ffff;
+        return m;
+      }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+      // GCC reports partial out of bounds vector loads for short arrays of known size even though the kernels load
+      // only complete registers
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+
+#if defined(OPT_SIMD_AVX512)
+
+      struct isa {
+        using reg = __m512i;
+        static constexpr std::size_t bytes = 64;
+
+        static reg load(const void* ptr) noexcept { return _mm512_loadu_si512(ptr); }
+        static void store(void* ptr, reg v) noexcept { _mm512_storeu_si512(ptr, v); }
+
+        template<typename U>
+        static reg broadcast(U v) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm512_set1_epi8(static_cast<char>(v));
+          else if constexpr(sizeof(U) == 2)
+            return _mm512_set1_epi16(static_cast<short>(v));
+          else if constexpr(sizeof(U) == 4)
+            return _mm512_set1_epi32(static_cast<int>(v));
+          else
+            return _mm512_set1_epi64(static_cast<long long>(v));
+        }
+
+        // one bit per U lane set when a == b
+        template<typename U>
+        static std::uint64_t eq(reg a, reg b) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm512_cmpeq_epi8_mask(a, b);
+          else if constexpr(sizeof(U) == 2)
+            return _mm512_cmpeq_epi16_mask(a, b);
+          else if constexpr(sizeof(U) == 4)
+            return _mm512_cmpeq_epi32_mask(a, b);
+          else
+            return _mm512_cmpeq_epi64_mask(a, b);
+        }
+
+        // lanes of a that are equal to b are replaced with c
+        template<typename U>
+        static reg replace_eq(reg a, reg b, reg c) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm512_mask_mov_epi8(a, _mm512_cmpeq_epi8_mask(a, b), c);
+          else if constexpr(sizeof(U) == 2)
+            return _mm512_mask_mov_epi16(a, _mm512_cmpeq_epi16_mask(a, b), c);
+          else if constexpr(sizeof(U) == 4)
+            return _mm512_mask_mov_epi32(a, _mm512_cmpeq_epi32_mask(a, b), c);
+          else
+            return _mm512_mask_mov_epi64(a, _mm512_cmpeq_epi64_mask(a, b), c);
+        }
+      };
+
+#elif defined(OPT_SIMD_AVX2)
+
+      struct isa {
+        using reg = __m256i;
+        static constexpr std::size_t bytes = 32;
+
+        static reg load(const void* ptr) noexcept { return _mm256_loadu_si256(static_cast<const __m256i*>(ptr)); }
+        static void store(void* ptr, reg v) noexcept { _mm256_storeu_si256(static_cast<__m256i*>(ptr), v); }
+
+        template<typename U>
+        static reg broadcast(U v) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm256_set1_epi8(static_cast<char>(v));
+          else if constexpr(sizeof(U) == 2)
+            return _mm256_set1_epi16(static_cast<short>(v));
+          else if constexpr(sizeof(U) == 4)
+            return _mm256_set1_epi32(static_cast<int>(v));
+          else
+            return _mm256_set1_epi64x(static_cast<long long>(v));
+        }
+
+        template<typename U>
+        static reg cmpeq(reg a, reg b) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm256_cmpeq_epi8(a, b);
+          else if constexpr(sizeof(U) == 2)
+            return _mm256_cmpeq_epi16(a, b);
+          else if constexpr(sizeof(U) == 4)
+            return _mm256_cmpeq_epi32(a, b);
+          else
+            return _mm256_cmpeq_epi64(a, b);
+        }
+
+        // one bit per U lane set when a == b
+        template<typename U>
+        static std::uint64_t eq(reg a, reg b) noexcept
+        {
+          const reg m = cmpeq<U>(a, b);
+          if constexpr(sizeof(U) == 1)
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+          else if constexpr(sizeof(U) == 2)
+            return compress_16bit_lanes(static_cast<std::uint32_t>(_mm256_movemask_epi8(m)));
+          else if constexpr(sizeof(U) == 4)
+            return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+          else
+            return static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+        }
+
+        // lanes of a that are equal to b are replaced with c
+        template<typename U>
+        static reg replace_eq(reg a, reg b, reg c) noexcept
+        {
+          return _mm256_blendv_epi8(a, c, cmpeq<U>(a, b));
+        }
+      };
+
+#elif defined(OPT_SIMD_SSE2)
+
+      struct isa {
+        using reg = __m128i;
+        static constexpr std::size_t bytes = 16;
+
+        static reg load(const void* ptr) noexcept { return _mm_loadu_si128(static_cast<const __m128i*>(ptr)); }
+        static void store(void* ptr, reg v) noexcept { _mm_storeu_si128(static_cast<__m128i*>(ptr), v); }
+
+        template<typename U>
+        static reg broadcast(U v) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm_set1_epi8(static_cast<char>(v));
+          else if constexpr(sizeof(U) == 2)
+            return _mm_set1_epi16(static_cast<short>(v));
+          else if constexpr(sizeof(U) == 4)
+            return _mm_set1_epi32(static_cast<int>(v));
+          else
+            return _mm_set1_epi64x(static_cast<long long>(v));
+        }
+
+        template<typename U>
+        static reg cmpeq(reg a, reg b) noexcept
+        {
+          if constexpr(sizeof(U) == 1)
+            return _mm_cmpeq_epi8(a, b);
+          else if constexpr(sizeof(U) == 2)
+            return _mm_cmpeq_epi16(a, b);
+          else if constexpr(sizeof(U) == 4)
+            return _mm_cmpeq_epi32(a, b);
+          else {
+            // no 64-bit compare in SSE2 - both 32-bit halves have to match
+            const reg m = _mm_cmpeq_epi32(a, b);
+            return _mm_and_si128(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+          }
+        }
+
+        // one bit per U lane set when a == b
+        template<typename U>
+        static std::uint64_t eq(reg a, reg b) noexcept
+        {
+          const reg m = cmpeq<U>(a, b);
+          if constexpr(sizeof(U) == 1)
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+          else if constexpr(sizeof(U) == 2)
+            return compress_16bit_lanes(static_cast<std::uint32_t>(_mm_movemask_epi8(m)));
+          else if constexpr(sizeof(U) == 4)
+            return static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+          else
+            return static_cast<std::uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(m)));
+        }
+
+        // lanes of a that are equal to b are replaced with c
+        template<typename U>
+        static reg replace_eq(reg a, reg b, reg c) noexcept
+        {
+          const reg m = cmpeq<U>(a, b);
+          return _mm_or_si128(_mm_and_si128(m, c), _mm_andnot_si128(m, a));
+        }
+      };
+
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+      // kernels working on raw bit patterns of `size` contiguous U-sized objects
+      //
+      // vector loops stop at `size - size % lanes` and not at `i + lanes <= size`; the latter may wrap around in the
+      // optimizer's view, so it cannot bound the scalar tail loops (GCC reports undefined behavior after 2^62
+      // iterations of them when the size of a heap allocation is known at compile time)
+
+      // number of objects equal to v
+      template<typename U>
+      inline std::size_t count_eq(const void* data, std::size_t size, U v) noexcept
+      {
+        auto ptr = static_cast<const std::byte*>(data);
+        std::size_t i = 0, count = 0;
+#ifdef OPT_SIMD
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        const auto pattern = isa::broadcast(v);
+        for(; i < size - size % lanes; i += lanes)
+          count += static_cast<std::size_t>(std::popcount(isa::eq<U>(isa::load(ptr + i * sizeof(U)), pattern)));
+#endif
+        for(; i < size; ++i)
+          count += load<U>(ptr + i * sizeof(U)) == v;
+        return count;
+      }
+
+      // index of the first object equal to v or size if not found
+      template<typename U>
+      inline std::size_t find_eq(const void* data, std::size_t size, U v) noexcept
+      {
+        auto ptr = static_cast<const std::byte*>(data);
+        std::size_t i = 0;
+#ifdef OPT_SIMD
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        const auto pattern = isa::broadcast(v);
+        for(; i < size - size % lanes; i += lanes)
+          if(const auto m = isa::eq<U>(isa::load(ptr + i * sizeof(U)), pattern); m != 0)
+            return i + static_cast<std::size_t>(std::countr_zero(m));
+#endif
+        for(; i < size; ++i)
+          if(load<U>(ptr + i * sizeof(U)) == v) return i;
+        return size;
+      }
+
+      // index of the first object not equal to v or size if not found
+      template<typename U>
+      inline std::size_t find_ne(const void* data, std::size_t size, U v) noexcept
+      {
+        auto ptr = static_cast<const std::byte*>(data);
+        std::size_t i = 0;
+#ifdef OPT_SIMD
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        constexpr std::uint64_t lanes_mask = lanes == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << lanes) - 1;
+        const auto pattern = isa::broadcast(v);
+        for(; i < size - size % lanes; i += lanes)
+          if(const auto m = ~isa::eq<U>(isa::load(ptr + i * sizeof(U)), pattern) & lanes_mask; m != 0)
+            return i + static_cast<std::size_t>(std::countr_zero(m));
+#endif
+        for(; i < size; ++i)
+          if(load<U>(ptr + i * sizeof(U)) != v) return i;
+        return size;
+      }
+
+      // copies objects from `in` to `out` replacing the ones equal to v with `with` (in and out may be the same)
+      template<typename U>
+      inline void replace_eq(const void* in, void* out, std::size_t size, U v, U with) noexcept
+      {
+        auto src = static_cast<const std::byte*>(in);
+        auto dst = static_cast<std::byte*>(out);
+        std::size_t i = 0;
+#ifdef OPT_SIMD
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        const auto pattern = isa::broadcast(v);
+        const auto replacement = isa::broadcast(with);
+        for(; i < size - size % lanes; i += lanes)
+          isa::store(dst + i * sizeof(U), isa::replace_eq<U>(isa::load(src + i * sizeof(U)), pattern, replacement));
+#endif
+        for(; i < size; ++i) {
+          const auto value = load<U>(src + i * sizeof(U));
+          store<U>(dst + i * sizeof(U), value == v ? with : value);
+        }
+      }
+
+      // number of objects compared at once by eq_either_mask()
+      template<typename U>
+#ifdef OPT_SIMD
+      inline constexpr std::size_t mask_lanes = isa::bytes / sizeof(U);
+#else
+      inline constexpr std::size_t mask_lanes = 1;
+#endif
+
+      // mask with bit i set if i-th of mask_lanes<U> objects is equal to a or to b (i.e. a probe of an open-addressing
+      // table for a key or an empty slot)
+      template<typename U>
+      inline std::uint64_t eq_either_mask(const void* data, U a, U b) noexcept
+      {
+#ifdef OPT_SIMD
+        const auto values = isa::load(data);
+        return isa::eq<U>(values, isa::broadcast(a)) | isa::eq<U>(values, isa::broadcast(b));
+#else
+        const U value = load<U>(data);
+        return value == a || value == b;
+#endif
+      }
+
+      // 64-bit mask with bit i set if i-th of 64 objects is equal to v
+      template<typename U>
+      inline std::uint64_t eq_mask64(const void* data, U v) noexcept
+      {
+        auto ptr = static_cast<const std::byte*>(data);
+        std::uint64_t mask = 0;
+#ifdef OPT_SIMD
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        const auto pattern = isa::broadcast(v);
+        for(std::size_t i = 0; i < 64; i += lanes)
+          mask |= isa::eq<U>(isa::load(ptr + i * sizeof(U)), pattern) << i;
+#else
+        for(std::size_t i = 0; i < 64; ++i)
+          mask |= std::uint64_t{load<U>(ptr + i * sizeof(U)) == v} << i;
+#endif
+        return mask;
+      }
+
+      // copies 64 objects from `in` to `out` replacing the ones with a corresponding bit of mask not set with v
+      template<typename U>
+      inline void select_mask64(const void* in, void* out, std::uint64_t mask, U v) noexcept
+      {
+        auto src = static_cast<const std::byte*>(in);
+        auto dst = static_cast<std::byte*>(out);
+#if defined(OPT_SIMD_AVX512)
+        constexpr std::size_t lanes = isa::bytes / sizeof(U);
+        const auto pattern = isa::broadcast(v);
+        for(std::size_t i = 0; i < 64; i += lanes) {
+          const auto values = isa::load(src + i * sizeof(U));
+          const auto m = mask >> i;
+          if constexpr(sizeof(U) == 1)
+            isa::store(dst + i * sizeof(U), _mm512_mask_mov_epi8(pattern, static_cast<__mmask64>(m), values));
+          else if constexpr(sizeof(U) == 2)
+            isa::store(dst + i * sizeof(U), _mm512_mask_mov_epi16(pattern, static_cast<__mmask32>(m), values));
+          else if constexpr(sizeof(U) == 4)
+            isa::store(dst + i * sizeof(U), _mm512_mask_mov_epi32(pattern, static_cast<__mmask16>(m), values));
+          else
+            isa::store(dst + i * sizeof(U), _mm512_mask_mov_epi64(pattern, static_cast<__mmask8>(m), values));
+        }
+#else
+        for(std::size_t i = 0; i < 64; ++i)
+          store<U>(dst + i * sizeof(U), (mask >> i) & 1 ? load<U>(src + i * sizeof(U)) : v);
+#endif
+      }
+
+      // little-endian access to 64-bit words of bitmaps
+      inline std::uint64_t load_le64(const void* ptr) noexcept
+      {
+        if constexpr(std::endian::native == std::endian::little) {
+          return load<std::uint64_t>(ptr);
+        }
+        else {
+          auto bytes = static_cast<const std::uint8_t*>(ptr);
+          std::uint64_t v = 0;
+          for(int i = 0; i < 8; ++i)
+            v |= std::uint64_t{bytes[i]} << (8 * i);
+          return v;
+        }
+      }
+
+      inline void store_le64(void* ptr, std::uint64_t v) noexcept
+      {
+        if constexpr(std::endian::native == std::endian::little) {
+          store(ptr, v);
+        }
+        else {
+          auto bytes = static_cast<std::uint8_t*>(ptr);
+          for(int i = 0; i < 8; ++i)
+            bytes[i] = static_cast<std::uint8_t>(v >> (8 * i));
+        }
+      }
+
+      // sets all objects to v
+      template<typename U>
+      inline void fill(void* out, std::size_t size, U v) noexcept
+      {
+        if(size == 0) return;  // out may be null for an empty range, which memset does not accept
+        auto dst = static_cast<std::byte*>(out);
+        if constexpr(sizeof(U) == 1) {
+          std::memset(dst, static_cast<int>(v), size);
+        }
+        else {
+          std::size_t i = 0;
+#ifdef OPT_SIMD
+          constexpr std::size_t lanes = isa::bytes / sizeof(U);
+          const auto pattern = isa::broadcast(v);
+          for(; i < size - size % lanes; i += lanes)
+            isa::store(dst + i * sizeof(U), pattern);
+#endif
+          for(; i < size; ++i)
+            store<U>(dst + i * sizeof(U), v);
+        }
+      }
+
+      // 64-bit mixer with full avalanche (every input bit affects every output bit)
+      inline constexpr std::uint64_t hash_mix_multiplier = 0xD6E8'FEB8'6659'FD93;
+
+      constexpr std::uint64_t hash_mix(std::uint64_t x) noexcept
+      {
+        x ^= x >> 32;
+        x *= hash_mix_multiplier;
+        x ^= x >> 32;
+        x *= hash_mix_multiplier;
+        x ^= x >> 32;
+        return x;
+      }
+
+      // out[i] = hash_mix(in[i])
+      inline void hash_mix(const std::uint64_t* in, std::uint64_t* out, std::size_t size) noexcept
+      {
+        std::size_t i = 0;
+#if defined(OPT_SIMD_AVX512) && defined(__AVX512DQ__)
+        const auto c = _mm512_set1_epi64(static_cast<long long>(hash_mix_multiplier));
+        // zero-masked shift avoids GCC false positive -Wmaybe-uninitialized for _mm512_srli_epi64()
+        const auto xor_shift = [](__m512i x) { return _mm512_xor_si512(x, _mm512_maskz_srli_epi64(0xFF, x, 32)); };
+        for(; i < size - size % 8; i += 8) {
+          auto x = _mm512_loadu_si512(in + i);
+          x = xor_shift(x);
+          x = _mm512_mullo_epi64(x, c);
+          x = xor_shift(x);
+          x = _mm512_mullo_epi64(x, c);
+          x = xor_shift(x);
+          _mm512_storeu_si512(out + i, x);
+        }
+#elif defined(OPT_SIMD_AVX2) || defined(OPT_SIMD_AVX512)
+        // no 64-bit multiplication - x * c (mod 2^64) is composed from 32x32->64 bit ones
+        const auto c_lo = _mm256_set1_epi64x(static_cast<long long>(hash_mix_multiplier & 0xFFFF'FFFF));
+        const auto c_hi = _mm256_set1_epi64x(static_cast<long long>(hash_mix_multiplier >> 32));
+        const auto mul = [&](__m256i x) {
+          const auto lo = _mm256_mul_epu32(x, c_lo);
+          const auto cross = _mm256_add_epi64(_mm256_mul_epu32(x, c_hi), _mm256_mul_epu32(_mm256_srli_epi64(x, 32), c_lo));
+          return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+        };
+        for(; i < size - size % 4; i += 4) {
+          auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+          x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+          x = mul(x);
+          x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+          x = mul(x);
+          x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+        }
+#endif
+        for(; i < size; ++i)
+          out[i] = hash_mix(in[i]);
+      }
+
+    }  // namespace simd
+  }    // namespace detail
+}
@@ -0,0 +1,186 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt_algorithms.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace mp {
+
+  // Run-length encoded stream of opt<T, Policy> elements
+  //
+  // The stream is a sequence of runs. Every run starts with a LEB128 varint header `length << 1 | has_values`.
+  // A run of values is followed by `length` raw storage_type objects (in the byte order of the writer) and a run of
+  // nulls has no payload, so mostly empty columns shrink to a few bytes per run.
+
+  namespace detail {
+
+    inline void put_run_header(std::vector<std::byte>& out, std::uint64_t length, bool has_values)
+    {
+      std::uint64_t v = length << 1 | static_cast<std::uint64_t>(has_values);
+      while(v >= 0x80) {
+        out.push_back(static_cast<std::byte>(v | 0x80));
+        v >>= 7;
+      }
+      out.push_back(static_cast<std::byte>(v));
+    }
+
+  }  // namespace detail
+
+  // Encodes chunks of elements as they arrive; runs of nulls spanning many chunks are written as one run.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class opt_stream_writer {
+  public:
+    using value_type = opt<T, Policy>;
+
+    static_assert(std::is_trivially_copyable_v<value_type>,
+                  "trivially copyable opt<T, Policy> required, consider serializing elements one by one");
+
+    // appends encoded `chunk` to `out`; a run of nulls at the end of the chunk is kept until the next call or flush()
+    void write(std::span<const value_type> chunk, std::vector<std::byte>& out)
+    {
+      std::size_t i = 0;
+      while(i < chunk.size()) {
+        const auto values = find_first_null(chunk.subspan(i));
+        if(values > 0) {
+          flush(out);
+          detail::put_run_header(out, values, true);
+          const auto bytes = std::as_bytes(chunk.subspan(i, values));
+          out.insert(out.end(), bytes.begin(), bytes.end());
+          i += values;
+        }
+        const auto nulls = find_first_value(chunk.subspan(i));
+        pending_nulls_ += nulls;
+        i += nulls;
+      }
+    }
+
+    // writes the pending run of nulls; has to be called at the end of the stream
+    void flush(std::vector<std::byte>& out)
+    {
+      if(pending_nulls_ > 0) {
+        detail::put_run_header(out, pending_nulls_, false);
+        pending_nulls_ = 0;
+      }
+    }
+
+  private:
+    std::uint64_t pending_nulls_ = 0;
+  };
+
+  // Decodes the stream produced by opt_stream_writer straight into the caller-provided buffers. Input and output may
+  // be split at any byte or element - runs, headers and elements split between calls are continued in the next one.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class opt_stream_reader {
+  public:
+    using value_type = opt<T, Policy>;
+
+    static_assert(std::is_trivially_copyable_v<value_type>,
+                  "trivially copyable opt<T, Policy> required, consider serializing elements one by one");
+
+    // decodes elements from `in` to `out` until any of them is exhausted, removes consumed bytes from the front of
+    // `in` and returns the number of elements written; throws std::runtime_error on a malformed run header
+    std::size_t read(std::span<const std::byte>& in, std::span<value_type> out)
+    {
+      std::size_t n = 0;
+      while(n < out.size()) {
+        if(remaining_ == 0) {
+          if(!read_header(in)) break;
+          continue;
+        }
+        const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, out.size() - n));
+        if(!has_values_) {
+          fill_null(out.subspan(n, count));
+          n += count;
+          remaining_ -= count;
+        }
+        else if(partial_ > 0) {
+          // complete the element split between input chunks
+          const auto k = std::min(sizeof(value_type) - partial_, in.size());
+          std::memcpy(element_.data() + partial_, in.data(), k);
+          in = in.subspan(k);
+          partial_ += k;
+          if(partial_ < sizeof(value_type)) break;
+          std::memcpy(static_cast<void*>(&out[n]), element_.data(), sizeof(value_type));
+          ++n;
+          --remaining_;
+          partial_ = 0;
+        }
+        else {
+          const auto whole = std::min(count, in.size() / sizeof(value_type));
+          std::memcpy(static_cast<void*>(out.data() + n), in.data(), whole * sizeof(value_type));
+          in = in.subspan(whole * sizeof(value_type));
+          n += whole;
+          remaining_ -= whole;
+          if(whole < count) {
+            // less than one element left in the input
+            partial_ = in.size();
+            std::memcpy(element_.data(), in.data(), partial_);
+            in = {};
+            break;
+          }
+        }
+      }
+      return n;
+    }
+
+    // true if all decoded runs were completely read (i.e. the stream may end here)
+    bool at_run_boundary() const noexcept { return remaining_ == 0 && header_shift_ == 0; }
+
+  private:
+    std::uint64_t remaining_ = 0;  // elements left in the current run
+    bool has_values_ = false;
+    std::uint64_t header_ = 0;  // partially read run header
+    unsigned header_shift_ = 0;
+    std::size_t partial_ = 0;  // bytes of element_ received so far
+    std::array<std::byte, sizeof(value_type)> element_;
+
+    bool read_header(std::span<const std::byte>& in)
+    {
+      while(!in.empty()) {
+        const auto b = std::to_integer<std::uint64_t>(in.front());
+        in = in.subspan(1);
+        if(header_shift_ >= 64 || (header_shift_ == 63 && b > 1))
+          throw std::runtime_error("opt_stream_reader: malformed run header");
+        header_ |= (b & 0x7F) << header_shift_;
+        header_shift_ += 7;
+        if((b & 0x80) == 0) {
+          has_values_ = (header_ & 1) != 0;
+          remaining_ = header_ >> 1;
+          header_ = 0;
+          header_shift_ = 0;
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+}
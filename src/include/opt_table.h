@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mp {
+
+  // {key, value} pair of make_opt_table()
+  template<typename Key, typename T>
+  struct opt_table_entry {
+    Key key;
+    T value;
+  };
+
+  // Dense lookup table of N elements where table[key] contains value of the {key, value} entry and all the other
+  // elements are empty. Keys are integral or enumeration values smaller than N.
+  //
+  // When used to initialize a constexpr variable the table is built by the compiler (it lands in read-only data and
+  // costs nothing at startup) and invalid entries (a key out of range, a duplicated key or a null value) are
+  // compilation errors:
+  //
+  //   using opt_policy = mp::opt_null_value_policy<int, -1>;
+  //   constexpr auto retries = mp::make_opt_table<int, opt_policy, 600>({{429, 5}, {500, 1}, {503, 3}});
+  template<typename T, typename Policy, std::size_t N, typename Key = std::size_t, std::size_t M>
+  constexpr std::array<opt<T, Policy>, N> make_opt_table(const opt_table_entry<Key, T> (&entries)[M])
+  {
+    static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>, "integral or enumeration 'Key' is required");
+    std::array<opt<T, Policy>, N> table{};
+    for(const auto& e : entries) {
+      const auto i = static_cast<std::size_t>(e.key);
+      if(i >= N) throw std::out_of_range("make_opt_table: key out of range");
+      if(table[i].has_value()) throw std::invalid_argument("make_opt_table: duplicated key");
+      table[i] = e.value;
+      if(!table[i].has_value()) throw std::invalid_argument("make_opt_table: null value");
+    }
+    return table;
+  }
+
+}  // namespace mp
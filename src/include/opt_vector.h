@@ -0,0 +1,358 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include "opt_algorithms.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mp {
+
+  // Contiguous container of opt<T, Policy> elements.
+  //
+  // If opt<T, Policy> is trivially relocatable (see is_trivially_relocatable) the buffer grows with realloc() and
+  // insert() and erase() shift the elements with memmove() instead of moving them one by one. New empty elements of
+  // trivially copyable opt types with a bitwise null are written as a null bit pattern (see fill_null()), so
+  // resize() does not call per-element constructors.
+  template<typename T, typename Policy = opt_default_policy<T>>
+  class opt_vector {
+  public:
+    using value_type = opt<T, Policy>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    static_assert(alignof(value_type) <= alignof(std::max_align_t),
+                  "over-aligned 'opt<T, Policy>' is not supported, consider using std::vector");
+
+    static constexpr bool relocatable = is_trivially_relocatable_v<value_type>;
+
+  private:
+    static constexpr bool raw_nulls = std::is_trivially_copyable_v<value_type> && detail::is_raw_opt<value_type>;
+
+    value_type* data_ = nullptr;
+    size_type size_ = 0;
+    size_type capacity_ = 0;
+
+    static void* raw(const value_type* p) noexcept { return const_cast<void*>(static_cast<const void*>(p)); }
+
+    size_type next_capacity(size_type required) const
+    {
+      if(required > max_size()) throw std::length_error("opt_vector: too many elements");
+      return std::max(required, capacity_ > max_size() / 2 ? max_size() : 2 * capacity_);
+    }
+
+    void reallocate(size_type new_capacity)
+    {
+      assert(new_capacity > 0 && new_capacity >= size_);
+      value_type* p;
+      if constexpr(relocatable) {
+        p = static_cast<value_type*>(std::realloc(raw(data_), new_capacity * sizeof(value_type)));
+        if(!p) throw std::bad_alloc{};
+      }
+      else {
+        p = static_cast<value_type*>(std::malloc(new_capacity * sizeof(value_type)));
+        if(!p) throw std::bad_alloc{};
+        try {
+          std::uninitialized_move_n(data_, size_, p);
+        }
+        catch(...) {
+          std::free(p);
+          throw;
+        }
+        std::destroy_n(data_, size_);
+        std::free(data_);
+      }
+      data_ = p;
+      capacity_ = new_capacity;
+    }
+
+    static void construct_nulls(value_type* first, size_type count)
+    {
+      if constexpr(raw_nulls)
+        fill_null(std::span<value_type>{first, count});
+      else
+        std::uninitialized_value_construct_n(first, count);
+    }
+
+    // opens a gap of count uninitialized elements at index i
+    void open_gap(size_type i, size_type count) noexcept
+    {
+      static_assert(relocatable);
+      if(i < size_) std::memmove(raw(data_ + i + count), raw(data_ + i), (size_ - i) * sizeof(value_type));
+    }
+    void close_gap(size_type i, size_type count) noexcept
+    {
+      static_assert(relocatable);
+      if(i < size_) std::memmove(raw(data_ + i), raw(data_ + i + count), (size_ - i) * sizeof(value_type));
+    }
+
+  public:
+    opt_vector() = default;
+    explicit opt_vector(size_type count) { resize(count); }
+    opt_vector(size_type count, const value_type& value) { resize(count, value); }
+    explicit opt_vector(std::span<const value_type> values)
+    {
+      reserve(values.size());
+      std::uninitialized_copy_n(values.data(), values.size(), data_);
+      size_ = values.size();
+    }
+    opt_vector(std::initializer_list<value_type> ilist) :
+        opt_vector{std::span<const value_type>{ilist.begin(), ilist.size()}}
+    {
+    }
+
+    opt_vector(const opt_vector& other) : opt_vector{std::span<const value_type>{other.data_, other.size_}} {}
+    opt_vector(opt_vector&& other) noexcept :
+        data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)},
+        capacity_{std::exchange(other.capacity_, 0)}
+    {
+    }
+    opt_vector& operator=(const opt_vector& other)
+    {
+      if(this != &other) opt_vector{other}.swap(*this);
+      return *this;
+    }
+    opt_vector& operator=(opt_vector&& other) noexcept
+    {
+      opt_vector{std::move(other)}.swap(*this);
+      return *this;
+    }
+    ~opt_vector()
+    {
+      std::destroy_n(data_, size_);
+      std::free(data_);
+    }
+
+    // capacity
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    static constexpr size_type max_size() noexcept
+    {
+      return static_cast<size_type>(std::numeric_limits<difference_type>::max()) / sizeof(value_type);
+    }
+
+    void reserve(size_type new_capacity)
+    {
+      if(new_capacity > max_size()) throw std::length_error("opt_vector: too many elements");
+      if(new_capacity > capacity_) reallocate(new_capacity);
+    }
+    void shrink_to_fit()
+    {
+      if(size_ == 0) {
+        std::free(std::exchange(data_, nullptr));
+        capacity_ = 0;
+      }
+      else if(size_ < capacity_) {
+        reallocate(size_);
+      }
+    }
+
+    // element access
+    reference operator[](size_type i) noexcept
+    {
+      assert(i < size_);
+      return data_[i];
+    }
+    const_reference operator[](size_type i) const noexcept
+    {
+      assert(i < size_);
+      return data_[i];
+    }
+    reference front() noexcept { return (*this)[0]; }
+    const_reference front() const noexcept { return (*this)[0]; }
+    reference back() noexcept { return (*this)[size_ - 1]; }
+    const_reference back() const noexcept { return (*this)[size_ - 1]; }
+    value_type* data() noexcept { return data_; }
+    const value_type* data() const noexcept { return data_; }
+
+    // iterators
+    iterator begin() noexcept { return data_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator cbegin() const noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    const_iterator cend() const noexcept { return data_ + size_; }
+
+    // modifiers
+    void clear() noexcept
+    {
+      std::destroy_n(data_, size_);
+      size_ = 0;
+    }
+
+    // new elements are empty
+    void resize(size_type count)
+    {
+      if(count <= size_) {
+        std::destroy_n(data_ + count, size_ - count);
+      }
+      else {
+        const auto old_size = size_;
+        if(count > capacity_) reallocate(next_capacity(count));
+        construct_nulls(data_ + old_size, count - old_size);
+      }
+      size_ = count;
+    }
+
+    void resize(size_type count, const value_type& value)
+    {
+      if(count <= size_) {
+        std::destroy_n(data_ + count, size_ - count);
+      }
+      else {
+        const value_type v = value;  // value may be an element of this vector
+        if(count > capacity_) reallocate(next_capacity(count));
+        std::uninitialized_fill_n(data_ + size_, count - size_, v);
+      }
+      size_ = count;
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+      if(size_ == capacity_) {
+        value_type v(std::forward<Args>(args)...);  // args may refer to an element of this vector
+        reallocate(next_capacity(size_ + 1));
+        ::new(raw(data_ + size_)) value_type(std::move(v));
+      }
+      else {
+        ::new(raw(data_ + size_)) value_type(std::forward<Args>(args)...);
+      }
+      return data_[size_++];
+    }
+    void push_back(const value_type& value) { emplace_back(value); }
+    void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() noexcept
+    {
+      assert(!empty());
+      std::destroy_at(data_ + --size_);
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+      const auto i = static_cast<size_type>(pos - data_);
+      assert(i <= size_);
+      if constexpr(relocatable) {
+        value_type v(std::forward<Args>(args)...);
+        if(size_ == capacity_) reallocate(next_capacity(size_ + 1));
+        open_gap(i, 1);
+        try {
+          ::new(raw(data_ + i)) value_type(std::move(v));
+        }
+        catch(...) {
+          close_gap(i, 1);
+          throw;
+        }
+        ++size_;
+      }
+      else {
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(data_ + i, data_ + size_ - 1, data_ + size_);
+      }
+      return data_ + i;
+    }
+    iterator insert(const_iterator pos, const value_type& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, value_type&& value) { return emplace(pos, std::move(value)); }
+
+    iterator insert(const_iterator pos, size_type count, const value_type& value)
+    {
+      const auto i = static_cast<size_type>(pos - data_);
+      assert(i <= size_);
+      if(count == 0) return data_ + i;
+      if constexpr(relocatable) {
+        const value_type v = value;  // value may be an element of this vector
+        if(size_ + count > capacity_) reallocate(next_capacity(size_ + count));
+        open_gap(i, count);
+        try {
+          std::uninitialized_fill_n(data_ + i, count, v);
+        }
+        catch(...) {
+          close_gap(i, count);
+          throw;
+        }
+        size_ += count;
+      }
+      else {
+        const auto old_size = size_;
+        resize(size_ + count, value);
+        std::rotate(data_ + i, data_ + old_size, data_ + size_);
+      }
+      return data_ + i;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+      const auto i = static_cast<size_type>(first - data_);
+      const auto count = static_cast<size_type>(last - first);
+      assert(i + count <= size_);
+      if constexpr(relocatable) {
+        std::destroy_n(data_ + i, count);
+        size_ -= count;
+        close_gap(i, count);
+      }
+      else {
+        std::move(data_ + i + count, data_ + size_, data_ + i);
+        std::destroy_n(data_ + size_ - count, count);
+        size_ -= count;
+      }
+      return data_ + i;
+    }
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    void swap(opt_vector& other) noexcept
+    {
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(capacity_, other.capacity_);
+    }
+    friend void swap(opt_vector& lhs, opt_vector& rhs) noexcept { lhs.swap(rhs); }
+
+    friend bool operator==(const opt_vector& lhs, const opt_vector& rhs)
+    {
+      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+  };
+
+}  // namespace mp
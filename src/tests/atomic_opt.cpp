@@ -0,0 +1,171 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "atomic_opt.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using atomic_opt_long = atomic_opt<long, opt_null_value_policy<long, -1>>;
+
+  // every NaN is empty, so the emptiness is not bitwise
+  struct any_nan_policy {
+    static double null_value() noexcept { return numeric_limits<double>::quiet_NaN(); }
+    static bool has_value(double value) noexcept { return value == value; }
+  };
+
+}
+
+TEST(atomicOpt, layout)
+{
+  static_assert(sizeof(atomic_opt_long) == sizeof(long));
+  static_assert(sizeof(atomic_opt<weekday>) == sizeof(weekday));
+  static_assert(atomic_opt_long::is_always_lock_free);
+  static_assert(atomic_opt<double, opt_nan_policy<double>>::is_always_lock_free);
+  atomic_opt_long a;
+  EXPECT_TRUE(a.is_lock_free());
+}
+
+TEST(atomicOpt, loadStore)
+{
+  atomic_opt_long a;
+  EXPECT_FALSE(a.load().has_value());
+  a.store(opt_long{3});
+  EXPECT_EQ(3, *a.load());
+  a.reset();
+  EXPECT_FALSE(a.load().has_value());
+
+  atomic_opt_long b{opt_long{5}};
+  EXPECT_EQ(5, *b.load(memory_order_acquire));
+}
+
+TEST(atomicOpt, exchangeTake)
+{
+  atomic_opt_long a{opt_long{1}};
+  EXPECT_EQ(1, *a.exchange(opt_long{2}));
+  EXPECT_EQ(2, *a.take());
+  EXPECT_FALSE(a.load().has_value());
+  EXPECT_FALSE(a.take().has_value());
+}
+
+TEST(atomicOpt, compareExchange)
+{
+  atomic_opt_long a;
+  opt_long expected{1};
+  EXPECT_FALSE(a.compare_exchange_strong(expected, opt_long{2}));
+  EXPECT_FALSE(expected.has_value());
+  EXPECT_TRUE(a.compare_exchange_strong(expected, opt_long{2}));
+  EXPECT_EQ(2, *a.load());
+
+  EXPECT_FALSE(a.try_store(opt_long{3}));
+  EXPECT_EQ(2, *a.load());
+  a.reset();
+  EXPECT_TRUE(a.try_store(opt_long{3}));
+  EXPECT_EQ(3, *a.load());
+
+  expected = 3;
+  while(!a.compare_exchange_weak(expected, opt_long{4}, memory_order_acq_rel, memory_order_acquire)) {
+  }
+  EXPECT_EQ(4, *a.load());
+}
+
+TEST(atomicOpt, tryStoreNotBitwiseNull)
+{
+  using opt_double = opt<double, any_nan_policy>;
+  static_assert(!opt_policy_traits<double, any_nan_policy>::bitwise_null);
+  // an empty opt with other bits than null_value()
+  atomic_opt<double, any_nan_policy> a{bit_cast<opt_double>(-numeric_limits<double>::quiet_NaN())};
+  EXPECT_FALSE(a.load().has_value());
+  EXPECT_TRUE(a.try_store(opt_double{1.0}));
+  EXPECT_EQ(1.0, *a.load());
+  EXPECT_FALSE(a.try_store(opt_double{2.0}));
+  EXPECT_EQ(1.0, *a.load());
+}
+
+TEST(atomicOpt, waitValue)
+{
+  atomic_opt_long a;
+  thread producer{[&] {
+    a.store(opt_long{42});
+    a.notify_all();
+  }};
+  EXPECT_EQ(42, *a.wait_value());
+  producer.join();
+  EXPECT_EQ(42, *a.wait_take());
+  EXPECT_FALSE(a.load().has_value());
+}
+
+TEST(atomicOpt, handOff)
+{
+  // every value published by producers is taken by exactly one consumer
+  constexpr long count = 10000;
+  constexpr int producers = 2, consumers = 2;
+  atomic_opt_long slot;
+  vector<vector<long>> taken(consumers);
+  vector<thread> threads;
+  for(int p = 0; p < producers; ++p)
+    threads.emplace_back([&, p] {
+      for(long i = p; i < count; i += producers) {
+        while(!slot.try_store(opt_long{i}))
+          this_thread::yield();
+        slot.notify_one();
+      }
+    });
+  for(int c = 0; c < consumers; ++c)
+    threads.emplace_back([&, c] {
+      for(;;) {
+        const auto v = slot.wait_take();
+        if(*v == count) {
+          // stop marker - pass it to the other consumers
+          slot.store(v);
+          slot.notify_all();
+          break;
+        }
+        taken[static_cast<size_t>(c)].push_back(*v);
+      }
+    });
+  for(int p = 0; p < producers; ++p)
+    threads[static_cast<size_t>(p)].join();
+  while(!slot.try_store(opt_long{count}))
+    this_thread::yield();
+  slot.notify_all();
+  for(int c = 0; c < consumers; ++c)
+    threads[static_cast<size_t>(producers + c)].join();
+
+  vector<long> all;
+  for(const auto& t : taken)
+    all.insert(all.end(), t.begin(), t.end());
+  sort(all.begin(), all.end());
+  ASSERT_EQ(static_cast<size_t>(count), all.size());
+  for(long i = 0; i < count; ++i)
+    EXPECT_EQ(i, all[static_cast<size_t>(i)]);
+}
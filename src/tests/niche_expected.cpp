@@ -0,0 +1,148 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "niche_expected.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <system_error>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  enum class reason : uint8_t { holiday, strike, unknown };
+
+  using expected_weekday = niche_expected<weekday, reason>;
+  using expected_double = niche_expected<double, errc, opt_nan_policy<double>>;
+
+  template<opt_checking Mode>
+  struct checking_policy : opt_niche_range_policy<int, -128, -1> {
+    static constexpr opt_checking checking = Mode;
+  };
+
+  template<opt_checking Mode>
+  using expected_int = niche_expected<int, reason, checking_policy<Mode>>;
+
+}
+
+TEST(nicheExpected, size)
+{
+  static_assert(sizeof(expected_weekday) == sizeof(weekday));
+  static_assert(sizeof(expected_double) == sizeof(double));
+  static_assert(sizeof(niche_expected<int, reason, opt_niche_range_policy<int, -128, -1>>) == sizeof(int));
+}
+
+TEST(nicheExpected, value)
+{
+  expected_weekday e{weekday{3}};
+  EXPECT_TRUE(e.has_value());
+  EXPECT_TRUE(e);
+  EXPECT_EQ(3, e->get());
+  EXPECT_EQ(3, (*e).get());
+  EXPECT_EQ(3, e.value().get());
+  EXPECT_TRUE(e == weekday{3});
+  EXPECT_FALSE(e == mp::unexpected{reason::holiday});
+
+  e = weekday{5};
+  EXPECT_EQ(5, e->get());
+}
+
+TEST(nicheExpected, error)
+{
+  expected_weekday e{mp::unexpected{reason::strike}};
+  EXPECT_FALSE(e.has_value());
+  EXPECT_FALSE(e);
+  EXPECT_EQ(reason::strike, e.error());
+  EXPECT_TRUE(e == mp::unexpected{reason::strike});
+  EXPECT_FALSE(e == weekday{1});
+  EXPECT_EQ(2, e.value_or(weekday{2}).get());
+
+  // errors are stored in the unused values of weekday (7..127)
+  int8_t raw;
+  memcpy(&raw, &e, sizeof(raw));
+  EXPECT_EQ(8, raw);
+
+  try {
+    e.value();
+    FAIL() << "exception expected";
+  }
+  catch(const bad_expected_access<reason>& ex) {
+    EXPECT_EQ(reason::strike, ex.error());
+  }
+
+  e = mp::unexpected{reason::unknown};
+  EXPECT_EQ(reason::unknown, e.error());
+  e = weekday{0};
+  EXPECT_TRUE(e.has_value());
+  EXPECT_EQ(0, e->get());
+}
+
+TEST(nicheExpected, nanPayload)
+{
+  expected_double e;
+  EXPECT_TRUE(e.has_value());
+  EXPECT_EQ(0.0, *e);
+
+  e = mp::unexpected{errc::result_out_of_range};
+  EXPECT_FALSE(e.has_value());
+  EXPECT_EQ(errc::result_out_of_range, e.error());
+
+  // other NaNs are still values
+  e = numeric_limits<double>::quiet_NaN();
+  EXPECT_TRUE(e.has_value());
+  EXPECT_TRUE(isnan(*e));
+
+  constexpr expected_double c{mp::unexpected{errc::invalid_argument}};
+  static_assert(!c.has_value());
+  static_assert(c.error() == errc::invalid_argument);
+  static_assert(expected_double{1.5}.value() == 1.5);
+}
+
+TEST(nicheExpected, compare)
+{
+  const expected_weekday a{weekday{1}}, b{weekday{1}}, c{weekday{2}};
+  const expected_weekday ea{mp::unexpected{reason::holiday}}, eb{mp::unexpected{reason::holiday}}, ec{mp::unexpected{reason::strike}};
+  EXPECT_TRUE(a == b);
+  EXPECT_TRUE(a != c);
+  EXPECT_TRUE(a != ea);
+  EXPECT_TRUE(ea == eb);
+  EXPECT_TRUE(ea != ec);
+}
+
+TEST(nicheExpected, checking)
+{
+  static_assert(*expected_int<opt_checking::trap>{1} == 1);
+  static_assert(expected_int<opt_checking::exception>{2}.value() == 2);
+
+  const expected_int<opt_checking::exception> e{mp::unexpected{reason::strike}};
+  EXPECT_THROW(*e, bad_expected_access<reason>);
+  EXPECT_THROW(e.value(), bad_expected_access<reason>);
+}
+
+TEST(nicheExpectedDeathTest, trap)
+{
+  const expected_int<opt_checking::trap> e{mp::unexpected{reason::holiday}};
+  EXPECT_DEATH(*e, "");
+  EXPECT_DEATH(e.value(), "");
+}
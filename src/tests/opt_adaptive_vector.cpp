@@ -0,0 +1,159 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_adaptive_vector.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using opt_long = opt<long, policy>;
+  using vector_type = opt_adaptive_vector<long, policy>;
+  using kind = vector_type::block_kind;
+
+  constexpr size_t block = vector_type::block_size;
+
+}
+
+TEST(optAdaptiveVector, thresholds)
+{
+  static_assert(vector_type::to_dense_threshold == block * sizeof(long) / (sizeof(long) + 2) / 2);
+  static_assert(vector_type::to_sparse_threshold < vector_type::to_dense_threshold);
+}
+
+TEST(optAdaptiveVector, emptyBlocks)
+{
+  vector_type v(3 * block + 5);
+  EXPECT_EQ(3 * block + 5, v.size());
+  EXPECT_EQ(0u, v.count_values());
+  EXPECT_EQ(0u, v.memory_usage());
+  EXPECT_EQ(kind::empty, v.kind_of_block(3));
+  EXPECT_FALSE(v[3 * block + 4].has_value());
+}
+
+TEST(optAdaptiveVector, setGet)
+{
+  vector_type v(2 * block);
+  v.set(5, opt_long{50});
+  v.set(block + 1, opt_long{7});
+  v.set(3, opt_long{30});
+  EXPECT_EQ(kind::sparse, v.kind_of_block(0));
+  EXPECT_EQ(50, v[5]);
+  EXPECT_EQ(30, v[3]);
+  EXPECT_FALSE(v[4].has_value());
+  EXPECT_EQ(7, v[block + 1]);
+  EXPECT_EQ(3u, v.count_values());
+
+  v.set(5, opt_long{51});
+  EXPECT_EQ(51, v[5]);
+  EXPECT_EQ(3u, v.count_values());
+
+  v.reset(5);
+  v.reset(4);
+  EXPECT_FALSE(v[5].has_value());
+  EXPECT_EQ(2u, v.count_values());
+  v.reset(3);
+  EXPECT_EQ(kind::empty, v.kind_of_block(0));
+}
+
+TEST(optAdaptiveVector, switchesRepresentation)
+{
+  vector_type v(block);
+  for(size_t i = 0; i <= vector_type::to_dense_threshold; ++i) {
+    if(i > 0) {
+      EXPECT_EQ(kind::sparse, v.kind_of_block(0));
+    }
+    v.set(i * 2, opt_long{static_cast<long>(i)});
+  }
+  EXPECT_EQ(kind::dense, v.kind_of_block(0));
+  const auto count = v.count_values();
+
+  // hysteresis
+  size_t i = 0;
+  for(; v.count_values() >= vector_type::to_sparse_threshold; ++i) {
+    EXPECT_EQ(kind::dense, v.kind_of_block(0));
+    v.reset(i * 2);
+  }
+  EXPECT_EQ(kind::sparse, v.kind_of_block(0));
+  EXPECT_EQ(count - i, v.count_values());
+  for(size_t j = 0; j < block; ++j)
+    EXPECT_EQ(j % 2 == 0 && j / 2 >= i && j / 2 <= vector_type::to_dense_threshold, v[j].has_value()) << j;
+}
+
+TEST(optAdaptiveVector, iteratorAndForEach)
+{
+  mt19937 gen{1};
+  for(double density : {0.001, 0.2, 0.9}) {
+    bernoulli_distribution has_value{density};
+    vector<opt_long> expected(3 * block + 100);
+    vector_type v;
+    for(size_t i = 0; i < expected.size(); ++i) {
+      if(i / block != 1 && has_value(gen)) expected[i] = opt_long{static_cast<long>(i)};
+      v.push_back(expected[i]);
+    }
+    EXPECT_EQ(kind::empty, v.kind_of_block(1));
+    EXPECT_TRUE(equal(v.begin(), v.end(), expected.begin(), expected.end())) << density;
+
+    vector<size_t> visited;
+    v.for_each_value([&](size_t i, long value) {
+      EXPECT_EQ(static_cast<long>(i), value);
+      visited.push_back(i);
+    });
+    vector<size_t> expected_visited;
+    for(size_t i = 0; i < expected.size(); ++i)
+      if(expected[i]) expected_visited.push_back(i);
+    EXPECT_EQ(expected_visited, visited) << density;
+  }
+}
+
+TEST(optAdaptiveVector, resize)
+{
+  vector_type v(block + 10);
+  v.set(block + 5, opt_long{1});
+  v.set(block - 1, opt_long{2});
+  v.resize(block + 3);
+  v.resize(block + 10);
+  EXPECT_FALSE(v[block + 5].has_value());
+  EXPECT_EQ(2, v[block - 1]);
+  EXPECT_EQ(1u, v.count_values());
+  v.clear();
+  EXPECT_TRUE(v.empty());
+}
+
+TEST(optAdaptiveVector, memoryUsage)
+{
+  vector_type v(16 * block);
+  for(size_t i = 0; i < v.size(); i += 100) v.set(i, opt_long{1});
+  EXPECT_LT(v.memory_usage() * 5, v.size() * sizeof(opt_long));
+
+  // sparse storage is released after conversion
+  vector_type d;
+  for(size_t i = 0; i < block; ++i) d.push_back(opt_long{1});
+  EXPECT_EQ(kind::dense, d.kind_of_block(0));
+  EXPECT_EQ(block * sizeof(opt_long), d.memory_usage());
+}
@@ -0,0 +1,355 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_algorithms.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  template<typename T>
+  struct algo_traits;
+
+  template<>
+  struct algo_traits<opt<long, opt_null_value_policy<long, -1>>> {
+    static long value(size_t i) { return static_cast<long>(i) * 3; }
+  };
+
+  template<>
+  struct algo_traits<opt<int, opt_null_value_policy<int, 0>>> {
+    static int value(size_t i) { return static_cast<int>(i) + 1; }
+  };
+
+  template<>
+  struct algo_traits<opt<uint16_t, opt_null_value_policy<uint16_t, 0xFFFF>>> {
+    static uint16_t value(size_t i) { return static_cast<uint16_t>(i % 1000); }
+  };
+
+  template<>
+  struct algo_traits<opt<int8_t, opt_null_value_policy<int8_t, -128>>> {
+    static int8_t value(size_t i) { return static_cast<int8_t>(i % 100); }
+  };
+
+  template<>
+  struct algo_traits<opt<weekday>> {
+    static weekday value(size_t i) { return weekday{static_cast<weekday::underlying_type>(i % 7)}; }
+  };
+
+  template<>
+  struct algo_traits<opt<double, opt_null_type_policy<double, null_floating<double>>>> {
+    static double value(size_t i) { return static_cast<double>(i) + 0.5; }
+  };
+
+  template<>
+  struct algo_traits<opt<double, opt_nan_policy<double>>> {
+    static double value(size_t i) { return static_cast<double>(i) - 0.5; }
+  };
+
+  template<>
+  struct algo_traits<opt<float, opt_nan_policy<float>>> {
+    static float value(size_t i) { return static_cast<float>(i % 1000) * 0.25f; }
+  };
+
+  template<typename T>
+  class optAlgorithms : public ::testing::Test {
+  public:
+    using opt_type = T;
+    using value_type = typename T::value_type;
+    using traits = algo_traits<T>;
+
+    // every `null_every`-th element (starting from `first_null`) is empty
+    static vector<opt_type> make(size_t size, size_t first_null, size_t null_every)
+    {
+      vector<opt_type> v;
+      v.reserve(size);
+      for(size_t i = 0; i < size; ++i) {
+        if(i >= first_null && (i - first_null) % null_every == 0)
+          v.emplace_back();
+        else
+          v.emplace_back(traits::value(i));
+      }
+      return v;
+    }
+  };
+
+  using algo_types =
+      ::testing::Types<opt<long, opt_null_value_policy<long, -1>>, opt<int, opt_null_value_policy<int, 0>>,
+                       opt<uint16_t, opt_null_value_policy<uint16_t, 0xFFFF>>,
+                       opt<int8_t, opt_null_value_policy<int8_t, -128>>, opt<weekday>,
+                       opt<double, opt_null_type_policy<double, null_floating<double>>>,
+                       opt<double, opt_nan_policy<double>>, opt<float, opt_nan_policy<float>>>;
+  TYPED_TEST_CASE(optAlgorithms, algo_types);
+
+  const size_t sizes[] = {0, 1, 7, 15, 16, 17, 63, 64, 65, 130, 1000};
+}
+
+TEST(optAlgorithms, rawPathSelection)
+{
+  static_assert(detail::is_raw_opt<opt<long, opt_null_value_policy<long, -1>>>);
+  static_assert(detail::is_raw_opt<const opt<int8_t, opt_null_value_policy<int8_t, -128>>>);
+  static_assert(detail::is_raw_value_opt<opt<long, opt_null_value_policy<long, -1>>>);
+  static_assert(!detail::is_raw_opt<opt<weekday>>);
+  static_assert(!detail::is_raw_opt<opt<bool>>);
+  static_assert(!detail::is_raw_opt<opt<double, opt_null_type_policy<double, null_floating<double>>>>);
+  static_assert(detail::is_raw_value_opt<opt<double, opt_nan_policy<double>>>);
+  static_assert(detail::is_raw_value_opt<opt<float, opt_nan_policy<float>>>);
+}
+
+TYPED_TEST(optAlgorithms, countValues)
+{
+  for(auto size : sizes) {
+    for(size_t every : {1, 2, 5, 1000}) {
+      const auto v = this->make(size, 0, every);
+      size_t expected = 0;
+      for(const auto& o : v)
+        expected += o.has_value();
+      EXPECT_EQ(expected, count_values(span{v})) << "size=" << size << " every=" << every;
+      EXPECT_EQ(expected, count_values(span<const typename TestFixture::opt_type>{v}));
+    }
+  }
+}
+
+TYPED_TEST(optAlgorithms, countValuesAllSet)
+{
+  for(auto size : sizes) {
+    const auto v = this->make(size, size, 1);
+    EXPECT_EQ(size, count_values(span{v}));
+  }
+}
+
+TYPED_TEST(optAlgorithms, findFirstNull)
+{
+  for(auto size : sizes) {
+    const auto full = this->make(size, size, 1);
+    EXPECT_EQ(size, find_first_null(span{full}));
+    for(size_t first = 0; first < size; first += 3) {
+      const auto v = this->make(size, first, 7);
+      EXPECT_EQ(first, find_first_null(span{v})) << "size=" << size;
+    }
+  }
+}
+
+TYPED_TEST(optAlgorithms, findFirstValue)
+{
+  for(auto size : sizes) {
+    auto v = this->make(size, 0, 1);
+    EXPECT_EQ(size, find_first_value(span<const typename TestFixture::opt_type>{v}));
+    for(size_t first = size; first-- > 0;) {
+      v[first] = typename TestFixture::opt_type{TestFixture::traits::value(first)};
+      EXPECT_EQ(first, find_first_value(span{v})) << "size=" << size;
+    }
+  }
+}
+
+TYPED_TEST(optAlgorithms, fillNull)
+{
+  for(auto size : sizes) {
+    auto v = this->make(size, size, 1);
+    fill_null(span{v});
+    for(const auto& o : v)
+      EXPECT_FALSE(o.has_value());
+    EXPECT_EQ(0u, count_values(span{v}));
+  }
+}
+
+TYPED_TEST(optAlgorithms, valueOrInto)
+{
+  using val_type = typename TestFixture::value_type;
+  const val_type def = TestFixture::traits::value(5);
+  for(auto size : sizes) {
+    const auto v = this->make(size, 1, 3);
+    vector<val_type> out(size, TestFixture::traits::value(1));
+    value_or_into(span{v}, span{out}, def);
+    for(size_t i = 0; i < size; ++i)
+      EXPECT_TRUE(out[i] == v[i].value_or(def)) << "size=" << size << " i=" << i;
+  }
+}
+
+TYPED_TEST(optAlgorithms, replaceNulls)
+{
+  using val_type = typename TestFixture::value_type;
+  const val_type def = TestFixture::traits::value(5);
+  for(auto size : sizes) {
+    const auto orig = this->make(size, 2, 4);
+    auto v = orig;
+    replace_nulls(span{v}, def);
+    EXPECT_EQ(size, count_values(span{v}));
+    for(size_t i = 0; i < size; ++i)
+      EXPECT_TRUE(*v[i] == orig[i].value_or(def)) << "size=" << size << " i=" << i;
+  }
+}
+
+TYPED_TEST(optAlgorithms, toValidityBitmap)
+{
+  for(auto size : sizes) {
+    const auto v = this->make(size, 1, 3);
+    vector<uint8_t> bitmap((size + 7) / 8, 0xAA);
+    to_validity_bitmap(span{v}, span{bitmap});
+    for(size_t i = 0; i < size; ++i)
+      EXPECT_EQ(v[i].has_value(), ((bitmap[i / 8] >> (i % 8)) & 1) != 0) << "size=" << size << " i=" << i;
+    if(size % 8) {
+      EXPECT_EQ(0, bitmap.back() >> (size % 8)) << "padding bits should be cleared";
+    }
+  }
+}
+
+TYPED_TEST(optAlgorithms, fromValidityBitmap)
+{
+  using val_type = typename TestFixture::value_type;
+  for(auto size : sizes) {
+    vector<val_type> values;
+    vector<uint8_t> bitmap((size + 7) / 8);
+    for(size_t i = 0; i < size; ++i) {
+      values.push_back(TestFixture::traits::value(i));
+      if(i % 3 != 1) bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+    }
+    vector<typename TestFixture::opt_type> out(size, TestFixture::traits::value(2));
+    from_validity_bitmap(span<const val_type>{values}, span{bitmap}, span{out});
+    for(size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(i % 3 != 1, out[i].has_value()) << "size=" << size << " i=" << i;
+      if(out[i]) {
+        EXPECT_TRUE(*out[i] == values[i]);
+      }
+    }
+  }
+}
+
+TYPED_TEST(optAlgorithms, validityBitmapRoundTrip)
+{
+  for(auto size : sizes) {
+    const auto v = this->make(size, 0, 2);
+    vector<uint8_t> bitmap((size + 7) / 8);
+    to_validity_bitmap(span{v}, span{bitmap});
+    vector<typename TestFixture::value_type> values;
+    for(size_t i = 0; i < size; ++i)
+      values.push_back(v[i].value_or(TestFixture::traits::value(0)));
+    vector<typename TestFixture::opt_type> out(size);
+    from_validity_bitmap(span{values}, span<const uint8_t>{bitmap}, span{out});
+    EXPECT_TRUE(v == out) << "size=" << size;
+  }
+}
+
+TYPED_TEST(optAlgorithms, hashMany)
+{
+  if constexpr(detail::is_mixable<typename TestFixture::value_type>::value) {
+    for(auto size : sizes) {
+      const auto v = this->make(size, 1, 3);
+      vector<size_t> hashes(size);
+      hash_many(span<const typename TestFixture::opt_type>{v}, span{hashes});
+      for(size_t i = 0; i < size; ++i) {
+        // the same as for a single element (checks block boundaries and SIMD tails)
+        size_t single;
+        hash_many(span{&v[i], 1}, span{&single, 1});
+        EXPECT_EQ(single, hashes[i]) << "size=" << size << " i=" << i;
+        if(!v[i]) {
+          EXPECT_EQ(detail::opt_null_hash, hashes[i]);
+        }
+        else {
+          EXPECT_EQ(static_cast<size_t>(detail::simd::hash_mix(detail::hash_key(*v[i]))), hashes[i]);
+        }
+      }
+    }
+  }
+}
+
+TEST(optAlgorithms, hashManyKeys)
+{
+  // equal values have equal hashes regardless of their type
+  static_assert(detail::hash_key(-0.0) == detail::hash_key(0.0));
+  static_assert(detail::hash_key(-1) == detail::hash_key(-1L));
+  using opt_float = opt<float, opt_null_type_policy<float, null_floating<float>>>;
+  using opt_double = opt<double, opt_null_type_policy<double, null_floating<double>>>;
+  const vector<opt_float> f{1.5f, -2.0f, nullopt};
+  const vector<opt_double> d{1.5, -2.0, nullopt};
+  vector<size_t> fh(3), dh(3);
+  hash_many(span{f}, span{fh});
+  hash_many(span{d}, span{dh});
+  EXPECT_TRUE(fh == dh);
+  EXPECT_NE(dh[0], dh[1]);
+}
+
+TEST(optAlgorithms, hashMixAvalanche)
+{
+  // flipping a single input bit flips about half of the output bits
+  for(uint64_t x : {0ull, 1ull, 0x1234'5678'9ABC'DEF0ull}) {
+    for(int bit = 0; bit < 64; ++bit) {
+      const auto diff = detail::simd::hash_mix(x) ^ detail::simd::hash_mix(x ^ (uint64_t{1} << bit));
+      EXPECT_GT(popcount(diff), 12) << "x=" << x << " bit=" << bit;
+      EXPECT_LT(popcount(diff), 52) << "x=" << x << " bit=" << bit;
+    }
+  }
+  vector<uint64_t> in(37), out(in.size());
+  for(size_t i = 0; i < in.size(); ++i)
+    in[i] = i * 0x0123'4567'89AB'CDEFull;
+  detail::simd::hash_mix(in.data(), out.data(), in.size());
+  for(size_t i = 0; i < in.size(); ++i)
+    EXPECT_EQ(detail::simd::hash_mix(in[i]), out[i]);
+}
+
+template<typename Opt>
+constexpr bool has_as_values = requires(span<Opt> s) { as_values(s); };
+
+template<typename T, typename Policy>
+constexpr bool has_as_opts = requires(span<T> s) { as_opts<Policy>(s); };
+
+TEST(optAlgorithms, zeroCopyValues)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  const vector<opt_long> v{1, nullopt, 3};
+  const auto values = as_values(span{v});
+  static_assert(is_same_v<decltype(values), const span<const long>>);
+  EXPECT_EQ(static_cast<const void*>(v.data()), static_cast<const void*>(values.data()));
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(-1, values[1]);
+  EXPECT_EQ(3, values[2]);
+
+  // the null values of storage types other than T are not valid T objects
+  static_assert(has_as_values<opt<long, opt_null_value_policy<long, -1>>>);
+  static_assert(!has_as_values<opt<bool>>);
+  static_assert(!has_as_values<opt<weekday>>);
+  static_assert(!has_as_opts<bool, opt_default_policy<bool>>);
+}
+
+TEST(optAlgorithms, fromValidityBitmapInPlace)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  vector<long> values(200);
+  vector<uint8_t> bitmap(25);
+  for(size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<long>(i) * 10;
+    if(i % 5) bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+  }
+  const auto column = as_opts<opt_null_value_policy<long, -1>>(span{values});
+  static_assert(is_same_v<decltype(column), const span<opt_long>>);
+  from_validity_bitmap(span{values}, span{bitmap}, column);
+  for(size_t i = 0; i < values.size(); ++i) {
+    ASSERT_EQ(i % 5 != 0, column[i].has_value());
+    if(column[i]) {
+      EXPECT_EQ(static_cast<long>(i) * 10, *column[i]);
+    }
+  }
+  EXPECT_EQ(-1, values[0]);
+}
@@ -0,0 +1,145 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_bool_vector.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using bool_vector = opt_bool_vector<>;
+  using opt_bool = opt<bool>;
+
+  const opt_bool unknown{};
+  const opt_bool t{true};
+  const opt_bool f{false};
+
+  // reference Kleene logic
+  opt_bool kleene_and(opt_bool a, opt_bool b)
+  {
+    if(a == false || b == false) return f;
+    if(a == true && b == true) return t;
+    return unknown;
+  }
+  opt_bool kleene_or(opt_bool a, opt_bool b)
+  {
+    if(a == true || b == true) return t;
+    if(a == false && b == false) return f;
+    return unknown;
+  }
+  opt_bool kleene_xor(opt_bool a, opt_bool b) { return a && b ? opt_bool{*a != *b} : unknown; }
+  opt_bool kleene_not(opt_bool a) { return a ? opt_bool{!*a} : unknown; }
+
+  vector<opt_bool> make(size_t size, unsigned seed)
+  {
+    mt19937 gen{seed};
+    uniform_int_distribution<int> dist{0, 2};
+    vector<opt_bool> v(size);
+    for(auto& o : v)
+      if(const auto d = dist(gen); d < 2) o = opt_bool{d == 1};
+    return v;
+  }
+
+  vector<opt_bool> unpacked(const bool_vector& v)
+  {
+    vector<opt_bool> out(v.size());
+    v.unpack(out);
+    return out;
+  }
+
+}
+
+TEST(optBoolVector, truthTables)
+{
+  // all 9 combinations
+  const vector<opt_bool> a{unknown, unknown, unknown, f, f, f, t, t, t};
+  const vector<opt_bool> b{unknown, f, t, unknown, f, t, unknown, f, t};
+  const bool_vector va{a}, vb{b};
+  const auto r_and = unpacked(va & vb);
+  const auto r_or = unpacked(va | vb);
+  const auto r_xor = unpacked(va ^ vb);
+  const auto r_not = unpacked(~va);
+  for(size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(kleene_and(a[i], b[i]), r_and[i]) << i;
+    EXPECT_EQ(kleene_or(a[i], b[i]), r_or[i]) << i;
+    EXPECT_EQ(kleene_xor(a[i], b[i]), r_xor[i]) << i;
+    EXPECT_EQ(kleene_not(a[i]), r_not[i]) << i;
+  }
+}
+
+TEST(optBoolVector, getSet)
+{
+  bool_vector v(70);
+  EXPECT_EQ(70u, v.count_unknown());
+  v.set(3, t);
+  v.set(65, f);
+  EXPECT_EQ(t, v[3]);
+  EXPECT_EQ(f, v[65]);
+  EXPECT_FALSE(v[4].has_value());
+  EXPECT_EQ(1u, v.count_true());
+  EXPECT_EQ(1u, v.count_false());
+  EXPECT_EQ(68u, v.count_unknown());
+  v.set(3, unknown);
+  EXPECT_FALSE(v[3].has_value());
+  EXPECT_EQ(0u, v.values()[0]);
+}
+
+TEST(optBoolVector, bulk)
+{
+  for(size_t size : {0u, 1u, 63u, 64u, 65u, 1000u}) {
+    const auto a = make(size, 1), b = make(size, 2), c = make(size, 3);
+    const bool_vector va{a}, vb{b}, vc{c};
+    EXPECT_EQ(a, unpacked(va)) << size;
+
+    // a AND (b OR NOT c)
+    const auto r = unpacked(va & (vb | ~vc));
+    size_t trues = 0, unknowns = 0;
+    for(size_t i = 0; i < size; ++i) {
+      const auto expected = kleene_and(a[i], kleene_or(b[i], kleene_not(c[i])));
+      EXPECT_EQ(expected, r[i]) << size << " " << i;
+      trues += expected == true;
+      unknowns += !expected.has_value();
+    }
+    const auto result = va & (vb | ~vc);
+    EXPECT_EQ(trues, result.count_true());
+    EXPECT_EQ(unknowns, result.count_unknown());
+    EXPECT_EQ(size - trues - unknowns, result.count_false());
+  }
+}
+
+TEST(optBoolVector, tailStaysUnknown)
+{
+  bool_vector v(10);
+  v = ~v;
+  EXPECT_EQ(10u, v.count_unknown());
+  v.set(9, t);
+  v.resize(5);
+  v.resize(10);
+  EXPECT_FALSE(v[9].has_value());
+  EXPECT_EQ(0u, v.count_true());
+  EXPECT_EQ(bool_vector(10), v);
+}
@@ -0,0 +1,153 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_bounded.h"
+#include "opt_packed_array.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using percent = opt_bounded<0, 100>;
+  using year = opt_bounded<1900, 2154>;
+  using seconds_of_day = opt_bounded<0, 86'399>;
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+
+  struct record_int {
+    opt_int progress, minute, hour;
+    opt<int, opt_null_value_policy<int, 0>> born;
+  };
+  struct record_bounded {
+    percent progress;
+    opt_bounded<0, 59> minute;
+    opt_bounded<0, 23> hour;
+    year born;
+  };
+
+  struct null_1000 {
+    static constexpr long long null_value = 1000;
+  };
+
+}
+
+TEST(optBounded, storage)
+{
+  static_assert(sizeof(percent) == 1);
+  static_assert(sizeof(opt_bounded<-128, 126>) == 1);
+  static_assert(sizeof(opt_bounded<-128, 127>) == 2);  // no room for the null value in a byte
+  static_assert(sizeof(year) == 1);
+  static_assert(sizeof(seconds_of_day) == 4);
+  static_assert(sizeof(opt_bounded<0, 65'534>) == 2);
+  static_assert(sizeof(opt_bounded<numeric_limits<int64_t>::min(), numeric_limits<int64_t>::max() - 1>) == 8);
+  static_assert(sizeof(record_bounded) * 4 == sizeof(record_int));
+  static_assert(is_same_v<bounded_int<0, 100>::value_type, int>);
+  static_assert(is_same_v<bounded_int<0, 1LL << 40>::value_type, intmax_t>);
+
+  // a niche of the inner opt is used as a null value of the outer one
+  static_assert(sizeof(opt<percent>) == 1);
+  static_assert(opt_default_policy<bounded_int<0, 100>>::niche_count == 155);
+}
+
+TEST(optBounded, access)
+{
+  constexpr percent p = 42;
+  static_assert(p.has_value() && *p == 42);
+  static_assert(bounded_int<0, 100>::encode(42) == 42);
+
+  year y;
+  EXPECT_FALSE(y.has_value());
+  y = 1900;
+  EXPECT_EQ(0, y->code());
+  EXPECT_EQ(1900, *y);
+  y = 2154;
+  EXPECT_EQ(254, y->code());
+  EXPECT_EQ(2154, y.value());
+  EXPECT_TRUE(y.has_value());
+  EXPECT_EQ(year{2154}, y);
+  EXPECT_NE(year{}, y);
+
+  const opt_bounded<-40, 50> t = -40;
+  EXPECT_EQ(-40, *t);
+  EXPECT_LT(*t, 0);
+  EXPECT_EQ(30, *(opt_bounded<-40, 50>{-10}.transform([](int v) { return v * -3; })));
+
+  opt<percent> nested = percent{};
+  EXPECT_TRUE(nested.has_value());
+  EXPECT_FALSE(nested->has_value());
+  nested.reset();
+  EXPECT_FALSE(nested.has_value());
+}
+
+#ifndef NDEBUG
+TEST(optBoundedDeathTest, outOfRange)
+{
+  EXPECT_DEATH(percent{101}, "");
+  EXPECT_DEATH(year{1899}, "");
+}
+#endif
+
+TEST(optBounded, widenNarrow)
+{
+  mt19937 gen{42};
+  uniform_int_distribution<int> dist{-1, 100};
+  vector<opt_int> wide(1003);
+  for(auto& v : wide)
+    if(const auto d = dist(gen); d >= 0) v = d;
+
+  vector<percent> narrowed(wide.size());
+  narrow(span<const opt_int>{wide}, span{narrowed});
+  for(size_t i = 0; i < wide.size(); ++i) {
+    ASSERT_EQ(wide[i].has_value(), narrowed[i].has_value());
+    if(wide[i]) {
+      ASSERT_EQ(*wide[i], *narrowed[i]);
+    }
+  }
+
+  vector<opt_int> widened(wide.size());
+  widen(span<const percent>{narrowed}, span{widened});
+  EXPECT_EQ(wide, widened);
+
+  // generic path
+  vector<opt<long long, opt_null_type_policy<long long, null_1000>>> other(3);
+  const vector<year> years{year{1999}, year{}, year{2024}};
+  widen(span{years}, span{other});
+  EXPECT_EQ(1999, *other[0]);
+  EXPECT_FALSE(other[1].has_value());
+  EXPECT_EQ(2024, *other[2]);
+}
+
+TEST(optBounded, packed)
+{
+  using packed = opt_packed_array<bounded_int<0, 59>>;
+  static_assert(packed::bits == 6);
+  packed a(100);
+  a[7] = 59;
+  a[8] = 0;
+  EXPECT_EQ(59, *a.get(7));
+  EXPECT_EQ(0, *a.get(8));
+  EXPECT_FALSE(a.get(9).has_value());
+  EXPECT_EQ(2u, a.count_values());
+}
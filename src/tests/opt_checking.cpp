@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  struct callback_error : runtime_error {
+    callback_error() : runtime_error{"opt_check_failed"} {}
+  };
+
+  template<opt_checking Mode>
+  struct checking_policy {
+    static constexpr int null_value() noexcept { return -1; }
+    static constexpr opt_checking checking = Mode;
+  };
+
+  template<opt_checking Mode>
+  using opt_int = opt<int, checking_policy<Mode>>;
+
+}
+
+[[noreturn]] void mp::opt_check_failed() { throw callback_error{}; }
+
+TEST(optChecking, traits)
+{
+  static_assert(opt_default_checking == opt_checking::standard);
+  static_assert(opt_policy_traits<int, opt_null_value_policy<int, -1>>::checking == opt_checking::standard);
+  static_assert(opt_int<opt_checking::trap>::traits_type::checking == opt_checking::trap);
+
+  // checks do not prevent constant evaluation
+  static_assert(*opt_int<opt_checking::exception>{1} == 1);
+  static_assert(opt_int<opt_checking::trap>{2}.value() == 2);
+  static_assert(opt_int<opt_checking::assume>{3}.value() == 3);
+}
+
+TEST(optChecking, notEmpty)
+{
+  opt_int<opt_checking::exception> e{1};
+  opt_int<opt_checking::assume> a{2};
+  opt_int<opt_checking::trap> t{3};
+  opt_int<opt_checking::callback> c{4};
+  EXPECT_EQ(1, *e);
+  EXPECT_EQ(1, e.value());
+  EXPECT_EQ(2, *a);
+  EXPECT_EQ(2, std::move(a).value());
+  EXPECT_EQ(3, *t);
+  EXPECT_EQ(3, t.value());
+  EXPECT_EQ(4, *c);
+  EXPECT_EQ(4, c.value());
+}
+
+TEST(optChecking, exception)
+{
+  const opt_int<opt_checking::exception> o;
+  EXPECT_THROW(*o, bad_optional_access);
+  EXPECT_THROW(o.value(), bad_optional_access);
+
+  const opt<int, opt_null_value_policy<int, -1>> s;
+  EXPECT_THROW(s.value(), bad_optional_access);
+}
+
+TEST(optChecking, callback)
+{
+  opt_int<opt_checking::callback> o;
+  EXPECT_THROW(*o, callback_error);
+  EXPECT_THROW(std::move(o).value(), callback_error);
+}
+
+TEST(optCheckingDeathTest, trap)
+{
+  const opt_int<opt_checking::trap> o;
+  EXPECT_DEATH(*o, "");
+  EXPECT_DEATH(o.value(), "");
+}
+
+#ifndef NDEBUG
+TEST(optCheckingDeathTest, assertion)
+{
+  const opt_int<opt_checking::assertion> o;
+  EXPECT_DEATH(o.value(), "");
+  const opt_int<opt_checking::assume> a;
+  EXPECT_DEATH(*a, "");
+}
+#endif
@@ -0,0 +1,357 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_flat_map.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using map_type = opt_flat_map<long, string, policy>;
+  using set_type = opt_flat_set<long, policy>;
+
+  // copy and move constructors throw when the countdown reaches 0
+  struct throwing_value {
+    inline static int constructions_left = -1;
+    int value;
+
+    throwing_value(int v) : value{v} {}
+    throwing_value(const throwing_value& other) : value{other.value} { count(); }
+    throwing_value(throwing_value&& other) noexcept(false) : value{other.value} { count(); }
+    throwing_value& operator=(const throwing_value&) = default;
+
+    static void count()
+    {
+      if(constructions_left == 0) throw runtime_error{"construction"};
+      if(constructions_left > 0) --constructions_left;
+    }
+  };
+
+}
+
+TEST(optFlatMap, empty)
+{
+  map_type m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(0u, m.size());
+  EXPECT_EQ(0u, m.bucket_count());
+  EXPECT_FALSE(m.contains(1));
+  EXPECT_EQ(m.end(), m.find(1));
+  EXPECT_EQ(m.begin(), m.end());
+  EXPECT_EQ(0u, m.erase(1));
+  EXPECT_THROW(m.at(1), out_of_range);
+}
+
+TEST(optFlatMap, insertFind)
+{
+  map_type m;
+  EXPECT_TRUE(m.insert(1, "one").second);
+  EXPECT_TRUE(m.insert(2, "two").second);
+  EXPECT_FALSE(m.insert(1, "uno").second);
+  EXPECT_EQ(2u, m.size());
+  EXPECT_EQ("one", m.at(1));
+  EXPECT_EQ("two", m.find(2)->second);
+  EXPECT_EQ(2, m.find(2)->first);
+  EXPECT_FALSE(m.contains(3));
+  EXPECT_EQ(1u, m.count(1));
+  EXPECT_EQ(0u, m.count(3));
+
+  m[3] = "three";
+  EXPECT_EQ("three", m.at(3));
+  EXPECT_EQ("", m[4]);
+  EXPECT_EQ(4u, m.size());
+
+  EXPECT_FALSE(m.insert_or_assign(1, "uno").second);
+  EXPECT_EQ("uno", m.at(1));
+  EXPECT_EQ(5, m.try_emplace(5, 3, 'x').first->first);
+  EXPECT_EQ("xxx", m.at(5));
+}
+
+TEST(optFlatMap, growOnlyForNewKeys)
+{
+  map_type m;
+  for(long i = 0; i < 12; ++i)
+    m[i] = to_string(i);
+  ASSERT_EQ(16u, m.bucket_count());  // full up to max_load_factor()
+
+  EXPECT_FALSE(m.insert(5, "five").second);
+  EXPECT_FALSE(m.try_emplace(m.begin()->first, "first").second);
+  EXPECT_EQ("4", m[4]);
+  EXPECT_EQ(16u, m.bucket_count());
+
+  // the value refers to an entry of the map that is moved by the rehash
+  EXPECT_TRUE(m.insert(100, m.at(3)).second);
+  EXPECT_EQ(32u, m.bucket_count());
+  EXPECT_EQ("3", m.at(100));
+  EXPECT_EQ(13u, m.size());
+}
+
+TEST(optFlatMap, keysLayout)
+{
+  map_type m{100};
+  EXPECT_EQ(128u, m.bucket_count());
+  m.reserve(100);
+  EXPECT_EQ(256u, m.bucket_count());
+  for(long i = 0; i < 1000; ++i)
+    m[i] = to_string(i);
+  EXPECT_LE(m.load_factor(), map_type::max_load_factor());
+}
+
+TEST(optFlatMap, erase)
+{
+  map_type m;
+  for(long i = 0; i < 100; ++i)
+    m[i] = to_string(i);
+  for(long i = 0; i < 100; i += 2)
+    EXPECT_EQ(1u, m.erase(i));
+  EXPECT_EQ(50u, m.size());
+  for(long i = 0; i < 100; ++i) {
+    EXPECT_EQ(i % 2 != 0, m.contains(i)) << i;
+    if(i % 2) {
+      EXPECT_EQ(to_string(i), m.at(i));
+    }
+  }
+}
+
+TEST(optFlatMap, iteration)
+{
+  map_type m;
+  for(long i = 0; i < 50; ++i)
+    m[i * 7] = to_string(i);
+  size_t count = 0;
+  for(auto [k, v] : m) {
+    EXPECT_EQ(to_string(k / 7), v);
+    ++count;
+  }
+  EXPECT_EQ(m.size(), count);
+
+  const map_type& cm = m;
+  count = 0;
+  for(auto it = cm.begin(); it != cm.end(); ++it)
+    ++count;
+  EXPECT_EQ(m.size(), count);
+}
+
+TEST(optFlatMap, eraseIterator)
+{
+  map_type m;
+  for(long i = 0; i < 100; ++i)
+    m[i] = to_string(i);
+  for(auto it = m.begin(); it != m.end();)
+    if(it->first % 3 == 0)
+      it = m.erase(it);
+    else
+      ++it;
+  for(long i = 0; i < 100; ++i)
+    EXPECT_EQ(i % 3 != 0, m.contains(i)) << i;
+}
+
+TEST(optFlatMap, eraseIteratorVisitsEveryEntryOnce)
+{
+  // small tables with random keys have clusters that wrap around the end of the slot array
+  mt19937 gen{3};
+  uniform_int_distribution<long> key{0, 1'000'000};
+  for(int round = 0; round < 500; ++round) {
+    map_type m;
+    for(int i = 0; i < 12; ++i)
+      m[key(gen)] = "";
+    const auto size = m.size();
+    unordered_map<long, int> visits;
+    size_t erased = 0;
+    for(auto it = m.begin(); it != m.end();) {
+      ++visits[it->first];
+      if(gen() % 2) {
+        it = m.erase(it);
+        ++erased;
+      }
+      else {
+        ++it;
+      }
+    }
+    ASSERT_EQ(size, visits.size());
+    for(auto [k, n] : visits)
+      ASSERT_EQ(1, n) << "round " << round << ", key " << k;
+    EXPECT_EQ(size - erased, m.size());
+  }
+}
+
+TEST(optFlatMap, copyMove)
+{
+  map_type m;
+  for(long i = 0; i < 100; ++i)
+    m[i] = to_string(i);
+
+  map_type copy{m};
+  EXPECT_EQ(m.size(), copy.size());
+  for(long i = 0; i < 100; ++i)
+    EXPECT_EQ(to_string(i), copy.at(i));
+
+  map_type moved{std::move(copy)};
+  EXPECT_EQ(100u, moved.size());
+  EXPECT_TRUE(copy.empty());
+  EXPECT_FALSE(copy.contains(1));
+
+  copy = moved;
+  EXPECT_EQ(100u, copy.size());
+  moved.clear();
+  EXPECT_TRUE(moved.empty());
+  EXPECT_FALSE(moved.contains(1));
+  EXPECT_EQ("5", copy.at(5));
+}
+
+TEST(optFlatMap, rehashStrongGuarantee)
+{
+  opt_flat_map<long, throwing_value, policy> m;
+  for(long i = 0; i < 10; ++i)
+    m.try_emplace(i, static_cast<int>(i));
+  const auto buckets = m.bucket_count();
+
+  throwing_value::constructions_left = 5;
+  EXPECT_THROW(m.reserve(1000), runtime_error);
+  throwing_value::constructions_left = -1;
+  EXPECT_EQ(buckets, m.bucket_count());
+  ASSERT_EQ(10u, m.size());
+  for(long i = 0; i < 10; ++i)
+    EXPECT_EQ(i, m.at(i).value);
+
+  m.reserve(1000);
+  EXPECT_LT(buckets, m.bucket_count());
+  for(long i = 0; i < 10; ++i)
+    EXPECT_EQ(i, m.at(i).value);
+}
+
+TEST(optFlatMap, randomOperations)
+{
+  mt19937 gen{1};
+  uniform_int_distribution<long> key{0, 2000};
+  uniform_int_distribution<int> op{0, 2};
+  map_type m;
+  unordered_map<long, string> ref;
+  for(int i = 0; i < 20000; ++i) {
+    const auto k = key(gen);
+    switch(op(gen)) {
+      case 0:
+        EXPECT_EQ(ref.insert_or_assign(k, to_string(i)).second, m.insert_or_assign(k, to_string(i)).second);
+        break;
+      case 1:
+        EXPECT_EQ(ref.erase(k), m.erase(k));
+        break;
+      default:
+        ASSERT_EQ(ref.count(k), m.count(k));
+        if(ref.count(k)) {
+          EXPECT_EQ(ref.at(k), m.at(k));
+        }
+    }
+  }
+  EXPECT_EQ(ref.size(), m.size());
+  for(auto [k, v] : m)
+    EXPECT_EQ(ref.at(k), v);
+}
+
+TEST(optFlatMap, findMany)
+{
+  map_type m;
+  for(long i = 0; i < 1000; i += 2)
+    m[i] = to_string(i);
+  vector<long> keys(1000);
+  for(long i = 0; i < 1000; ++i)
+    keys[static_cast<size_t>(i)] = i;
+  vector<const string*> results(keys.size());
+  static_cast<const map_type&>(m).find_many(keys, results);
+  for(size_t i = 0; i < keys.size(); ++i) {
+    if(i % 2) {
+      EXPECT_EQ(nullptr, results[i]);
+    }
+    else {
+      ASSERT_NE(nullptr, results[i]);
+      EXPECT_EQ(to_string(i), *results[i]);
+    }
+  }
+
+  vector<string*> mut(keys.size());
+  m.find_many(keys, mut);
+  *mut[10] = "ten";
+  EXPECT_EQ("ten", m.at(10));
+
+  map_type empty;
+  empty.find_many(keys, mut);
+  EXPECT_EQ(count(mut.begin(), mut.end(), nullptr), static_cast<ptrdiff_t>(keys.size()));
+}
+
+TEST(optFlatSet, basic)
+{
+  set_type s;
+  EXPECT_TRUE(s.insert(3).second);
+  EXPECT_TRUE(s.insert(5).second);
+  EXPECT_FALSE(s.insert(3).second);
+  EXPECT_EQ(2u, s.size());
+  EXPECT_TRUE(s.contains(3));
+  EXPECT_FALSE(s.contains(4));
+  EXPECT_EQ(5, *s.find(5));
+  EXPECT_EQ(1u, s.erase(3));
+  EXPECT_FALSE(s.contains(3));
+  EXPECT_EQ(1u, s.size());
+
+  for(long i = 0; i < 12; ++i)
+    s.insert(i * 1'000'003);
+  size_t visits = 0;
+  for(auto it = s.begin(); it != s.end(); ++visits)
+    it = s.erase(it);
+  EXPECT_EQ(13u, visits);
+  EXPECT_TRUE(s.empty());
+}
+
+TEST(optFlatSet, randomOperations)
+{
+  mt19937 gen{2};
+  uniform_int_distribution<long> key{0, 500};
+  set_type s;
+  unordered_set<long> ref;
+  for(int i = 0; i < 20000; ++i) {
+    const auto k = key(gen);
+    if(i % 3)
+      EXPECT_EQ(ref.insert(k).second, s.insert(k).second);
+    else
+      EXPECT_EQ(ref.erase(k), s.erase(k));
+  }
+  EXPECT_EQ(ref.size(), s.size());
+  size_t count = 0;
+  for(auto k : s) {
+    EXPECT_EQ(1u, ref.count(k));
+    ++count;
+  }
+  EXPECT_EQ(ref.size(), count);
+
+  vector<long> keys{0, 1, 2, 3, 500, 1000};
+  bool results[6];
+  s.contains_many(keys, results);
+  for(size_t i = 0; i < keys.size(); ++i)
+    EXPECT_EQ(ref.count(keys[i]) != 0, results[i]);
+}
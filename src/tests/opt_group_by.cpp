@@ -0,0 +1,294 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_group_by.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_int = opt<int, opt_null_value_policy<int, numeric_limits<int>::min()>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+  using opt_short_niche = opt<short, opt_niche_range_policy<short, -3, -1>>;
+
+  struct expected_group {
+    size_t rows = 0;
+    size_t count = 0;
+    double sum = 0;
+    optional<double> min, max;
+  };
+
+  // reference aggregation with std::map (the empty key is the smallest one)
+  template<typename Key, typename Measure>
+  map<Key, expected_group, less<>> reference(const vector<Key>& keys, const vector<Measure>& measures)
+  {
+    map<Key, expected_group, less<>> groups;
+    for(size_t i = 0; i < keys.size(); ++i) {
+      auto& g = groups[keys[i]];
+      ++g.rows;
+      if(!measures[i].has_value()) continue;
+      const auto x = static_cast<double>(*measures[i]);
+      ++g.count;
+      g.sum += x;
+      if(!g.min || x < *g.min) g.min = x;
+      if(!g.max || *g.max < x) g.max = x;
+    }
+    return groups;
+  }
+
+  template<typename Key, typename Measure, typename R>
+  void expect_groups(const map<Key, expected_group, less<>>& expected, const opt_group_by<Key, Measure, R>& actual)
+  {
+    EXPECT_EQ(expected.size(), actual.size());
+    const auto groups = actual.groups();
+    ASSERT_EQ(expected.size(), groups.size());
+    for(const auto& g : groups) {
+      const auto it = expected.find(g.key);
+      ASSERT_NE(expected.end(), it);
+      const auto& e = it->second;
+      EXPECT_EQ(e.rows, g.rows);
+      EXPECT_EQ(e.count, g.count);
+      EXPECT_EQ(e.count != 0, g.sum.has_value());
+      EXPECT_EQ(e.count != 0, g.mean.has_value());
+      EXPECT_EQ(e.min.has_value(), g.min.has_value());
+      EXPECT_EQ(e.max.has_value(), g.max.has_value());
+      if(e.count != 0) {
+        EXPECT_DOUBLE_EQ(e.sum, static_cast<double>(*g.sum));
+        EXPECT_DOUBLE_EQ(e.sum / static_cast<double>(e.count), *g.mean);
+      }
+      if(e.min) {
+        EXPECT_EQ(*e.min, static_cast<double>(*g.min));
+        EXPECT_EQ(*e.max, static_cast<double>(*g.max));
+      }
+
+      const auto found = actual.find(g.key);
+      ASSERT_TRUE(found.has_value());
+      EXPECT_EQ(g.rows, found->rows);
+    }
+  }
+
+  template<typename Key, typename Measure>
+  pair<vector<Key>, vector<Measure>> random_rows(size_t size, long cardinality, unsigned seed = 42)
+  {
+    mt19937_64 gen{seed};
+    uniform_int_distribution<long> key_dist{0, cardinality - 1};
+    uniform_int_distribution<int> measure_dist{-1000, 1000};
+    vector<Key> keys(size);
+    vector<Measure> measures(size);
+    for(size_t i = 0; i < size; ++i) {
+      if(gen() % 8 != 0) keys[i] = static_cast<typename Key::value_type>(key_dist(gen));
+      if(gen() % 3 != 0) {
+        const auto m = static_cast<typename Measure::value_type>(measure_dist(gen));
+        if(Measure::traits_type::has_value(m)) measures[i] = m;
+      }
+    }
+    return {keys, measures};
+  }
+
+  TEST(optGroupBy, empty)
+  {
+    opt_group_by<opt_long, opt_double> groups;
+    EXPECT_TRUE(groups.empty());
+    EXPECT_EQ(0u, groups.size());
+    EXPECT_TRUE(groups.groups().empty());
+    EXPECT_FALSE(groups.find(opt_long{1}).has_value());
+    EXPECT_FALSE(groups.find(opt_long{}).has_value());
+    groups.add({}, {});
+    EXPECT_TRUE(groups.empty());
+  }
+
+  TEST(optGroupBy, nullKeyIsItsOwnGroup)
+  {
+    const vector<opt_long> keys = {1, {}, 2, {}, 1, 2};
+    const vector<opt_double> measures = {1.5, 2.0, {}, 4.0, {}, {}};
+    opt_group_by<opt_long, opt_double> groups;
+    groups.add(keys, measures);
+    ASSERT_EQ(3u, groups.size());
+
+    const auto null_group = groups.find(opt_long{});
+    ASSERT_TRUE(null_group.has_value());
+    EXPECT_FALSE(null_group->key.has_value());
+    EXPECT_EQ(2u, null_group->rows);
+    EXPECT_EQ(2u, null_group->count);
+    EXPECT_EQ(6.0, *null_group->sum);
+    EXPECT_EQ(2.0, *null_group->min);
+    EXPECT_EQ(4.0, *null_group->max);
+    EXPECT_EQ(3.0, *null_group->mean);
+
+    const auto one = groups.find(opt_long{1});
+    ASSERT_TRUE(one.has_value());
+    EXPECT_EQ(2u, one->rows);
+    EXPECT_EQ(1u, one->count);
+    EXPECT_EQ(1.5, *one->sum);
+
+    // all measures of the group are empty
+    const auto two = groups.find(opt_long{2});
+    ASSERT_TRUE(two.has_value());
+    EXPECT_EQ(2u, two->rows);
+    EXPECT_EQ(0u, two->count);
+    EXPECT_FALSE(two->sum.has_value());
+    EXPECT_FALSE(two->min.has_value());
+    EXPECT_FALSE(two->max.has_value());
+    EXPECT_FALSE(two->mean.has_value());
+
+    EXPECT_FALSE(groups.find(opt_long{3}).has_value());
+  }
+
+  TEST(optGroupBy, matchesReference)
+  {
+    for(long cardinality : {1L, 10L, 1000L, 100'000L}) {
+      const auto [keys, measures] = random_rows<opt_long, opt_double>(300'000, cardinality);
+      opt_group_by<opt_long, opt_double> groups;
+      groups.add(keys, measures);
+      expect_groups(reference(keys, measures), groups);
+    }
+  }
+
+  TEST(optGroupBy, integralMeasures)
+  {
+    const auto [keys, measures] = random_rows<opt_int, opt_long>(100'000, 500);
+    opt_group_by<opt_int, opt_long> groups;
+    groups.add(keys, measures);
+    expect_groups(reference(keys, measures), groups);
+    static_assert(is_same_v<opt<int64_t, opt_null_value_policy<int64_t, numeric_limits<int64_t>::min()>>,
+                            decltype(groups.groups().front().sum)>);
+    static_assert(is_same_v<opt_long, decltype(groups.groups().front().min)>);
+  }
+
+  TEST(optGroupBy, genericMeasures)
+  {
+    const auto [keys, measures] = random_rows<opt_long, opt_short_niche>(100'000, 50);
+    opt_group_by<opt_long, opt_short_niche> groups;
+    groups.add(keys, measures);
+    expect_groups(reference(keys, measures), groups);
+  }
+
+  TEST(optGroupBy, batches)
+  {
+    const auto [keys, measures] = random_rows<opt_long, opt_double>(100'000, 3000);
+    opt_group_by<opt_long, opt_double> groups;
+    for(size_t i = 0; i < keys.size(); i += 7777) {
+      const auto n = min<size_t>(7777, keys.size() - i);
+      groups.add(span{keys}.subspan(i, n), span{measures}.subspan(i, n));
+    }
+    expect_groups(reference(keys, measures), groups);
+  }
+
+  TEST(optGroupBy, threads)
+  {
+    for(long cardinality : {3L, 5000L, 1'000'000L}) {
+      const auto [keys, measures] = random_rows<opt_long, opt_double>(400'000, cardinality);
+      const auto expected = reference(keys, measures);
+      for(unsigned threads : {2u, 5u, 0u}) {
+        opt_group_by<opt_long, opt_double> groups;
+        groups.add(keys, measures, threads);
+        expect_groups(expected, groups);
+      }
+    }
+  }
+
+  TEST(optGroupBy, mixedThreadCounts)
+  {
+    const auto [keys, measures] = random_rows<opt_long, opt_double>(600'000, 20'000);
+    opt_group_by<opt_long, opt_double> groups;
+    const span<const opt_long> k{keys};
+    const span<const opt_double> m{measures};
+    groups.add(k.first(200'000), m.first(200'000));
+    groups.add(k.subspan(200'000, 200'000), m.subspan(200'000, 200'000), 3);
+    groups.add(k.last(200'000), m.last(200'000), 2);
+    expect_groups(reference(keys, measures), groups);
+  }
+
+  TEST(optGroupBy, merge)
+  {
+    const auto [keys, measures] = random_rows<opt_long, opt_double>(200'000, 10'000);
+    const span<const opt_long> k{keys};
+    const span<const opt_double> m{measures};
+    opt_group_by<opt_long, opt_double> first, second;
+    first.add(k.first(50'000), m.first(50'000));
+    second.add(k.subspan(50'000), m.subspan(50'000), 2);
+    first.merge(second);
+    expect_groups(reference(keys, measures), first);
+
+    first.clear();
+    EXPECT_TRUE(first.empty());
+    first.merge(second);
+    EXPECT_EQ(second.size(), first.size());
+  }
+
+  TEST(optGroupBy, smallKeys)
+  {
+    // a SIMD probe of 1-byte keys covers more slots than there are in a small table
+    using opt_byte = opt<uint8_t, opt_null_value_policy<uint8_t, 255>>;
+    for(long cardinality : {2L, 20L, 255L}) {
+      const auto [keys, measures] = random_rows<opt_byte, opt_int>(50'000, cardinality);
+      opt_group_by<opt_byte, opt_int> groups;
+      groups.add(keys, measures);
+      expect_groups(reference(keys, measures), groups);
+    }
+  }
+
+  TEST(optGroupBy, floatingPointKeys)
+  {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    const vector<opt_double> keys = {0.0, -0.0, nan, nan, opt_double{}, 1.5};
+    const vector<opt_long> measures = {1, 2, 3, 4, 5, 6};
+    opt_group_by<opt_double, opt_long> groups;
+    groups.add(keys, measures);
+    EXPECT_EQ(4u, groups.size());
+    EXPECT_EQ(3, *groups.find(opt_double{0.0})->sum);
+    EXPECT_EQ(3, *groups.find(opt_double{-0.0})->sum);
+    EXPECT_EQ(7, *groups.find(opt_double{nan})->sum);
+    EXPECT_EQ(5, *groups.find(opt_double{})->sum);
+  }
+
+  TEST(optGroupBy, nanMeasures)
+  {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    const vector<opt_long> keys = {1, 1, 1, 2};
+    const vector<opt_double> measures = {nan, 3.0, -2.0, nan};
+    opt_group_by<opt_long, opt_double> groups;
+    groups.add(keys, measures);
+    const auto one = *groups.find(opt_long{1});
+    EXPECT_EQ(3u, one.count);
+    EXPECT_TRUE(isnan(*one.sum));
+    EXPECT_EQ(-2.0, *one.min);
+    EXPECT_EQ(3.0, *one.max);
+    const auto two = *groups.find(opt_long{2});
+    EXPECT_EQ(1u, two.count);
+    EXPECT_FALSE(two.min.has_value());
+    EXPECT_FALSE(two.max.has_value());
+  }
+
+}  // namespace
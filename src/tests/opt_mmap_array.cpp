@@ -0,0 +1,146 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_mmap_array.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  // removes the file when the test ends
+  struct temp_file {
+    filesystem::path path;
+    explicit temp_file(const char* name) : path{filesystem::temp_directory_path() / name} {}
+    ~temp_file() { filesystem::remove(path); }
+  };
+
+}
+
+TEST(optMmapArray, header)
+{
+  const auto h = opt_mmap_array<long, opt_null_value_policy<long, -1>>::make_header(10);
+  EXPECT_EQ(sizeof(long), h.element_size);
+  EXPECT_EQ(10u, h.count);
+  long null;
+  memcpy(&null, h.null_pattern.data(), sizeof(null));
+  EXPECT_EQ(-1, null);
+}
+
+TEST(optMmapArray, roundTrip)
+{
+  temp_file file{"opt_mmap_array_round_trip.bin"};
+  vector<opt_long> values;
+  for(long i = 0; i < 10000; ++i) values.push_back(i % 3 ? opt_long{i} : opt_long{});
+  opt_mmap_array<long, opt_null_value_policy<long, -1>>::save(file.path, values);
+
+  const opt_mmap_array<long, opt_null_value_policy<long, -1>> a{file.path};
+  EXPECT_EQ(opt_mmap_mode::read_only, a.mode());
+  ASSERT_EQ(values.size(), a.size());
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a.data()) % 64);
+  EXPECT_TRUE(equal(values.begin(), values.end(), a.begin(), a.end()));
+  EXPECT_FALSE(a[3].has_value());
+  EXPECT_EQ(4, a[4]);
+  EXPECT_EQ(values.size(), a.values().size());
+}
+
+TEST(optMmapArray, nanPolicy)
+{
+  temp_file file{"opt_mmap_array_nan.bin"};
+  const vector<opt_double> values{opt_double{1.5}, opt_double{}, opt_double{numeric_limits<double>::quiet_NaN()}};
+  opt_mmap_array<double, opt_nan_policy<double>>::save(file.path, values);
+
+  const opt_mmap_array<double, opt_nan_policy<double>> a{file.path};
+  ASSERT_EQ(3u, a.size());
+  EXPECT_EQ(1.5, a[0]);
+  EXPECT_FALSE(a[1].has_value());
+  ASSERT_TRUE(a[2].has_value());
+  EXPECT_TRUE(isnan(*a[2]));
+}
+
+TEST(optMmapArray, empty)
+{
+  temp_file file{"opt_mmap_array_empty.bin"};
+  opt_mmap_array<long, opt_null_value_policy<long, -1>>::save(file.path, {});
+  const opt_mmap_array<long, opt_null_value_policy<long, -1>> a{file.path};
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a.begin(), a.end());
+}
+
+TEST(optMmapArray, copyOnWrite)
+{
+  temp_file file{"opt_mmap_array_cow.bin"};
+  const vector<opt_long> values{opt_long{1}, opt_long{2}};
+  opt_mmap_array<long, opt_null_value_policy<long, -1>>::save(file.path, values);
+
+  opt_mmap_array<long, opt_null_value_policy<long, -1>> ro{file.path};
+  EXPECT_THROW(ro.mutable_values(), logic_error);
+
+  opt_mmap_array<long, opt_null_value_policy<long, -1>> cow{file.path, opt_mmap_mode::copy_on_write};
+  cow.mutable_values()[0] = opt_long{};
+  cow.mutable_values()[1] = opt_long{42};
+  EXPECT_FALSE(cow[0].has_value());
+  EXPECT_EQ(42, cow[1]);
+
+  // the file and other mappings are not modified
+  EXPECT_EQ(1, ro[0]);
+  const opt_mmap_array<long, opt_null_value_policy<long, -1>> reloaded{file.path};
+  EXPECT_EQ(1, reloaded[0]);
+  EXPECT_EQ(2, reloaded[1]);
+
+  auto moved = move(cow);
+  EXPECT_EQ(42, moved[1]);
+}
+
+TEST(optMmapArray, refusesMismatchedFiles)
+{
+  temp_file file{"opt_mmap_array_mismatch.bin"};
+  const vector<opt_long> values{opt_long{1}, opt_long{2}};
+  opt_mmap_array<long, opt_null_value_policy<long, -1>>::save(file.path, values);
+
+  // different null value
+  EXPECT_THROW((opt_mmap_array<long, opt_null_value_policy<long, 0>>{file.path}), runtime_error);
+  // different size
+  EXPECT_THROW((opt_mmap_array<int, opt_null_value_policy<int, -1>>{file.path}), runtime_error);
+  EXPECT_THROW((opt_mmap_array<long, opt_null_value_policy<long, -1>>{file.path.string() + ".missing"}),
+               system_error);
+
+  // truncated
+  filesystem::resize_file(file.path, filesystem::file_size(file.path) - 1);
+  EXPECT_THROW((opt_mmap_array<long, opt_null_value_policy<long, -1>>{file.path}), runtime_error);
+
+  // not an opt_mmap_array file
+  ofstream{file.path, ios::binary | ios::trunc} << string(100, 'x');
+  EXPECT_THROW((opt_mmap_array<long, opt_null_value_policy<long, -1>>{file.path}), runtime_error);
+  ofstream{file.path, ios::binary | ios::trunc} << "MP";
+  EXPECT_THROW((opt_mmap_array<long, opt_null_value_policy<long, -1>>{file.path}), runtime_error);
+}
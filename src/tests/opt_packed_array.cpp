@@ -0,0 +1,153 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_packed_array.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using packed_weekday = opt_packed_array<weekday>;
+
+  enum class color : uint8_t { red, green, blue };
+  using color_policy = opt_niche_range_policy<color, color{3}, color{255}>;
+
+  vector<opt<weekday>> make_weekdays(size_t size, unsigned seed)
+  {
+    mt19937 gen{seed};
+    uniform_int_distribution<int> dist{0, 7};
+    vector<opt<weekday>> v(size);
+    for(auto& o : v)
+      if(const auto d = dist(gen); d < 7) o = weekday{static_cast<weekday::underlying_type>(d)};
+    return v;
+  }
+
+}
+
+TEST(optPackedArray, bits)
+{
+  static_assert(packed_weekday::bits == 3);
+  static_assert(packed_weekday::per_word == 21);
+  static_assert(opt_packed_array<color, color_policy>::bits == 2);
+  static_assert(opt_packed_array<uint8_t, opt_null_value_policy<uint8_t, 15>>::bits == 4);
+  static_assert(opt_packed_array<long, opt_null_value_policy<long, -1>, 5>::bits == 5);
+
+  const packed_weekday a(1000);
+  EXPECT_EQ((1000u + 20) / 21 * sizeof(uint64_t), a.words().size_bytes());
+  EXPECT_LT(a.words().size_bytes() * 2.5, 1000 * sizeof(opt<weekday>));
+}
+
+TEST(optPackedArray, getSet)
+{
+  packed_weekday a(50);
+  EXPECT_EQ(50u, a.size());
+  EXPECT_EQ(0u, a.count_values());
+  EXPECT_FALSE(a[10].has_value());
+
+  a.set(10, weekday{6});
+  a[20] = weekday{0};
+  a[21] = weekday{3};  // first element of the second word
+  EXPECT_EQ(weekday{6}, a.get(10));
+  EXPECT_EQ(weekday{0}, *a[20]);
+  EXPECT_TRUE(a[21].has_value());
+  EXPECT_EQ(weekday{3}, static_cast<opt<weekday>>(a[21]));
+  EXPECT_FALSE(a[11].has_value());
+  EXPECT_EQ(3u, a.count_values());
+
+  a[22] = a[10];
+  EXPECT_EQ(weekday{6}, a.get(22));
+  a[10].reset();
+  a[20] = opt<weekday>{};
+  EXPECT_FALSE(a.get(10).has_value());
+  EXPECT_EQ(2u, a.count_values());
+}
+
+TEST(optPackedArray, packUnpack)
+{
+  for(size_t size : {0u, 1u, 20u, 21u, 22u, 1000u}) {
+    const auto values = make_weekdays(size, static_cast<unsigned>(size));
+    const packed_weekday a{values};
+    ASSERT_EQ(size, a.size());
+    EXPECT_TRUE(equal(a.begin(), a.end(), values.begin(), values.end())) << size;
+
+    vector<opt<weekday>> out(size);
+    a.unpack(out);
+    EXPECT_EQ(values, out) << size;
+
+    packed_weekday b;
+    for(const auto& v : values) b.push_back(v);
+    EXPECT_TRUE(equal(b.words().begin(), b.words().end(), a.words().begin(), a.words().end())) << size;
+  }
+}
+
+TEST(optPackedArray, countAndFind)
+{
+  for(size_t size : {1u, 21u, 64u, 1000u}) {
+    const auto values = make_weekdays(size, 7);
+    const packed_weekday a{values};
+    EXPECT_EQ(static_cast<size_t>(count_if(values.begin(), values.end(), [](const auto& o) { return o.has_value(); })),
+              a.count_values());
+    for(int d = 0; d < 7; ++d) {
+      const opt<weekday> day{weekday{static_cast<weekday::underlying_type>(d)}};
+      EXPECT_EQ(static_cast<size_t>(find(values.begin(), values.end(), day) - values.begin()), a.find(day)) << size;
+    }
+    EXPECT_EQ(static_cast<size_t>(find(values.begin(), values.end(), nullopt) - values.begin()), a.find_first_null());
+  }
+
+  packed_weekday full(30);
+  for(auto r : full) r = weekday{1};
+  EXPECT_EQ(30u, full.find_first_null());  // unused lanes of the last word are not reported
+  EXPECT_EQ(0u, full.find_first_value());
+  packed_weekday empty(30);
+  EXPECT_EQ(30u, empty.find_first_value());
+  empty[25] = weekday{5};
+  EXPECT_EQ(25u, empty.find_first_value());
+  EXPECT_EQ(25u, empty.find(weekday{5}));
+}
+
+TEST(optPackedArray, resize)
+{
+  packed_weekday a(30);
+  for(auto r : a) r = weekday{2};
+  a.resize(25);
+  EXPECT_EQ(25u, a.count_values());
+  a.resize(30);
+  EXPECT_EQ(25u, a.count_values());
+  EXPECT_FALSE(a[27].has_value());
+}
+
+TEST(optPackedArray, rangePolicy)
+{
+  using opt_color = opt<color, color_policy>;
+  const vector<opt_color> values{opt_color{color::blue}, opt_color{}, opt_color{color::red}};
+  const opt_packed_array<color, color_policy> a{values};
+  EXPECT_EQ(color::blue, a[0]);
+  EXPECT_FALSE(a[1].has_value());
+  EXPECT_EQ(color::red, a[2]);
+  EXPECT_EQ(2u, a.count_values());
+}
@@ -0,0 +1,181 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_radix_sort.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  enum class level : uint8_t { low, mid, high, none = 0xFF };
+  using opt_level = opt<level, opt_null_value_policy<level, level::none>>;
+
+  // empty objects at the chosen end, values in the order of `less`
+  template<typename Opt, typename Less = std::less<>>
+  auto reference_less(opt_null_order order, Less less = {})
+  {
+    return [=](const Opt& lhs, const Opt& rhs) {
+      if(lhs.has_value() != rhs.has_value()) return (order == opt_null_order::first) == rhs.has_value();
+      return lhs.has_value() && less(*lhs, *rhs);
+    };
+  }
+
+  template<typename Opt>
+  void expect_same_bits(const vector<Opt>& expected, const vector<Opt>& actual)
+  {
+    ASSERT_EQ(expected.size(), actual.size());
+    for(size_t i = 0; i < expected.size(); ++i) EXPECT_EQ(0, memcmp(&expected[i], &actual[i], sizeof(Opt))) << i;
+  }
+
+  template<typename Opt>
+  vector<Opt> random_column(size_t size, const vector<typename Opt::value_type>& special)
+  {
+    using T = typename Opt::value_type;
+    mt19937_64 gen{42};
+    vector<Opt> column(size);
+    for(auto& v : column) {
+      const auto r = gen();
+      if(r % 3 == 0) continue;
+      T value = (r % 3 == 1 && !special.empty()) ? special[(r >> 8) % special.size()] : static_cast<T>(gen());
+      if(value != T{Opt::traits_type::null_value()}) v = value;
+    }
+    return column;
+  }
+
+  template<typename Opt>
+  class optRadixSortTyped : public ::testing::Test {
+  };
+
+  using integral_types = ::testing::Types<opt_long, opt<int8_t, opt_null_value_policy<int8_t, 5>>,
+                                          opt<uint16_t, opt_null_value_policy<uint16_t, 0xFFFF>>,
+                                          opt<uint64_t, opt_null_value_policy<uint64_t, 0>>>;
+  TYPED_TEST_SUITE(optRadixSortTyped, integral_types);
+
+  TYPED_TEST(optRadixSortTyped, sortsLikeComparisonSort)
+  {
+    using T = typename TypeParam::value_type;
+    const vector<T> special{numeric_limits<T>::min(), numeric_limits<T>::max(), T{0}, T{1}, static_cast<T>(-2)};
+    for(auto order : {opt_null_order::first, opt_null_order::last}) {
+      auto values = random_column<TypeParam>(5000, special);
+      auto expected = values;
+      stable_sort(expected.begin(), expected.end(), reference_less<TypeParam>(order));
+      opt_radix_sort(span{values}, order);
+      expect_same_bits(expected, values);
+    }
+  }
+
+  TEST(optRadixSort, defaultOrder)
+  {
+    vector<opt_long> values{opt_long{3}, opt_long{}, opt_long{-7}, opt_long{}, opt_long{0}};
+    opt_radix_sort(span{values});
+    EXPECT_EQ((vector<opt_long>{opt_long{}, opt_long{}, opt_long{-7}, opt_long{0}, opt_long{3}}), values);
+  }
+
+  TEST(optRadixSort, enumeration)
+  {
+    vector<opt_level> values{opt_level{level::high}, opt_level{}, opt_level{level::low}, opt_level{level::mid}};
+    opt_radix_sort(span{values}, opt_null_order::last);
+    EXPECT_EQ((vector<opt_level>{opt_level{level::low}, opt_level{level::mid}, opt_level{level::high}, opt_level{}}),
+              values);
+  }
+
+  TEST(optRadixSort, trivialInputs)
+  {
+    vector<opt_long> values;
+    opt_radix_sort(span{values});
+    EXPECT_TRUE(values.empty());
+
+    values.assign(1, opt_long{5});
+    opt_radix_sort(span{values});
+    EXPECT_EQ(opt_long{5}, values[0]);
+
+    // all the digits are skipped
+    values.assign(1000, opt_long{});
+    opt_radix_sort(span{values}, opt_null_order::last);
+    EXPECT_TRUE(all_of(values.begin(), values.end(), [](const opt_long& v) { return !v; }));
+    values.assign(1000, opt_long{42});
+    opt_radix_sort(span{values});
+    EXPECT_TRUE(all_of(values.begin(), values.end(), [](const opt_long& v) { return v == 42; }));
+  }
+
+  TEST(optRadixSort, floatingPointTotalOrder)
+  {
+    const double inf = numeric_limits<double>::infinity();
+    const vector<double> special{-0.0, 0.0, inf, -inf, NAN, -NAN, numeric_limits<double>::denorm_min(), -1.5};
+    auto strong_less = [](double lhs, double rhs) { return is_lt(strong_order(lhs, rhs)); };
+    for(auto order : {opt_null_order::first, opt_null_order::last}) {
+      auto values = random_column<opt_double>(5000, special);
+      auto expected = values;
+      stable_sort(expected.begin(), expected.end(), reference_less<opt_double>(order, strong_less));
+      opt_radix_sort(span{values}, order);
+      expect_same_bits(expected, values);
+    }
+  }
+
+  TEST(optRadixSort, payloadIsStable)
+  {
+    auto keys = random_column<opt_long>(5000, {1, 2, 3});
+    const auto original = keys;
+    vector<uint32_t> rows(keys.size());
+    iota(rows.begin(), rows.end(), 0u);
+    opt_radix_sort(span{keys}, span{rows}, opt_null_order::last);
+    EXPECT_TRUE(is_sorted(keys.begin(), keys.end(), reference_less<opt_long>(opt_null_order::last)));
+    for(size_t i = 0; i < keys.size(); ++i) {
+      EXPECT_EQ(original[rows[i]], keys[i]);
+      if(i > 0 && keys[i] == keys[i - 1]) {
+        EXPECT_LT(rows[i - 1], rows[i]);
+      }
+    }
+  }
+
+  TEST(optRadixSort, threads)
+  {
+    const auto original = random_column<opt_double>(300'000, {-0.0, 0.0, 1.0});
+    auto single = original, multi = original;
+    vector<uint32_t> rows_single(original.size()), rows_multi(original.size());
+    iota(rows_single.begin(), rows_single.end(), 0u);
+    iota(rows_multi.begin(), rows_multi.end(), 0u);
+    opt_radix_sort(span{single}, span{rows_single}, opt_null_order::first, 1);
+    opt_radix_sort(span{multi}, span{rows_multi}, opt_null_order::first, 4);
+    expect_same_bits(single, multi);
+    EXPECT_EQ(rows_single, rows_multi);
+
+    multi = original;
+    opt_radix_sort(span{multi}, opt_null_order::first, 0);
+    expect_same_bits(single, multi);
+  }
+
+}  // namespace
@@ -0,0 +1,215 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_reduce.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_int = opt<int, opt_null_value_policy<int, numeric_limits<int>::min()>>;
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  using opt_unsigned = opt<unsigned, opt_null_value_policy<unsigned, 0>>;
+  using opt_short_niche = opt<short, opt_niche_range_policy<short, -3, -1>>;
+  using opt_float = opt<float, opt_nan_policy<float>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  template<typename Opt>
+  vector<Opt> random_column(size_t size, unsigned seed = 42)
+  {
+    using T = typename Opt::value_type;
+    mt19937_64 gen{seed};
+    uniform_int_distribution<int> small{-1000, 1000};
+    vector<Opt> column(size);
+    for(auto& v : column) {
+      if(gen() % 4 == 0) continue;
+      const T value = static_cast<T>(small(gen));
+      if(Opt::traits_type::has_value(value)) v = value;
+    }
+    return column;
+  }
+
+  template<typename Opt>
+  class optReduceTyped : public ::testing::Test {
+  };
+  using reduce_types = ::testing::Types<opt_int, opt_long, opt_unsigned, opt_short_niche, opt_float, opt_double>;
+  TYPED_TEST_SUITE(optReduceTyped, reduce_types);
+
+  TYPED_TEST(optReduceTyped, matchesLoop)
+  {
+    using T = typename TypeParam::value_type;
+    using sum_type = conditional_t<is_floating_point_v<T>, double, conditional_t<is_signed_v<T>, int64_t, uint64_t>>;
+    for(size_t size : {0, 1, 7, 8, 9, 100, 200'003}) {
+      const auto column = random_column<TypeParam>(size);
+      size_t count = 0;
+      sum_type sum{};
+      optional<T> min, max;
+      for(const auto& v : column) {
+        if(!v.has_value()) continue;
+        ++count;
+        sum += static_cast<sum_type>(*v);
+        if(!min || *v < *min) min = *v;
+        if(!max || *max < *v) max = *v;
+      }
+
+      const span<const TypeParam> values{column};
+      for(unsigned threads : {1, 3}) {
+        EXPECT_EQ(count, opt_reduce_count(values, threads));
+        const auto s = opt_reduce_sum(values, threads);
+        const auto lo = opt_reduce_min(values, threads);
+        const auto hi = opt_reduce_max(values, threads);
+        const auto mean = opt_reduce_mean(values, threads);
+        EXPECT_EQ(count != 0, s.has_value());
+        EXPECT_EQ(count != 0, lo.has_value());
+        EXPECT_EQ(count != 0, hi.has_value());
+        EXPECT_EQ(count != 0, mean.has_value());
+        if(count != 0) {
+          EXPECT_EQ(sum, *s);
+          EXPECT_EQ(*min, *lo);
+          EXPECT_EQ(*max, *hi);
+          EXPECT_DOUBLE_EQ(static_cast<double>(sum) / static_cast<double>(count), *mean);
+        }
+
+        const auto all = opt_reduce(values, threads);
+        EXPECT_EQ(count, all.count);
+        EXPECT_EQ(s, all.sum);
+        EXPECT_EQ(lo, all.min);
+        EXPECT_EQ(hi, all.max);
+        EXPECT_EQ(mean.has_value(), all.mean.has_value());
+        if(mean.has_value()) {
+          EXPECT_DOUBLE_EQ(*mean, *all.mean);
+        }
+      }
+    }
+  }
+
+  TYPED_TEST(optReduceTyped, allEmpty)
+  {
+    const vector<TypeParam> column(100'000);
+    const span<const TypeParam> values{column};
+    EXPECT_EQ(0u, opt_reduce_count(values, 0));
+    EXPECT_FALSE(opt_reduce_sum(values, 0).has_value());
+    EXPECT_FALSE(opt_reduce_min(values, 0).has_value());
+    EXPECT_FALSE(opt_reduce_max(values, 0).has_value());
+    EXPECT_FALSE(opt_reduce_mean(values, 0).has_value());
+    const auto all = opt_reduce(values, 0);
+    EXPECT_EQ(0u, all.count);
+    EXPECT_FALSE(all.sum.has_value());
+    EXPECT_FALSE(all.min.has_value());
+    EXPECT_FALSE(all.max.has_value());
+    EXPECT_FALSE(all.mean.has_value());
+  }
+
+  TEST(optReduce, resultTypes)
+  {
+    using ints = span<const opt_int>;
+    using doubles = span<const opt_double>;
+    using floats = span<opt_float>;
+    static_assert(is_same_v<opt<int64_t, opt_null_value_policy<int64_t, numeric_limits<int64_t>::min()>>,
+                            decltype(opt_reduce_sum(declval<ints>()))>);
+    static_assert(is_same_v<opt<uint64_t, opt_null_value_policy<uint64_t, numeric_limits<uint64_t>::max()>>,
+                            decltype(opt_reduce_sum(declval<span<const opt_unsigned>>()))>);
+    static_assert(is_same_v<opt_double, decltype(opt_reduce_sum(declval<doubles>()))>);
+    static_assert(is_same_v<opt_double, decltype(opt_reduce_sum(declval<floats>()))>);
+    static_assert(is_same_v<opt_float, decltype(opt_reduce_sum<float>(declval<floats>()))>);
+    static_assert(is_same_v<opt_double, decltype(opt_reduce_sum<double>(declval<ints>()))>);
+    static_assert(is_same_v<opt_int, decltype(opt_reduce_min(declval<ints>()))>);
+    static_assert(is_same_v<opt_float, decltype(opt_reduce_max(declval<floats>()))>);
+    static_assert(is_same_v<opt_double, decltype(opt_reduce_mean(declval<ints>()))>);
+  }
+
+  TEST(optReduce, sameFloatingPointSumForAnyThreads)
+  {
+    mt19937_64 gen{7};
+    lognormal_distribution<double> magnitude{0, 8};
+    vector<opt_double> column(1'000'003);
+    for(auto& v : column)
+      if(gen() % 5 != 0) v = (gen() % 2 != 0 ? -1 : 1) * magnitude(gen);
+    const span<const opt_double> values{column};
+
+    const auto expected = opt_reduce(values);
+    ASSERT_TRUE(expected.sum.has_value());
+    for(unsigned threads : {2, 3, 4, 7, 16, 0}) {
+      const auto actual = opt_reduce(values, threads);
+      EXPECT_EQ(0, memcmp(&expected.sum, &actual.sum, sizeof(opt_double))) << threads;
+      EXPECT_EQ(0, memcmp(&expected.mean, &actual.mean, sizeof(opt_double))) << threads;
+      EXPECT_EQ(expected.min, actual.min) << threads;
+      EXPECT_EQ(expected.max, actual.max) << threads;
+    }
+  }
+
+  TEST(optReduce, nanValues)
+  {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    const vector<opt_double> column = {nan, 2.0, opt_double{}, -1.0, nan, 5.0};
+    const span<const opt_double> values{column};
+    EXPECT_EQ(5u, opt_reduce_count(values));
+    EXPECT_TRUE(isnan(*opt_reduce_sum(values)));
+    EXPECT_EQ(-1.0, *opt_reduce_min(values));
+    EXPECT_EQ(5.0, *opt_reduce_max(values));
+
+    const vector<opt_double> only_nans = {nan, opt_double{}, -nan};
+    EXPECT_EQ(2u, opt_reduce_count(span{only_nans}));
+    EXPECT_TRUE(opt_reduce_sum(span{only_nans}).has_value());
+    EXPECT_FALSE(opt_reduce_min(span{only_nans}).has_value());
+    EXPECT_FALSE(opt_reduce_max(span{only_nans}).has_value());
+  }
+
+  TEST(optReduce, infinities)
+  {
+    const double inf = numeric_limits<double>::infinity();
+    const vector<opt_double> column = {inf, opt_double{}, inf};
+    EXPECT_EQ(inf, *opt_reduce_min(span{column}));
+    EXPECT_EQ(inf, *opt_reduce_max(span{column}));
+    EXPECT_EQ(inf, *opt_reduce_sum(span{column}));
+  }
+
+  TEST(optReduce, extremeIntegers)
+  {
+    const long max = numeric_limits<long>::max();
+    const long min = numeric_limits<long>::min();
+    const vector<opt_long> column = {max, opt_long{}, min, 0};
+    EXPECT_EQ(min, *opt_reduce_min(span{column}));
+    EXPECT_EQ(max, *opt_reduce_max(span{column}));
+    EXPECT_EQ(-1, *opt_reduce_sum(span{column}));
+    EXPECT_DOUBLE_EQ(-1.0 / 3, *opt_reduce_mean(span{column}));
+
+    // the smallest sum is the null of the result
+    const vector<opt_long> smallest = {min, opt_long{}};
+    const auto stats = opt_reduce(span{smallest});
+    EXPECT_EQ(1u, stats.count);
+    EXPECT_FALSE(stats.sum.has_value());
+    EXPECT_FALSE(opt_reduce_sum(span{smallest}).has_value());
+    EXPECT_EQ(static_cast<double>(min), *stats.mean);
+  }
+
+}  // namespace
@@ -0,0 +1,150 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_ring.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using long_policy = opt_null_value_policy<long, -1>;
+
+}
+
+TEST(optRing, layout)
+{
+  using ring = opt_ring<long, long_policy, 8>;
+  static_assert(ring::capacity() == 8);
+  // no per-slot state beside the value
+  static_assert(sizeof(ring) == 2 * ring::cache_line_size + 8 * sizeof(long));
+}
+
+TEST(optRing, pushPop)
+{
+  opt_ring<long, long_policy, 4> r;
+  EXPECT_TRUE(r.empty());
+  EXPECT_FALSE(r.try_pop().has_value());
+
+  for(long i = 0; i < 4; ++i) EXPECT_TRUE(r.try_push(i));
+  EXPECT_FALSE(r.try_push(4));
+  EXPECT_EQ(4u, r.size());
+
+  for(long i = 0; i < 4; ++i) {
+    auto v = r.try_pop();
+    ASSERT_TRUE(v.has_value());
+    EXPECT_EQ(i, *v);
+  }
+  EXPECT_FALSE(r.try_pop().has_value());
+  EXPECT_TRUE(r.empty());
+}
+
+TEST(optRing, notBitwiseNull)
+{
+  opt_ring<weekday, opt_default_policy<weekday>, 2> r;
+  EXPECT_TRUE(r.try_push(weekday{6}));
+  EXPECT_TRUE(r.try_push(weekday{0}));
+  EXPECT_FALSE(r.try_push(weekday{1}));
+  EXPECT_EQ(6, *r.try_pop());
+  EXPECT_EQ(0, *r.try_pop());
+  EXPECT_FALSE(r.try_pop().has_value());
+}
+
+TEST(optRing, batches)
+{
+  opt_ring<long, long_policy, 8> r;
+  array<long, 5> in;
+  array<long, 5> out;
+  long next = 0, expected = 0;
+  // wraps around the ring many times
+  for(int lap = 0; lap < 20; ++lap) {
+    for(auto& v : in) v = next++;
+    EXPECT_EQ(5u, r.try_push_n(in));
+    EXPECT_EQ(3u, r.try_pop_n(span{out}.first(3)));
+    for(size_t i = 0; i < 3; ++i) EXPECT_EQ(expected++, out[i]);
+    EXPECT_EQ(2u, r.try_pop_n(out));
+    for(size_t i = 0; i < 2; ++i) EXPECT_EQ(expected++, out[i]);
+  }
+
+  for(auto& v : in) v = next++;
+  EXPECT_EQ(5u, r.try_push_n(in));
+  EXPECT_EQ(3u, r.try_push_n(in));  // only 3 free slots
+  EXPECT_EQ(0u, r.try_push_n(in));
+  EXPECT_EQ(5u, r.try_pop_n(out));
+  EXPECT_EQ(3u, r.try_pop_n(out));
+  EXPECT_EQ(0u, r.try_pop_n(out));
+
+  // batches larger than the ring
+  array<long, 12> large;
+  iota(large.begin(), large.end(), 0);
+  EXPECT_EQ(8u, r.try_push_n(large));
+  EXPECT_EQ(8u, r.try_pop_n(large));
+  EXPECT_EQ(7, large[7]);
+}
+
+TEST(optRing, producerConsumer)
+{
+  // a small ring wraps often, so the consumer reads slots that the producer has just refilled
+  constexpr long count = 200000;
+  opt_ring<long, long_policy, 4> r;
+  vector<long> received;
+  received.reserve(count);
+
+  thread producer([&] {
+    array<long, 3> batch;
+    for(long i = 0; i < count;) {
+      const auto n = min<long>(1 + i % 3, count - i);
+      for(long j = 0; j < n; ++j) batch[j] = i + j;
+      if(const auto pushed = r.try_push_n(span{batch}.first(n)); pushed > 0)
+        i += pushed;
+      else
+        this_thread::yield();
+    }
+  });
+  array<long, 2> batch;
+  while(received.size() < count) {
+    if(received.size() % 2 == 0) {
+      if(const auto v = r.try_pop())
+        received.push_back(*v);
+      else
+        this_thread::yield();
+    }
+    else {
+      const auto n = r.try_pop_n(batch);
+      if(n == 0) this_thread::yield();
+      received.insert(received.end(), batch.begin(), batch.begin() + n);
+    }
+  }
+  producer.join();
+
+  vector<long> expected(count);
+  iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(expected, received);
+  EXPECT_TRUE(r.empty());
+}
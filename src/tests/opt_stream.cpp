@@ -0,0 +1,147 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_stream.h"
+#include "test_types.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using policy = opt_null_value_policy<long, -1>;
+  using opt_long = opt<long, policy>;
+
+  vector<opt_long> make_column(size_t size, double null_density)
+  {
+    mt19937 gen{42};
+    bernoulli_distribution is_null{null_density};
+    vector<opt_long> v(size);
+    for(size_t i = 0; i < size; ++i)
+      if(!is_null(gen)) v[i] = opt_long{static_cast<long>(i)};
+    return v;
+  }
+
+  vector<byte> encode(span<const opt_long> column, size_t chunk_size)
+  {
+    opt_stream_writer<long, policy> writer;
+    vector<byte> out;
+    for(size_t i = 0; i < column.size(); i += chunk_size)
+      writer.write(column.subspan(i, min(chunk_size, column.size() - i)), out);
+    writer.flush(out);
+    return out;
+  }
+
+  // feeds the input in `in_chunk` bytes and decodes to `out_chunk` elements at a time
+  vector<opt_long> decode(span<const byte> stream, size_t in_chunk, size_t out_chunk)
+  {
+    opt_stream_reader<long, policy> reader;
+    vector<opt_long> result;
+    vector<opt_long> buffer(out_chunk);
+    for(size_t pos = 0; pos < stream.size(); pos += in_chunk) {
+      auto in = stream.subspan(pos, min(in_chunk, stream.size() - pos));
+      while(true) {
+        const auto n = reader.read(in, buffer);
+        result.insert(result.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(n));
+        if(n < buffer.size()) break;
+      }
+      EXPECT_TRUE(in.empty());
+    }
+    EXPECT_TRUE(reader.at_run_boundary());
+    return result;
+  }
+
+}
+
+TEST(optStream, format)
+{
+  const vector<opt_long> column{opt_long{}, opt_long{}, opt_long{5}, opt_long{}};
+  const auto stream = encode(column, column.size());
+  ASSERT_EQ(1u + 1 + sizeof(long) + 1, stream.size());
+  EXPECT_EQ(byte{2 << 1}, stream[0]);
+  EXPECT_EQ(byte{1 << 1 | 1}, stream[1]);
+  long v;
+  memcpy(&v, &stream[2], sizeof(v));
+  EXPECT_EQ(5, v);
+  EXPECT_EQ(byte{1 << 1}, stream.back());
+}
+
+TEST(optStream, nullRunsSpanChunks)
+{
+  const vector<opt_long> column(100000);
+  // a single run with 3-byte varint header
+  EXPECT_EQ(3u, encode(column, 1000).size());
+  EXPECT_EQ(column, decode(encode(column, 1000), 1, 7));
+  EXPECT_TRUE(encode({}, 1).empty());
+}
+
+TEST(optStream, roundTrip)
+{
+  for(double density : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+    const auto column = make_column(5000, density);
+    for(size_t chunk : {1u, 7u, 64u, 5000u}) {
+      const auto stream = encode(column, chunk);
+      EXPECT_EQ(column, decode(stream, stream.size(), column.size())) << density << " " << chunk;
+      EXPECT_EQ(column, decode(stream, 1, 3)) << density << " " << chunk;
+      EXPECT_EQ(column, decode(stream, 13, 1000)) << density << " " << chunk;
+    }
+  }
+}
+
+TEST(optStream, compression)
+{
+  const auto column = make_column(10000, 0.99);
+  EXPECT_LT(encode(column, 4096).size(), column.size() * sizeof(long) / 20);
+}
+
+TEST(optStream, nanPolicy)
+{
+  using opt_double = opt<double, opt_nan_policy<double>>;
+  const vector<opt_double> column{opt_double{1.5}, opt_double{}, opt_double{}, opt_double{-0.0}};
+  opt_stream_writer<double, opt_nan_policy<double>> writer;
+  vector<byte> stream;
+  writer.write(column, stream);
+  writer.flush(stream);
+
+  opt_stream_reader<double, opt_nan_policy<double>> reader;
+  vector<opt_double> out(column.size());
+  span<const byte> in{stream};
+  EXPECT_EQ(column.size(), reader.read(in, out));
+  EXPECT_EQ(1.5, out[0]);
+  EXPECT_FALSE(out[1].has_value());
+  EXPECT_FALSE(out[2].has_value());
+  EXPECT_TRUE(out[3].has_value());
+  EXPECT_TRUE(signbit(*out[3]));
+}
+
+TEST(optStream, malformedHeader)
+{
+  const vector<byte> stream(11, byte{0xFF});
+  opt_stream_reader<long, policy> reader;
+  vector<opt_long> out(1);
+  span<const byte> in{stream};
+  EXPECT_THROW(reader.read(in, out), runtime_error);
+}
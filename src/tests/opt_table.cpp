@@ -0,0 +1,103 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_table.h"
+#include <gtest/gtest.h>
+#include <utility>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  using opt_double = opt<double, opt_nan_policy<double>>;
+
+  enum class color : uint8_t { red, green, blue, count };
+
+  // every modifier may be used in constant expressions
+  constexpr opt_int modified()
+  {
+    opt_int a{1}, b;
+    a = 2;
+    b = a;
+    a.reset();
+    a.swap(b);
+    std::swap(a, b);
+    b = nullopt;
+    a = opt<short, opt_null_value_policy<short, -1>>{short{7}};
+    opt<long, opt_null_value_policy<long, -1>> l{8L};
+    a = std::move(l);
+    *a += 1;
+    return a;
+  }
+
+  constexpr auto retries = make_opt_table<int, opt_null_value_policy<int, -1>, 600>({{429, 5}, {500, 1}, {503, 3}});
+  constexpr auto weights =
+      make_opt_table<double, opt_nan_policy<double>, 4, color>({{color::green, 0.5}, {color::red, 0.0}});
+
+}
+
+TEST(optTable, constexprModifiers)
+{
+  static_assert(modified() == opt_int{9});
+
+  constexpr opt_double d = [] {
+    opt_double o;
+    o = 1.5;
+    o = opt<float, opt_nan_policy<float>>{2.5f};
+    return o;
+  }();
+  static_assert(*d == 2.5);
+
+  using opt_color = opt<color, opt_null_value_policy<color, color::count>>;
+  constexpr opt_color c = [] {
+    opt_color o{color::red};
+    o.reset();
+    o = color::blue;
+    return o;
+  }();
+  static_assert(c == color::blue);
+}
+
+TEST(optTable, makeOptTable)
+{
+  static_assert(retries.size() == 600);
+  static_assert(*retries[429] == 5 && *retries[503] == 3);
+  static_assert(!retries[200].has_value() && !retries[599].has_value());
+
+  static_assert(*weights[static_cast<size_t>(color::red)] == 0.0);
+  static_assert(!weights[static_cast<size_t>(color::blue)].has_value());
+
+  size_t count = 0;
+  for(const auto& o : retries)
+    if(o) ++count;
+  EXPECT_EQ(3u, count);
+  EXPECT_EQ(1, retries[500].value());
+}
+
+TEST(optTable, invalidEntries)
+{
+  using policy = opt_null_value_policy<int, -1>;
+  EXPECT_THROW((make_opt_table<int, policy, 10>({{10, 1}})), out_of_range);
+  EXPECT_THROW((make_opt_table<int, policy, 10>({{1, 1}, {1, 2}})), invalid_argument);
+}
@@ -0,0 +1,149 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opt_vector.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using namespace mp;
+  using namespace std;
+
+  using opt_int_vector = opt_vector<int, opt_null_value_policy<int, -1>>;
+
+  // std::string keeps a pointer to its own SSO buffer so it is not relocatable
+  struct null_string_policy {
+    static string null_value() { return string(1, '\0'); }
+    static bool has_value(const string& s) { return s.size() != 1 || s[0] != '\0'; }
+  };
+  using opt_string_vector = opt_vector<string, null_string_policy>;
+
+  // owns a heap object, moves are counted
+  struct handle {
+    static inline int moves = 0;
+    unique_ptr<int> p;
+
+    explicit handle(int v) : p{v < 0 ? nullptr : make_unique<int>(v)} {}
+    handle(const handle& other) : p{other.p ? make_unique<int>(*other.p) : nullptr} {}
+    handle(handle&& other) noexcept : p{std::move(other.p)} { ++moves; }
+    handle& operator=(const handle& other) { return *this = handle{other}; }
+    handle& operator=(handle&& other) noexcept = default;
+    friend bool operator==(const handle& lhs, const handle& rhs)
+    {
+      return lhs.p && rhs.p ? *lhs.p == *rhs.p : lhs.p == rhs.p;
+    }
+  };
+  struct null_handle_policy {
+    static handle null_value() { return handle{-1}; }
+    static bool has_value(const handle& h) noexcept { return h.p != nullptr; }
+  };
+
+}
+
+template<>
+struct mp::is_trivially_relocatable<handle> : std::true_type {
+};
+
+TEST(optVector, traits)
+{
+  static_assert(opt_int_vector::relocatable);
+  static_assert(!opt_string_vector::relocatable);
+  static_assert(opt_vector<handle, null_handle_policy>::relocatable);
+  static_assert(!is_trivially_copyable_v<opt<handle, null_handle_policy>>);
+}
+
+TEST(optVector, resizeInsertErase)
+{
+  opt_int_vector v(10'000'000);
+  EXPECT_EQ(10'000'000u, v.size());
+  EXPECT_EQ(0u, count_values(span{v}));
+  v.resize(3);
+  v.shrink_to_fit();
+  EXPECT_EQ(3u, v.capacity());
+
+  v[1] = 1;
+  v.push_back(3);
+  v.emplace_back();
+  EXPECT_EQ((opt_int_vector{{}, 1, {}, 3, {}}), v);
+
+  auto it = v.insert(v.begin(), 0);
+  EXPECT_EQ(v.begin(), it);
+  v.insert(v.begin() + 3, v[0]);
+  v.insert(v.end(), 2, 7);
+  EXPECT_EQ((opt_int_vector{0, {}, 1, 0, {}, 3, {}, 7, 7}), v);
+
+  it = v.erase(v.begin() + 1);
+  EXPECT_EQ(1, **it);
+  v.erase(v.begin() + 3, v.end() - 1);
+  EXPECT_EQ((opt_int_vector{0, 1, 0, 7}), v);
+
+  v.resize(6, v[3]);
+  v.pop_back();
+  EXPECT_EQ((opt_int_vector{0, 1, 0, 7, 7}), v);
+
+  opt_int_vector copy = v;
+  v.clear();
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(5u, copy.size());
+  v = std::move(copy);
+  EXPECT_EQ(7, *v.back());
+}
+
+TEST(optVector, notRelocatable)
+{
+  const string long_string(100, 'x');
+  opt_string_vector v;
+  for(int i = 0; i < 100; ++i) v.push_back(to_string(i));
+  v.insert(v.begin(), long_string);
+  v.insert(v.begin() + 50, 3, opt<string, null_string_policy>{});
+  v.erase(v.begin() + 1, v.begin() + 11);
+  ASSERT_EQ(94u, v.size());
+  EXPECT_EQ(long_string, *v[0]);
+  EXPECT_EQ("10", *v[1]);
+  EXPECT_FALSE(v[40].has_value());
+  EXPECT_FALSE(v[42].has_value());
+  EXPECT_EQ("49", *v[43]);
+  EXPECT_EQ("99", *v.back());
+}
+
+TEST(optVector, relocatableOptIn)
+{
+  using opt_handle = opt<handle, null_handle_policy>;
+  opt_vector<handle, null_handle_policy> v;
+  for(int i = 0; i < 100; ++i) v.emplace_back(handle{i});
+  v.resize(200);
+
+  // growth, insert and erase relocate existing elements without calling their move constructors
+  handle::moves = 0;
+  v.reserve(10'000);
+  v.insert(v.begin(), opt_handle{});
+  v.erase(v.begin() + 1, v.begin() + 51);
+  EXPECT_EQ(2, handle::moves);  // the inserted element (through a temporary)
+  ASSERT_EQ(151u, v.size());
+  EXPECT_FALSE(v[0].has_value());
+  EXPECT_EQ(50, *v[1]->p);
+  EXPECT_EQ(99, *v[50]->p);
+  EXPECT_FALSE(v[51].has_value());
+}
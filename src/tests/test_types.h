@@ -0,0 +1,168 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "opt.h"
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace {
+
+  struct my_bool {
+    std::uint8_t value_;
+    my_bool() = default;
+    constexpr my_bool(bool v) noexcept : value_{v} {}
+    explicit constexpr my_bool(std::uint8_t v) noexcept : value_{v} {}
+    constexpr operator bool() const noexcept { return value_; }
+  };
+
+  class weekday {
+  public:
+    using underlying_type = std::int8_t;
+    constexpr explicit weekday(underlying_type v) : value_{v}
+    {
+      if(v < 0 || v > 6) throw std::out_of_range{"weekday value outside of allowed range"};
+    }
+    constexpr weekday& operator=(underlying_type v)
+    {
+      if(v < 0 || v > 6) throw std::out_of_range{"weekday value outside of allowed range"};
+      value_ = v;
+      return *this;
+    }
+    constexpr underlying_type get() const noexcept { return value_; }
+
+  private:
+    underlying_type value_;  // 0 - 6
+  };
+  constexpr bool operator==(weekday lhs, weekday rhs) noexcept { return lhs.get() == rhs.get(); }
+  constexpr bool operator==(weekday::underlying_type lhs, weekday rhs) noexcept { return lhs == rhs.get(); }
+  constexpr bool operator==(weekday lhs, weekday::underlying_type rhs) noexcept { return lhs.get() == rhs; }
+
+  class weekday_mask {
+  public:
+    using underlying_type = std::uint8_t;
+    explicit weekday_mask(std::initializer_list<weekday> days)
+    {
+      for(auto d : days)
+        mask_ |= (1 << d.get());
+    }
+    underlying_type mask() const noexcept { return mask_; }
+
+  private:
+    underlying_type mask_ = 0;
+  };
+
+}
+
+namespace mp {
+
+  template<>
+  struct opt_default_policy<bool> {
+  private:
+    union storage {
+      bool value;
+      std::int8_t null_value = -1;
+      storage() = default;
+      constexpr storage(bool v) noexcept : value{v} {}
+    };
+
+  public:
+    using storage_type = storage;
+    static constexpr storage_type null_value() noexcept { return storage_type{}; }
+    static constexpr bool has_value(storage_type s) noexcept { return s.null_value != -1; }
+  };
+
+  template<>
+  struct opt_default_policy<my_bool> {
+    static my_bool null_value() noexcept { return my_bool{std::uint8_t{255}}; }
+    static bool has_value(my_bool value) noexcept { return value.value_ != 255; }
+  };
+
+  template<>
+  struct opt_default_policy<weekday> {
+    union storage_type {
+      weekday value;
+      weekday::underlying_type null_value = 7;
+
+      constexpr storage_type() noexcept {};
+      constexpr storage_type(weekday v) : value{v} {}
+      constexpr storage_type(weekday::underlying_type v) : value{v} {}
+      storage_type& operator=(weekday v)
+      {
+        value = v;
+        return *this;
+      }
+    };
+
+  public:
+    static constexpr storage_type null_value() noexcept { return storage_type{}; }
+    static constexpr bool has_value(storage_type value) noexcept { return value.null_value != 7; }
+
+    // 7 - 127 are not used by weekday
+    static constexpr std::size_t niche_count = 121;
+    static constexpr storage_type niche_value(std::size_t i) noexcept
+    {
+      storage_type s;
+      s.null_value = static_cast<weekday::underlying_type>(7 + i);
+      return s;
+    }
+    static constexpr std::size_t niche_index(storage_type value) noexcept
+    {
+      return value.null_value >= 7 ? static_cast<std::size_t>(value.null_value - 7) : niche_count;
+    }
+
+    // values 0 - 6 and null 7 fit in 3 bits
+    static constexpr std::size_t packed_bits = 3;
+  };
+
+  template<>
+  struct opt_default_policy<weekday_mask> {
+    union storage_type {
+      weekday_mask value;
+      weekday_mask::underlying_type null_value = 0b1111'1111;
+
+      storage_type() noexcept {};
+      storage_type(weekday_mask v) : value{v} {}
+      explicit storage_type(std::initializer_list<weekday> days) : value{days} {}
+
+      storage_type& operator=(weekday_mask v)
+      {
+        value = v;
+        return *this;
+      }
+    };
+
+  public:
+    static storage_type null_value() noexcept { return storage_type{}; }
+    static bool has_value(storage_type value) noexcept { return value.null_value != 0b1111'1111; }
+  };
+}
+
+namespace {
+
+  template<typename T>
+  struct null_floating {
+    static constexpr T null_value = 0.0f;
+  };
+}
@@ -20,135 +20,17 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
-#include "opt.h"
+#include "test_types.h"
 #include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
 
 namespace {
 
   using namespace mp;
   using namespace std;
 
-  struct my_bool {
-    std::uint8_t value_;
-    my_bool() = default;
-    constexpr my_bool(bool v) noexcept : value_{v} {}
-    explicit constexpr my_bool(std::uint8_t v) noexcept : value_{v} {}
-    constexpr operator bool() const noexcept { return value_; }
-  };
-
-  class weekday {
-  public:
-    using underlying_type = std::int8_t;
-    constexpr explicit weekday(underlying_type v) : value_{v}
-    {
-      if(v < 0 || v > 6) throw std::out_of_range{"weekday value outside of allowed range"};
-    }
-    constexpr weekday& operator=(underlying_type v)
-    {
-      if(v < 0 || v > 6) throw std::out_of_range{"weekday value outside of allowed range"};
-      value_ = v;
-      return *this;
-    }
-    constexpr underlying_type get() const noexcept { return value_; }
-
-  private:
-    underlying_type value_;  // 0 - 6
-  };
-  constexpr bool operator==(weekday lhs, weekday rhs) noexcept { return lhs.get() == rhs.get(); }
-  constexpr bool operator==(weekday::underlying_type lhs, weekday rhs) noexcept { return lhs == rhs.get(); }
-  constexpr bool operator==(weekday lhs, weekday::underlying_type rhs) noexcept { return lhs.get() == rhs; }
-
-  class weekday_mask {
-  public:
-    using underlying_type = std::uint8_t;
-    explicit weekday_mask(std::initializer_list<weekday> days)
-    {
-      for(auto d : days)
-        mask_ |= (1 << d.get());
-    }
-    underlying_type mask() const noexcept { return mask_; }
-
-  private:
-    underlying_type mask_ = 0;
-  };
-
-}
-
-namespace mp {
-
-  template<>
-  struct opt_default_policy<bool> {
-  private:
-    union storage {
-      bool value;
-      std::int8_t null_value = -1;
-      storage() = default;
-      constexpr storage(bool v) noexcept : value{v} {}
-    };
-
-  public:
-    using storage_type = storage;
-    static constexpr storage_type null_value() noexcept { return storage_type{}; }
-    static constexpr bool has_value(storage_type s) noexcept { return s.null_value != -1; }
-  };
-
-  template<>
-  struct opt_default_policy<my_bool> {
-    static my_bool null_value() noexcept { return my_bool{std::uint8_t{255}}; }
-    static bool has_value(my_bool value) noexcept { return value.value_ != 255; }
-  };
-
-  template<>
-  struct opt_default_policy<weekday> {
-    union storage_type {
-      weekday value;
-      weekday::underlying_type null_value = 7;
-
-      constexpr storage_type() noexcept {};
-      constexpr storage_type(weekday v) : value{v} {}
-      constexpr storage_type(weekday::underlying_type v) : value{v} {}
-      storage_type& operator=(weekday v)
-      {
-        value = v;
-        return *this;
-      }
-    };
-
-  public:
-    static constexpr storage_type null_value() noexcept { return storage_type{}; }
-    static constexpr bool has_value(storage_type value) noexcept { return value.null_value != 7; }
-  };
-
-  template<>
-  struct opt_default_policy<weekday_mask> {
-    union storage_type {
-      weekday_mask value;
-      weekday_mask::underlying_type null_value = 0b1111'1111;
-
-      storage_type() noexcept {};
-      storage_type(weekday_mask v) : value{v} {}
-      explicit storage_type(std::initializer_list<weekday> days) : value{days} {}
-
-      storage_type& operator=(weekday_mask v)
-      {
-        value = v;
-        return *this;
-      }
-    };
-
-  public:
-    static storage_type null_value() noexcept { return storage_type{}; }
-    static bool has_value(storage_type value) noexcept { return value.null_value != 0b1111'1111; }
-  };
-}
-
-namespace {
-
-  template<typename T>
-  struct null_floating {
-    static constexpr T null_value = 0.0f;
-  };
-
   template<typename T>
   struct opt_traits;
 
@@ -223,7 +105,8 @@ namespace {
     const typename traits::other_type other_value_2 = traits::other_value_2;
   };
   using test_types = ::testing::Types<opt<bool>, opt<weekday>, opt<long, opt_null_value_policy<long, -1>>,
-                                      opt<double, opt_null_type_policy<double, null_floating<double>>>>;
+                                      opt<double, opt_null_type_policy<double, null_floating<double>>>,
+                                      opt<double, opt_nan_policy<double>>>;
   TYPED_TEST_CASE(optTyped, test_types);
 }
 
@@ -861,6 +744,19 @@ TYPED_TEST(optTyped, swapNotEmptyWithNotEmpty)
   EXPECT_EQ(this->value_1, o2.value_or(this->value_2));
 }
 
+TYPED_TEST(optTyped, typeTraits)
+{
+  using opt_type = typename TestFixture::type;
+  using storage_type = typename opt_type::traits_type::storage_type;
+  static_assert(is_trivially_copyable_v<opt_type> == is_trivially_copyable_v<storage_type>);
+  static_assert(is_trivially_destructible_v<opt_type> == is_trivially_destructible_v<storage_type>);
+  static_assert(is_standard_layout_v<opt_type> == is_standard_layout_v<storage_type>);
+  static_assert(is_trivially_relocatable_v<opt_type> == is_trivially_relocatable_v<storage_type>);
+  static_assert(is_trivially_copyable_v<opt_type> && is_trivially_relocatable_v<opt_type>);
+  static_assert(is_nothrow_move_constructible_v<opt_type> && is_nothrow_move_assignable_v<opt_type>);
+  static_assert(sizeof(opt_type) == sizeof(storage_type) && alignof(opt_type) == alignof(storage_type));
+}
+
 TEST(opt, constructorInitializerList)
 {
   using wd = weekday;
@@ -1141,3 +1037,327 @@ TEST(optCompare, nulloptOptNotEmpty)
   EXPECT_TRUE(nullopt <= i);
   EXPECT_FALSE(nullopt >= i);
 }
+
+TEST(optCompare, threeWay)
+{
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  EXPECT_TRUE((opt_int{1} <=> opt_int{2}) < 0);
+  EXPECT_TRUE((opt_int{2} <=> opt_int{2}) == 0);
+  EXPECT_TRUE((opt_int{} <=> opt_int{}) == 0);
+  EXPECT_TRUE((opt_int{} <=> opt_int{numeric_limits<int>::min()}) < 0);
+  EXPECT_TRUE((opt_int{3} <=> nullopt) > 0);
+  EXPECT_TRUE((opt_int{} <=> nullopt) == 0);
+  EXPECT_TRUE((opt_int{3} <=> 4) < 0);
+  EXPECT_TRUE((opt_int{} <=> 4) < 0);
+  EXPECT_TRUE((4 <=> opt_int{}) > 0);
+}
+
+struct nulls_last_policy {
+  static constexpr opt_null_order null_order = opt_null_order::last;
+  static constexpr int null_value() noexcept { return -1; }
+};
+
+TEST(optCompare, nullsLast)
+{
+  using opt_int = opt<int, nulls_last_policy>;
+  static_assert(opt_int::traits_type::null_order == opt_null_order::last);
+  opt_int i1{1}, i2;
+  EXPECT_TRUE(i1 < i2);
+  EXPECT_FALSE(i1 > i2);
+  EXPECT_TRUE(i2 >= i1);
+  EXPECT_TRUE((i2 <=> i1) > 0);
+  EXPECT_TRUE(i1 < nullopt);
+  EXPECT_FALSE(nullopt < i1);
+  EXPECT_TRUE(nullopt >= i1);
+  EXPECT_FALSE(i2 < nullopt);
+  EXPECT_TRUE(i2 <= nullopt);
+  EXPECT_TRUE((nullopt <=> i1) > 0);
+  EXPECT_TRUE(i2 > 1);
+  EXPECT_TRUE(1 < i2);
+  EXPECT_FALSE(i2 <= 1);
+  EXPECT_TRUE((i2 <=> 1) > 0);
+}
+
+TEST(optCompare, nanPolicy)
+{
+  using opt_double = opt<double, opt_nan_policy<double>>;
+  const opt_double empty, one{1.0}, two{2.0}, nan{NAN};
+  EXPECT_TRUE(empty < one);
+  EXPECT_TRUE(one < two);
+  EXPECT_FALSE(two < one);
+  EXPECT_FALSE(empty < empty);
+  EXPECT_FALSE(one < empty);
+  // NaN values are unordered but the empty object is still less than them
+  EXPECT_TRUE(empty < nan);
+  EXPECT_FALSE(nan < one);
+  EXPECT_FALSE(one < nan);
+  constexpr opt_branchless_less less;
+  EXPECT_TRUE(less(empty, nan));
+  EXPECT_FALSE(less(nan, empty));
+  EXPECT_FALSE(less(nan, one));
+  EXPECT_FALSE(less(empty, empty));
+  EXPECT_TRUE(less(one, two));
+  EXPECT_TRUE((empty <=> one) < 0);
+  EXPECT_TRUE((nan <=> one) == partial_ordering::unordered);
+}
+
+// operator<, operator<=> and opt_branchless_less give the same results as comparing emptiness first
+template<typename Opt>
+void expect_lexicographic_order(const vector<Opt>& values, bool nulls_first)
+{
+  for(const auto& a : values)
+    for(const auto& b : values) {
+      const int ka = a ? 1 : (nulls_first ? 0 : 2), kb = b ? 1 : (nulls_first ? 0 : 2);
+      const bool less = ka != kb ? ka < kb : (a && *a < *b);
+      EXPECT_EQ(less, a < b);
+      EXPECT_EQ(less, opt_branchless_less{}(a, b));
+      EXPECT_EQ(less, (a <=> b) < 0);
+      EXPECT_EQ(!less && !(b < a), (a <=> b) == 0);
+    }
+}
+
+TEST(optCompare, branchlessOrder)
+{
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  constexpr int min = numeric_limits<int>::min(), max = numeric_limits<int>::max();
+  expect_lexicographic_order<opt_int>({opt_int{}, opt_int{min}, opt_int{-2}, opt_int{0}, opt_int{1}, opt_int{max}},
+                                      true);
+  expect_lexicographic_order<opt<int, nulls_last_policy>>({{}, {min}, {-2}, {0}, {max}}, false);
+  using uchar = unsigned char;
+  using opt_uchar = opt<uchar, opt_null_value_policy<uchar, 7>>;
+  expect_lexicographic_order<opt_uchar>({opt_uchar{}, opt_uchar{uchar{0}}, opt_uchar{uchar{6}}, opt_uchar{uchar{8}},
+                                         opt_uchar{uchar{255}}},
+                                        true);
+}
+
+TEST(optHash, enabled)
+{
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  static_assert(is_default_constructible_v<hash<opt_int>>);
+  static_assert(is_default_constructible_v<hash<opt<bool>>>);
+  static_assert(!is_default_constructible_v<hash<opt<weekday>>>);
+  static_assert(!is_copy_constructible_v<hash<opt<weekday>>>);
+}
+
+TEST(optHash, value)
+{
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  EXPECT_EQ(hash<int>{}(42), hash<opt_int>{}(opt_int{42}));
+  EXPECT_EQ(hash<bool>{}(false), hash<opt<bool>>{}(opt<bool>{false}));
+  EXPECT_EQ(hash<opt_int>{}(opt_int{}), hash<opt<bool>>{}(opt<bool>{}));
+  EXPECT_NE(hash<opt_int>{}(opt_int{}), hash<opt_int>{}(opt_int{0}));
+}
+
+TEST(optHash, unorderedSet)
+{
+  using opt_int = opt<int, opt_null_value_policy<int, -1>>;
+  unordered_set<opt_int> s{opt_int{1}, opt_int{}, opt_int{2}, opt_int{1}, opt_int{}};
+  EXPECT_EQ(3u, s.size());
+  EXPECT_EQ(1u, s.count(opt_int{}));
+  EXPECT_EQ(1u, s.count(opt_int{2}));
+  EXPECT_EQ(0u, s.count(opt_int{3}));
+}
+
+TEST(optNanPolicy, nullValue)
+{
+  using opt_double = opt<double, opt_nan_policy<double>>;
+  using opt_float = opt<float, opt_nan_policy<float>>;
+  static_assert(sizeof(opt_double) == sizeof(double));
+  static_assert(sizeof(opt_float) == sizeof(float));
+  static_assert(!opt_double{}.has_value());
+  static_assert(opt_double{0.0}.has_value());
+  static_assert(opt_float{-0.0f}.has_value());
+  static_assert(opt_policy_traits<double, opt_nan_policy<double>>::bitwise_null);
+
+  EXPECT_TRUE(isnan(opt_nan_policy<double>::null_value()));
+  EXPECT_TRUE(isnan(opt_nan_policy<float>::null_value()));
+
+  // other NaNs are valid values
+  EXPECT_TRUE(opt_double{numeric_limits<double>::quiet_NaN()}.has_value());
+  EXPECT_TRUE(opt_double{-numeric_limits<double>::quiet_NaN()}.has_value());
+  EXPECT_TRUE(opt_double{numeric_limits<double>::infinity()}.has_value());
+  EXPECT_TRUE(opt_float{numeric_limits<float>::quiet_NaN()}.has_value());
+  const double zero = 0.0;
+  EXPECT_TRUE(opt_double{zero / zero}.has_value());
+
+  opt_double o{1.5};
+  EXPECT_EQ(1.5, *o);
+  o.reset();
+  EXPECT_FALSE(o);
+  EXPECT_EQ(2.5, o.value_or(2.5));
+}
+
+TEST(optNiche, traits)
+{
+  static_assert(opt_policy_traits<long, opt_null_value_policy<long, -1>>::niche_count == 1);
+  static_assert(opt_policy_traits<weekday, opt_default_policy<weekday>>::niche_count == 121);
+  static_assert(opt_policy_traits<opt<weekday>, opt_default_policy<opt<weekday>>>::niche_count == 120);
+  static_assert(opt_policy_traits<float, opt_nan_policy<float>>::niche_count == 0x3F'FFFF);
+
+  using traits = opt_policy_traits<long, opt_null_value_policy<long, -1>>;
+  EXPECT_EQ(-1, traits::niche_value(0));
+  EXPECT_EQ(0u, traits::niche_index(-1));
+  EXPECT_EQ(1u, traits::niche_index(5));
+
+  using nan_traits = opt_policy_traits<double, opt_nan_policy<double>>;
+  EXPECT_EQ(0u, nan_traits::niche_index(nan_traits::null_value()));
+  EXPECT_EQ(12345u, nan_traits::niche_index(nan_traits::niche_value(12345)));
+  EXPECT_EQ(nan_traits::niche_count, nan_traits::niche_index(1.0));
+  EXPECT_EQ(nan_traits::niche_count, nan_traits::niche_index(numeric_limits<double>::quiet_NaN()));
+}
+
+TEST(optNiche, nestedWeekday)
+{
+  using opt_weekday = opt<weekday>;
+  using opt_opt_weekday = opt<opt_weekday>;
+  static_assert(sizeof(opt_opt_weekday) == sizeof(weekday));
+  static_assert(sizeof(opt<opt_opt_weekday>) == sizeof(weekday));
+
+  const auto raw = [](const auto& o) {
+    weekday::underlying_type v;
+    memcpy(&v, &o, sizeof(v));
+    return v;
+  };
+
+  opt_opt_weekday empty;
+  EXPECT_FALSE(empty.has_value());
+  EXPECT_EQ(8, raw(empty));
+
+  opt_opt_weekday inner_empty{opt_weekday{}};
+  EXPECT_TRUE(inner_empty.has_value());
+  EXPECT_FALSE(inner_empty->has_value());
+  EXPECT_EQ(7, raw(inner_empty));
+
+  opt_opt_weekday value{opt_weekday{weekday{3}}};
+  EXPECT_TRUE(value.has_value());
+  EXPECT_TRUE(value->has_value());
+  EXPECT_EQ(3, (*value)->get());
+  EXPECT_EQ(3, raw(value));
+
+  value.reset();
+  EXPECT_FALSE(value.has_value());
+  value = opt_weekday{weekday{5}};
+  EXPECT_EQ(5, (**value).get());
+  value->reset();
+  EXPECT_TRUE(value.has_value());
+  EXPECT_FALSE(value->has_value());
+
+  opt<opt_opt_weekday> triple{inner_empty};
+  EXPECT_TRUE(triple.has_value());
+  EXPECT_TRUE(triple->has_value());
+  EXPECT_FALSE((*triple)->has_value());
+  triple = opt_opt_weekday{};
+  EXPECT_TRUE(triple.has_value());
+  EXPECT_FALSE(triple->has_value());
+  EXPECT_EQ(8, raw(triple));
+  triple.reset();
+  EXPECT_FALSE(triple.has_value());
+  EXPECT_EQ(9, raw(triple));
+}
+
+TEST(optNiche, nestedNan)
+{
+  using opt_double = opt<double, opt_nan_policy<double>>;
+  static_assert(sizeof(opt<opt_double>) == sizeof(double));
+  opt<opt_double> o;
+  EXPECT_FALSE(o.has_value());
+  o = opt_double{};
+  EXPECT_TRUE(o.has_value());
+  EXPECT_FALSE(o->has_value());
+  o = opt_double{numeric_limits<double>::quiet_NaN()};
+  EXPECT_TRUE(o->has_value());
+  EXPECT_TRUE(isnan(**o));
+}
+
+TEST(optNiche, rangePolicy)
+{
+  enum class color : uint8_t { red, green, blue };
+  using policy = opt_niche_range_policy<color, color{3}, color{255}>;
+  using opt_color = opt<color, policy>;
+  static_assert(opt_policy_traits<color, policy>::niche_count == 253);
+  static_assert(sizeof(opt<opt<opt_color>>) == sizeof(color));
+  static_assert(!opt_color{}.has_value());
+  static_assert(opt_color{color::blue}.has_value());
+  static_assert(policy::niche_index(color{10}) == 7);
+  static_assert(policy::niche_index(color::red) == 253);
+
+  opt<opt_color> o{opt_color{color::green}};
+  EXPECT_EQ(color::green, **o);
+  o = opt_color{};
+  EXPECT_TRUE(o.has_value());
+  EXPECT_FALSE(o->has_value());
+  o.reset();
+  EXPECT_FALSE(o.has_value());
+  EXPECT_TRUE(o == nullopt);
+}
+
+TEST(optMonadic, transform)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  constexpr auto twice = [](long v) noexcept { return 2 * v; };
+  constexpr auto is_odd = [](long v) noexcept { return v % 2 != 0; };
+
+  // bool has a default policy
+  static_assert(is_same_v<decltype(opt_long{}.transform(is_odd)), opt<bool>>);
+  static_assert(is_same_v<decltype(opt_long{}.transform(twice)), optional<long>>);
+  static_assert(noexcept(opt_long{}.transform(is_odd)));
+  static_assert(!noexcept(opt_long{}.transform([](long v) { return to_string(v); })));
+  static_assert(opt_long{3}.transform(twice) == 6);
+  static_assert(!opt_long{}.transform(twice).has_value());
+
+  opt_long o{21};
+  EXPECT_EQ(42, o.transform(twice).value_or(0));
+  EXPECT_EQ("21", o.transform([](long v) { return to_string(v); }));
+  EXPECT_EQ(true, o.transform(is_odd));
+  EXPECT_EQ(false, o.and_then([&](long v) { return opt_long{twice(v)}; }).transform(is_odd));
+  o.reset();
+  EXPECT_EQ(0, o.transform(twice).value_or(0));
+
+  opt<weekday> w{weekday{3}};
+  EXPECT_EQ(weekday{4}, w.transform([](weekday d) { return weekday{static_cast<weekday::underlying_type>(d.get() + 1)}; }));
+  EXPECT_EQ(weekday{3}, move(w).transform([](weekday&& d) { return move(d); }));
+
+  // the null value returned by the function leaves the result empty
+  const auto m = opt_long{21}.transform([](long v) { return my_bool{static_cast<uint8_t>(v == 21 ? 255 : 1)}; });
+  static_assert(is_same_v<decltype(m), const opt<my_bool>>);
+  EXPECT_FALSE(m.has_value());
+}
+
+TEST(optMonadic, andThen)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  constexpr auto checked_sqrt = [](long v) { return v >= 0 ? opt_long{static_cast<long>(sqrt(v))} : opt_long{}; };
+  EXPECT_EQ(3, opt_long{9}.and_then(checked_sqrt));
+  EXPECT_FALSE(opt_long{}.and_then(checked_sqrt).has_value());
+  EXPECT_EQ(optional<string>{"9"}, opt_long{9}.and_then([](long v) { return optional<string>{to_string(v)}; }));
+  EXPECT_FALSE(opt_long{}.and_then([](long v) { return optional<string>{to_string(v)}; }).has_value());
+}
+
+TEST(optMonadic, orElse)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  int calls = 0;
+  auto fallback = [&] {
+    ++calls;
+    return opt_long{7};
+  };
+  EXPECT_EQ(1, opt_long{1}.or_else(fallback));
+  EXPECT_EQ(0, calls);
+  EXPECT_EQ(7, opt_long{}.or_else(fallback));
+  EXPECT_EQ(1, calls);
+  const opt_long empty;
+  EXPECT_FALSE(empty.or_else([] { return opt_long{}; }).has_value());
+  static_assert(noexcept(opt_long{}.or_else([]() noexcept { return opt_long{}; })));
+}
+
+TEST(optMonadic, valueOrElse)
+{
+  using opt_long = opt<long, opt_null_value_policy<long, -1>>;
+  int calls = 0;
+  auto fallback = [&] { return ++calls; };
+  EXPECT_EQ(5, opt_long{5}.value_or_else(fallback));
+  EXPECT_EQ(0, calls);
+  EXPECT_EQ(1, opt_long{}.value_or_else(fallback));
+  static_assert(opt_long{}.value_or_else([] { return 3; }) == 3);
+  static_assert(noexcept(opt_long{}.value_or_else([]() noexcept { return 3; })));
+}